@@ -0,0 +1,112 @@
+/* src/arch/x86_64/acpi.c - Tables ACPI (RSDP/RSDT/XSDT) */
+#include "acpi.h"
+#include "../../kernel/klog.h"
+#include "../../mm/vmm.h"
+#include "../../include/string.h"
+
+/* RSDT (entrées 32 bits) ou XSDT (entrées 64 bits) ; NULL avant acpi_init */
+static const acpi_sdt_header_t *g_root = NULL;
+static bool g_root_is_xsdt = false;
+
+/**
+ * Rend une zone physique lisible via le HHDM. Limine ne mappe que la RAM :
+ * les tables placées en mémoire réservée sont mappées page par page.
+ */
+static const void *acpi_map(uint64_t phys, uint64_t size)
+{
+    uint64_t end = PAGE_ALIGN_UP(phys + size);
+
+    for (uint64_t page = PAGE_ALIGN_DOWN(phys); page < end; page += PAGE_SIZE) {
+        uint64_t virt = (uint64_t)vmm_phys_to_virt(page);
+        if (!vmm_is_mapped(virt)) {
+            vmm_map_page(page, virt, PAGE_PRESENT);
+        }
+    }
+
+    return vmm_phys_to_virt(phys);
+}
+
+static bool acpi_checksum_ok(const void *data, uint32_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint8_t sum = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+/**
+ * Mappe une table entière et vérifie son checksum.
+ */
+static const acpi_sdt_header_t *acpi_map_table(uint64_t phys)
+{
+    const acpi_sdt_header_t *header = acpi_map(phys, sizeof(acpi_sdt_header_t));
+    if (header->length < sizeof(acpi_sdt_header_t)) {
+        return NULL;
+    }
+
+    header = acpi_map(phys, header->length);
+    if (!acpi_checksum_ok(header, header->length)) {
+        return NULL;
+    }
+    return header;
+}
+
+int acpi_init(uint64_t rsdp_phys)
+{
+    const acpi_rsdp_t *rsdp = acpi_map(rsdp_phys, sizeof(acpi_rsdp_t));
+
+    /* Le checksum ACPI 1.0 couvre les 20 premiers octets */
+    if (memcmp(rsdp->signature, "RSD PTR ", 8) != 0 || !acpi_checksum_ok(rsdp, 20)) {
+        KLOG_ERROR("ACPI", "Invalid RSDP");
+        return -1;
+    }
+
+    if (rsdp->revision >= 2 && rsdp->xsdt_address != 0 &&
+        acpi_checksum_ok(rsdp, rsdp->length)) {
+        g_root = acpi_map_table(rsdp->xsdt_address);
+        g_root_is_xsdt = (g_root != NULL);
+    }
+    if (g_root == NULL) {
+        g_root = acpi_map_table(rsdp->rsdt_address);
+    }
+
+    if (g_root == NULL) {
+        KLOG_ERROR("ACPI", "Invalid RSDT/XSDT");
+        return -1;
+    }
+
+    KLOG_INFO("ACPI", g_root_is_xsdt ? "Using XSDT" : "Using RSDT");
+    return 0;
+}
+
+const acpi_sdt_header_t *acpi_find_table(const char *signature)
+{
+    if (g_root == NULL) {
+        return NULL;
+    }
+
+    uint32_t entry_size = g_root_is_xsdt ? 8 : 4;
+    uint32_t count = (g_root->length - sizeof(acpi_sdt_header_t)) / entry_size;
+    const uint8_t *entries = (const uint8_t *)g_root + sizeof(acpi_sdt_header_t);
+
+    for (uint32_t i = 0; i < count; i++) {
+        /* Entrées non alignées dans la XSDT : copie octet par octet */
+        uint64_t phys = 0;
+        memcpy(&phys, entries + i * entry_size, entry_size);
+
+        const acpi_sdt_header_t *header = acpi_map(phys, sizeof(acpi_sdt_header_t));
+        if (memcmp(header->signature, signature, 4) != 0) {
+            continue;
+        }
+
+        header = acpi_map_table(phys);
+        if (header != NULL) {
+            return header;
+        }
+    }
+
+    return NULL;
+}
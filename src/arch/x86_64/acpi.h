@@ -0,0 +1,81 @@
+/* src/arch/x86_64/acpi.h - Tables ACPI (RSDP/RSDT/XSDT) */
+#ifndef X86_64_ACPI_H
+#define X86_64_ACPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================================
+ * Structures des tables
+ * ======================================== */
+
+/* RSDP (ACPI 1.0 : jusqu'à rsdt_address ; ACPI 2.0+ : structure complète) */
+typedef struct __attribute__((packed)) {
+    char     signature[8];      /* "RSD PTR " */
+    uint8_t  checksum;
+    char     oem_id[6];
+    uint8_t  revision;          /* 0 = ACPI 1.0, 2 = ACPI 2.0+ */
+    uint32_t rsdt_address;
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t  extended_checksum;
+    uint8_t  reserved[3];
+} acpi_rsdp_t;
+
+/* En-tête commun à toutes les tables (SDT) */
+typedef struct __attribute__((packed)) {
+    char     signature[4];
+    uint32_t length;            /* Table entière, en-tête compris */
+    uint8_t  revision;
+    uint8_t  checksum;
+    char     oem_id[6];
+    char     oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} acpi_sdt_header_t;
+
+/* Generic Address Structure */
+typedef struct __attribute__((packed)) {
+    uint8_t  space_id;          /* 0 = mémoire, 1 = ports I/O */
+    uint8_t  bit_width;
+    uint8_t  bit_offset;
+    uint8_t  access_size;
+    uint64_t address;
+} acpi_gas_t;
+
+#define ACPI_SPACE_MEMORY   0
+
+/* Table "HPET" */
+typedef struct __attribute__((packed)) {
+    acpi_sdt_header_t header;
+    uint32_t   event_timer_block_id;
+    acpi_gas_t address;         /* Base des registres du HPET */
+    uint8_t    hpet_number;
+    uint16_t   min_tick;
+    uint8_t    page_protection;
+} acpi_hpet_t;
+
+/* ========================================
+ * Fonctions
+ * ======================================== */
+
+/**
+ * Valide le RSDP fourni par Limine et retient la RSDT/XSDT.
+ * Les tables sont lues via le HHDM ; les pages absentes (mémoire
+ * réservée par le firmware) y sont mappées en lecture seule.
+ * Nécessite vmm_init().
+ *
+ * @param rsdp_phys Adresse physique du RSDP
+ * @return 0 si succès, -1 si RSDP ou RSDT/XSDT invalide
+ */
+int acpi_init(uint64_t rsdp_phys);
+
+/**
+ * Cherche une table par sa signature (ex: "HPET", "APIC").
+ *
+ * @return En-tête de la table (checksum vérifié), NULL si absente
+ */
+const acpi_sdt_header_t *acpi_find_table(const char *signature);
+
+#endif /* X86_64_ACPI_H */
@@ -1,11 +1,19 @@
 /* src/arch/x86_64/cpu.c - CPU initialization for x86-64 */
 #include "cpu.h"
 #include "gdt.h"
+#include "io.h"
 #include "../../kernel/klog.h"
 
 /* External syscall entry point (defined in interrupts.s) */
 extern void syscall_entry(void);
 
+/* CR4.PCIDE actif : CR3 porte un PCID (voir vmm_get_switch_cr3) */
+static bool pcid_enabled = false;
+
+/* Fréquence du TSC (0 = non calibré) */
+static uint64_t tsc_hz = 0;
+static bool tsc_invariant = false;
+
 /**
  * Initialize CPU-specific features for x86-64.
  */
@@ -16,8 +24,30 @@ void cpu_init(void)
     efer |= EFER_NXE;
     wrmsr(MSR_EFER, efer);
     
+    /* Write Protect : le kernel doit aussi fauter sur les pages copy-on-write */
+    write_cr0(read_cr0() | CR0_WP);
+    
+    /* PCID : les changements d'espace d'adressage ne vident plus tout le TLB.
+     * CR4.PCIDE ne peut être activé que si CR3[11:0] == 0. */
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (ecx & CPUID_1_ECX_PCID) {
+        uint64_t cr3 = read_cr3();
+        if (cr3 & CR3_PCID_MASK) {
+            write_cr3(cr3 & ~CR3_PCID_MASK);
+        }
+        write_cr4(read_cr4() | CR4_PCIDE);
+        pcid_enabled = true;
+    }
+    
     KLOG_INFO("CPU", "x86-64 CPU initialized");
     KLOG_INFO_HEX("CPU", "EFER: ", efer);
+    KLOG_INFO("CPU", pcid_enabled ? "PCID enabled" : "PCID not supported");
+}
+
+bool cpu_pcid_enabled(void)
+{
+    return pcid_enabled;
 }
 
 /**
@@ -127,3 +157,76 @@ void syscall_init_msr(void)
     KLOG_INFO_HEX("CPU", "STAR: ", star);
     KLOG_INFO_HEX("CPU", "LSTAR: ", (uint64_t)syscall_entry);
 }
+
+/**
+ * Mesure les cycles TSC écoulés pendant TSC_CALIBRATE_PIT_COUNT périodes du
+ * PIT (canal 2, mode 0, sortie lue sur le port 0x61). Le canal 0 n'est pas
+ * touché : le tick continue.
+ */
+static uint64_t tsc_measure_pit(void)
+{
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) :: "memory");
+
+    /* Gate du canal 2 active, haut-parleur coupé */
+    uint8_t port61 = inb(0x61);
+    outb(0x61, (port61 & ~0x02) | 0x01);
+
+    /* Canal 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    outb(0x43, 0xB0);
+    outb(0x42, TSC_CALIBRATE_PIT_COUNT & 0xFF);
+    outb(0x42, (TSC_CALIBRATE_PIT_COUNT >> 8) & 0xFF);
+
+    uint64_t start = rdtsc();
+    uint32_t guard = 0;
+    while (!(inb(0x61) & 0x20) && ++guard < 10000000) {
+        __asm__ volatile("pause");
+    }
+    uint64_t end = rdtsc();
+
+    outb(0x61, port61);
+    __asm__ volatile("push %0; popfq" :: "r"(flags) : "memory", "cc");
+
+    if (guard >= 10000000) {
+        return 0;   /* OUT2 ne monte jamais (pas de PIT) */
+    }
+    return end - start;
+}
+
+int cpu_tsc_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_1_EDX_TSC)) {
+        KLOG_INFO("CPU", "No TSC");
+        return -1;
+    }
+
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000007) {
+        cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        tsc_invariant = (edx & CPUID_APM_EDX_INVARIANT_TSC) != 0;
+    }
+
+    uint64_t cycles = tsc_measure_pit();
+    if (cycles == 0) {
+        KLOG_ERROR("CPU", "TSC calibration failed");
+        return -1;
+    }
+
+    tsc_hz = cycles * TSC_CALIBRATE_PIT_HZ / TSC_CALIBRATE_PIT_COUNT;
+
+    KLOG_INFO_DEC("CPU", "TSC frequency (kHz): ", (uint32_t)(tsc_hz / 1000));
+    KLOG_INFO("CPU", tsc_invariant ? "TSC is invariant" : "TSC is not invariant");
+    return 0;
+}
+
+uint64_t cpu_tsc_hz(void)
+{
+    return tsc_hz;
+}
+
+bool cpu_tsc_invariant(void)
+{
+    return tsc_invariant;
+}
@@ -3,6 +3,7 @@
 #define X86_64_CPU_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /* ========================================
  * Model Specific Registers (MSRs)
@@ -21,6 +22,29 @@
 #define EFER_LMA            (1 << 10)   /* Long Mode Active */
 #define EFER_NXE            (1 << 11)   /* No-Execute Enable */
 
+/* CR0 bits */
+#define CR0_WP              (1 << 16)   /* Write Protect (ring 0 respecte les pages RO) */
+
+/* CR4 bits */
+#define CR4_PCIDE           (1 << 17)   /* Process-Context Identifiers Enable */
+
+/* CR3 avec PCID : bits 11:0 = PCID, bit 63 = ne pas vider le TLB du PCID */
+#define CR3_PCID_MASK       0xFFFULL
+#define CR3_NOFLUSH         (1ULL << 63)
+
+/* CPUID.01h:ECX */
+#define CPUID_1_ECX_PCID    (1 << 17)
+
+/* CPUID.01h:EDX */
+#define CPUID_1_EDX_TSC     (1 << 4)
+
+/* CPUID.80000007h:EDX (Advanced Power Management) */
+#define CPUID_APM_EDX_INVARIANT_TSC (1 << 8)
+
+/* Calibration du TSC : canal 2 du PIT en mode 0, ~50 ms */
+#define TSC_CALIBRATE_PIT_HZ    1193182
+#define TSC_CALIBRATE_PIT_COUNT 59659
+
 /* FS/GS Base MSRs */
 #define MSR_FS_BASE         0xC0000100
 #define MSR_GS_BASE         0xC0000101
@@ -168,6 +192,20 @@ static inline void cpuid_ext(uint32_t leaf, uint32_t subleaf,
                      : "a"(leaf), "c"(subleaf));
 }
 
+/* ========================================
+ * Time Stamp Counter
+ * ======================================== */
+
+/**
+ * Read the Time Stamp Counter.
+ */
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
 /* ========================================
  * Segment Registers
  * ======================================== */
@@ -251,9 +289,31 @@ static inline void load_ss(uint16_t sel)
  */
 void cpu_init(void);
 
+/**
+ * Return true if CR4.PCIDE was enabled by cpu_init().
+ */
+bool cpu_pcid_enabled(void);
+
 /**
  * Initialize SYSCALL/SYSRET mechanism.
  */
 void syscall_init_msr(void);
 
+/**
+ * Detect the TSC and calibrate its frequency against PIT channel 2.
+ *
+ * @return 0 on success, -1 if there is no TSC or calibration failed
+ */
+int cpu_tsc_init(void);
+
+/**
+ * TSC frequency in Hz (0 before cpu_tsc_init succeeded).
+ */
+uint64_t cpu_tsc_hz(void);
+
+/**
+ * Return true if the TSC is invariant (constant rate across P/C-states).
+ */
+bool cpu_tsc_invariant(void);
+
 #endif /* X86_64_CPU_H */
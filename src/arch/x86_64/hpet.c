@@ -0,0 +1,109 @@
+/* src/arch/x86_64/hpet.c - High Precision Event Timer for x86-64 */
+#include "hpet.h"
+#include "acpi.h"
+#include "../../kernel/klog.h"
+#include "../../kernel/mmio/mmio.h"
+
+/* Registres du HPET (NULL tant que hpet_init n'a pas réussi) */
+static mmio_addr_t hpet_base = NULL;
+
+/* Fréquence du compteur principal (Hz) */
+static uint64_t hpet_hz = 0;
+
+static inline uint64_t hpet_read(uint32_t reg)
+{
+    /* Accès 64 bits unique : le compteur ne peut pas être lu déchiré */
+    return *(volatile uint64_t *)MMIO_REG(hpet_base, reg);
+}
+
+static inline void hpet_write(uint32_t reg, uint64_t value)
+{
+    *(volatile uint64_t *)MMIO_REG(hpet_base, reg) = value;
+}
+
+int hpet_init(void)
+{
+    const acpi_hpet_t *table = (const acpi_hpet_t *)acpi_find_table("HPET");
+    if (table == NULL) {
+        KLOG_INFO("HPET", "No HPET table");
+        return -1;
+    }
+
+    if (table->address.space_id != ACPI_SPACE_MEMORY) {
+        KLOG_ERROR("HPET", "HPET registers not memory mapped");
+        return -1;
+    }
+
+    hpet_base = ioremap(table->address.address, HPET_MMIO_SIZE);
+    if (hpet_base == NULL) {
+        KLOG_ERROR("HPET", "Failed to map HPET registers");
+        return -1;
+    }
+
+    uint64_t cap = hpet_read(HPET_REG_CAP);
+    uint64_t period = cap >> HPET_CAP_PERIOD_SHIFT;
+
+    /* Un compteur 32 bits reboucle en quelques minutes : inutilisable
+     * comme horloge monotone */
+    if (period == 0 || period > HPET_MAX_PERIOD_FS || !(cap & HPET_CAP_COUNT_64)) {
+        KLOG_ERROR("HPET", "Unusable HPET counter");
+        iounmap(hpet_base, HPET_MMIO_SIZE);
+        hpet_base = NULL;
+        return -1;
+    }
+    hpet_hz = HPET_FS_PER_SECOND / period;
+
+    /* Comparateurs muets, puis compteur remis à zéro et démarré */
+    uint32_t timers = HPET_CAP_NUM_TIMERS(cap);
+    hpet_write(HPET_REG_CONFIG, 0);
+    for (uint32_t i = 0; i < timers; i++) {
+        uint64_t config = hpet_read(HPET_REG_TIMER_CONFIG(i));
+        hpet_write(HPET_REG_TIMER_CONFIG(i), config & ~(uint64_t)HPET_TN_INT_ENABLE);
+    }
+    hpet_write(HPET_REG_COUNTER, 0);
+    hpet_write(HPET_REG_CONFIG, HPET_CFG_ENABLE);
+
+    KLOG_INFO_DEC("HPET", "HPET enabled, frequency (kHz): ", (uint32_t)(hpet_hz / 1000));
+    return 0;
+}
+
+bool hpet_present(void)
+{
+    return hpet_base != NULL;
+}
+
+uint64_t hpet_frequency(void)
+{
+    return hpet_hz;
+}
+
+uint64_t hpet_read_counter(void)
+{
+    return hpet_read(HPET_REG_COUNTER);
+}
+
+int hpet_oneshot_init(void)
+{
+    if (hpet_base == NULL) {
+        return -1;
+    }
+
+    uint64_t config = hpet_read(HPET_REG_TIMER_CONFIG(0));
+    if (!(hpet_read(HPET_REG_CAP) & HPET_CAP_LEGACY_ROUTE) || !(config & HPET_TN_SIZE_64)) {
+        KLOG_INFO("HPET", "Comparator 0 cannot replace the PIT");
+        return -1;
+    }
+
+    /* Front (edge), non périodique, 64 bits ; échéance repoussée au plus loin */
+    config &= ~(uint64_t)(HPET_TN_PERIODIC | HPET_TN_32BIT_MODE | HPET_TN_LEVEL);
+    hpet_write(HPET_REG_TIMER_CMP(0), UINT64_MAX);
+    hpet_write(HPET_REG_TIMER_CONFIG(0), config | HPET_TN_INT_ENABLE);
+
+    hpet_write(HPET_REG_CONFIG, HPET_CFG_ENABLE | HPET_CFG_LEGACY_ROUTE);
+    return 0;
+}
+
+void hpet_oneshot_arm(uint64_t deadline)
+{
+    hpet_write(HPET_REG_TIMER_CMP(0), deadline);
+}
@@ -0,0 +1,87 @@
+/* src/arch/x86_64/hpet.h - High Precision Event Timer for x86-64 */
+#ifndef X86_64_HPET_H
+#define X86_64_HPET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================================
+ * Registres (offsets MMIO)
+ * ======================================== */
+
+/* Taille de la fenêtre de registres */
+#define HPET_MMIO_SIZE          0x400
+
+#define HPET_REG_CAP            0x000   /* General Capabilities and ID */
+#define HPET_REG_CONFIG         0x010   /* General Configuration */
+#define HPET_REG_COUNTER        0x0F0   /* Main Counter Value */
+
+/* Registres du comparateur n */
+#define HPET_REG_TIMER_CONFIG(n)    (0x100 + 0x20 * (n))
+#define HPET_REG_TIMER_CMP(n)       (0x108 + 0x20 * (n))
+
+/* Capabilities : période du compteur (femtosecondes) dans les bits 63:32 */
+#define HPET_CAP_COUNT_64       (1 << 13)   /* Compteur 64 bits */
+#define HPET_CAP_LEGACY_ROUTE   (1 << 15)   /* Legacy replacement possible */
+#define HPET_CAP_PERIOD_SHIFT   32
+#define HPET_CAP_NUM_TIMERS(cap)    ((((cap) >> 8) & 0x1F) + 1)
+
+/* Période maximale autorisée par la spécification (100 ns) */
+#define HPET_MAX_PERIOD_FS      100000000ULL
+#define HPET_FS_PER_SECOND      1000000000000000ULL
+
+/* Configuration générale */
+#define HPET_CFG_ENABLE         (1 << 0)    /* Le compteur principal tourne */
+#define HPET_CFG_LEGACY_ROUTE   (1 << 1)    /* Comparateur 0 -> IRQ0, 1 -> IRQ8 */
+
+/* Configuration d'un comparateur */
+#define HPET_TN_LEVEL           (1 << 1)    /* Niveau (sinon front) */
+#define HPET_TN_INT_ENABLE      (1 << 2)
+#define HPET_TN_PERIODIC        (1 << 3)
+#define HPET_TN_SIZE_64         (1 << 5)    /* Comparateur 64 bits */
+#define HPET_TN_32BIT_MODE      (1 << 8)
+
+/* ========================================
+ * Fonctions
+ * ======================================== */
+
+/**
+ * Trouve le HPET via la table ACPI "HPET", mappe ses registres par
+ * ioremap et démarre le compteur principal.
+ * Nécessite acpi_init() et mmio_init().
+ *
+ * @return 0 si succès, -1 si pas de HPET utilisable
+ */
+int hpet_init(void);
+
+/**
+ * Le HPET est-il actif ?
+ */
+bool hpet_present(void);
+
+/**
+ * Fréquence du compteur principal, en Hz.
+ */
+uint64_t hpet_frequency(void);
+
+/**
+ * Valeur du compteur principal (64 bits, croissant).
+ */
+uint64_t hpet_read_counter(void);
+
+/**
+ * Prépare le comparateur 0 en one-shot, sans l'armer, et active le
+ * routage legacy : il lève l'IRQ0 du PIC, qui ne reçoit plus le PIT.
+ *
+ * @return 0 si succès, -1 si le HPET ne le permet pas
+ */
+int hpet_oneshot_init(void);
+
+/**
+ * Arme le comparateur 0 : interruption quand le compteur atteint deadline.
+ * Une échéance déjà dépassée ne déclenche rien ; à l'appelant de relire
+ * le compteur.
+ */
+void hpet_oneshot_arm(uint64_t deadline);
+
+#endif /* X86_64_HPET_H */
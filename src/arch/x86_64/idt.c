@@ -2,8 +2,10 @@
 #include "idt.h"
 #include "gdt.h"
 #include "io.h"
+#include "lapic.h"
 #include "../../kernel/klog.h"
 #include "../../kernel/console.h"
+#include "../../mm/kstack.h"
 
 /* ========================================
  * External ISR/IRQ Stubs (defined in interrupts.s)
@@ -61,6 +63,10 @@ extern void irq13(void);
 extern void irq14(void);
 extern void irq15(void);
 
+/* Local APIC handlers */
+extern void lapic_timer_irq(void);
+extern void lapic_spurious_irq(void);
+
 /* Syscall handler */
 extern void isr128(void);
 
@@ -226,6 +232,10 @@ void idt_init(void)
     idt_set_gate(46, (uint64_t)irq14, GDT_KERNEL_CODE, IDT_TYPE_INTERRUPT, 0);  /* Primary ATA */
     idt_set_gate(47, (uint64_t)irq15, GDT_KERNEL_CODE, IDT_TYPE_INTERRUPT, 0);  /* Secondary ATA */
     
+    /* Local APIC timer (tickless) and spurious vector */
+    idt_set_gate(LAPIC_TIMER_VECTOR, (uint64_t)lapic_timer_irq, GDT_KERNEL_CODE, IDT_TYPE_INTERRUPT, 0);
+    idt_set_gate(LAPIC_SPURIOUS_VECTOR, (uint64_t)lapic_spurious_irq, GDT_KERNEL_CODE, IDT_TYPE_INTERRUPT, 0);
+    
     /* Syscall handler (INT 0x80) - accessible from Ring 3 */
     idt_set_gate(0x80, (uint64_t)isr128, GDT_KERNEL_CODE, IDT_TYPE_USER_INT, 0);
     
@@ -318,6 +328,18 @@ void exception_handler(struct interrupt_frame *frame)
     KLOG_ERROR_HEX("PANIC", "RIP (low): ", (uint32_t)frame->rip);
     KLOG_ERROR_HEX("PANIC", "RSP (high): ", (uint32_t)(frame->rsp >> 32));
     KLOG_ERROR_HEX("PANIC", "RSP (low): ", (uint32_t)frame->rsp);
+    
+    /* Double fault sur une guard page : le page fault n'a pas pu empiler */
+    if (int_no == 8) {
+        uint64_t cr2;
+        __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+        if (kstack_is_guard(cr2)) {
+            KLOG_ERROR("PANIC", "Kernel stack overflow (guard page hit)");
+            KLOG_ERROR_HEX("PANIC", "CR2 (high): ", (uint32_t)(cr2 >> 32));
+            KLOG_ERROR_HEX("PANIC", "CR2 (low): ", (uint32_t)cr2);
+        }
+    }
+    
     KLOG_ERROR("PANIC", "System halted.");
     
     /* Halt */
@@ -274,6 +274,41 @@ irq0:
     add rsp, 16             ; Remove error_code and int_no
     iretq
 
+; ============================================
+; LAPIC Timer Handler (vector 48)
+; ============================================
+; Same contract as irq0: timer_handler_preempt sends the EOI (to the
+; LAPIC once the tick source has switched) and may return a new RSP.
+
+global lapic_timer_irq
+lapic_timer_irq:
+    push qword 0            ; Dummy error code
+    push qword 48           ; Interrupt number (LAPIC timer)
+    
+    PUSH_ALL
+    
+    ; Load kernel data segments
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    
+    mov rdi, rsp
+    call timer_handler_preempt
+    
+    test rax, rax
+    jz .lapic_no_preempt
+    mov rsp, rax
+    
+.lapic_no_preempt:
+    POP_ALL
+    add rsp, 16             ; Remove error_code and int_no
+    iretq
+
+; LAPIC spurious interrupt (vector 0xFF): no EOI
+global lapic_spurious_irq
+lapic_spurious_irq:
+    iretq
+
 ; ============================================
 ; Syscall Handler (INT 0x80)
 ; ============================================
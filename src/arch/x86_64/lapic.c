@@ -0,0 +1,90 @@
+/* src/arch/x86_64/lapic.c - Local APIC (timer) for x86-64 */
+#include "lapic.h"
+#include "cpu.h"
+#include "../../kernel/klog.h"
+#include "../../kernel/mmio/mmio.h"
+
+/* Registres du LAPIC (NULL tant que lapic_init n'a pas réussi) */
+static mmio_addr_t lapic_base = NULL;
+
+static inline uint32_t lapic_read(uint32_t reg)
+{
+    return mmio_read32_off(lapic_base, reg);
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value)
+{
+    mmio_write32_off(lapic_base, reg, value);
+}
+
+int lapic_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_1_EDX_APIC)) {
+        KLOG_INFO("LAPIC", "No local APIC");
+        return -1;
+    }
+
+    uint64_t base = rdmsr(MSR_APIC_BASE);
+    wrmsr(MSR_APIC_BASE, base | LAPIC_BASE_ENABLE);
+
+    lapic_base = ioremap(base & LAPIC_BASE_ADDR_MASK, 0x1000);
+    if (lapic_base == NULL) {
+        KLOG_ERROR("LAPIC", "Failed to map local APIC registers");
+        return -1;
+    }
+
+    /* Activation logicielle ; les IRQ legacy restent sur le PIC 8259 */
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+
+    KLOG_INFO_HEX("LAPIC", "Local APIC enabled, ID: ", lapic_read(LAPIC_REG_ID) >> 24);
+    return 0;
+}
+
+bool lapic_present(void)
+{
+    return lapic_base != NULL;
+}
+
+void lapic_eoi(void)
+{
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+void lapic_timer_periodic(uint32_t count)
+{
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INIT, count);
+}
+
+void lapic_timer_oneshot(uint32_t count)
+{
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INIT, count);
+}
+
+void lapic_timer_start_masked(uint32_t count)
+{
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_ONESHOT);
+    lapic_write(LAPIC_REG_TIMER_INIT, count);
+}
+
+uint32_t lapic_timer_current(void)
+{
+    return lapic_read(LAPIC_REG_TIMER_CUR);
+}
+
+bool lapic_timer_pending(void)
+{
+    uint32_t irr = lapic_read(LAPIC_REG_IRR + 0x10 * (LAPIC_TIMER_VECTOR / 32));
+    return (irr & (1U << (LAPIC_TIMER_VECTOR % 32))) != 0;
+}
+
+void lapic_timer_stop(void)
+{
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+}
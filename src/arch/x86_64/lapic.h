@@ -0,0 +1,96 @@
+/* src/arch/x86_64/lapic.h - Local APIC (timer) for x86-64 */
+#ifndef X86_64_LAPIC_H
+#define X86_64_LAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================================
+ * Registres (offsets MMIO)
+ * ======================================== */
+
+#define LAPIC_REG_ID            0x020
+#define LAPIC_REG_EOI           0x0B0
+#define LAPIC_REG_SVR           0x0F0   /* Spurious Interrupt Vector */
+#define LAPIC_REG_IRR           0x200   /* Interrupt Request (8 x 32 bits, pas de 0x10) */
+#define LAPIC_REG_LVT_TIMER     0x320
+#define LAPIC_REG_TIMER_INIT    0x380   /* Initial Count */
+#define LAPIC_REG_TIMER_CUR     0x390   /* Current Count */
+#define LAPIC_REG_TIMER_DIV     0x3E0   /* Divide Configuration */
+
+/* IA32_APIC_BASE */
+#define LAPIC_BASE_ENABLE       (1 << 11)
+#define LAPIC_BASE_ADDR_MASK    0xFFFFFF000ULL
+
+/* SVR */
+#define LAPIC_SVR_ENABLE        (1 << 8)
+
+/* LVT Timer */
+#define LAPIC_LVT_MASKED        (1 << 16)
+#define LAPIC_TIMER_ONESHOT     (0 << 17)
+#define LAPIC_TIMER_PERIODIC    (1 << 17)
+
+/* Divide Configuration : 0x3 = diviseur 16 */
+#define LAPIC_TIMER_DIV_16      0x3
+
+/* CPUID.01h:EDX */
+#define CPUID_1_EDX_APIC        (1 << 9)
+
+/* Vecteurs (au-dessus des IRQ du PIC, 32-47) */
+#define LAPIC_TIMER_VECTOR      48
+#define LAPIC_SPURIOUS_VECTOR   0xFF
+
+/* ========================================
+ * Fonctions
+ * ======================================== */
+
+/**
+ * Active le Local APIC du CPU courant (MMIO mappé par ioremap).
+ * Nécessite mmio_init().
+ *
+ * @return 0 si succès, -1 si pas d'APIC
+ */
+int lapic_init(void);
+
+/**
+ * Le Local APIC est-il actif ?
+ */
+bool lapic_present(void);
+
+/**
+ * Signale la fin d'une interruption délivrée par le LAPIC.
+ */
+void lapic_eoi(void);
+
+/**
+ * Démarre le timer en mode périodique (count ticks du bus / 16 par période).
+ */
+void lapic_timer_periodic(uint32_t count);
+
+/**
+ * Démarre le timer en one-shot : une seule interruption après count.
+ */
+void lapic_timer_oneshot(uint32_t count);
+
+/**
+ * Arme le timer sans interruption (calibration).
+ */
+void lapic_timer_start_masked(uint32_t count);
+
+/**
+ * Compteur courant (décroissant ; 0 une fois un one-shot expiré).
+ */
+uint32_t lapic_timer_current(void);
+
+/**
+ * Une interruption du timer attend-elle d'être délivrée (bit de
+ * LAPIC_TIMER_VECTOR dans l'IRR, typiquement sous cli) ?
+ */
+bool lapic_timer_pending(void);
+
+/**
+ * Arrête le timer.
+ */
+void lapic_timer_stop(void);
+
+#endif /* X86_64_LAPIC_H */
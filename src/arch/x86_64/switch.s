@@ -60,7 +60,7 @@ switch_context:
 ; Parameters (System V ABI):
 ;   RDI = old_rsp_ptr : Pointer to save current RSP
 ;   RSI = new_rsp     : New RSP to load
-;   RDX = new_cr3     : New page table (0 = no change)
+;   RDX = new_cr3     : New page table (0 = no change), PCID + bit 63 inclus
 ;
 ; Stack layout sauvegardé (identique à IRQ):
 ;   [SS, RSP, RFLAGS, CS, RIP, error_code, int_no, RAX...R15]
@@ -123,8 +123,14 @@ switch_task:
     mov [r8], rsp
     
     ; Changer CR3 si nécessaire
+    ; Avec PCID, recharger le CR3 courant avec le bit no-flush (63) ne sert
+    ; à rien : on l'évite (mov cr3 est sérialisant). RAX/R11 sont déjà sauvés.
     test r10, r10
     jz .skip_cr3
+    mov rax, cr3
+    bts rax, 63
+    cmp rax, r10
+    je .skip_cr3
     mov cr3, r10
 .skip_cr3:
     
@@ -8,6 +8,7 @@
 #include "../../arch/x86_64/idt.h"
 #include "../../arch/x86_64/io.h"
 #include "../../mm/kheap.h"
+#include "../../mm/dma.h"
 #include "../../kernel/mmio/mmio.h"
 #include "../../net/core/netdev.h"
 #include "../../net/l2/ethernet.h"
@@ -131,44 +132,31 @@ static void e1000_reset(E1000Device *dev) {
  * Initialize RX descriptors and buffers.
  */
 static bool e1000_init_rx(E1000Device *dev) {
-    /* Allocate descriptor ring (16-byte aligned) */
+    /* Allocate descriptor ring (DMA-coherent, zeroed) */
     size_t desc_size = sizeof(E1000RxDesc) * E1000_NUM_RX_DESC;
-    dev->rx_descs = (E1000RxDesc *)kmalloc(desc_size + 16);
+    dev->rx_descs = (E1000RxDesc *)dma_alloc_coherent(desc_size, &dev->rx_descs_dma);
     if (dev->rx_descs == NULL) {
         KLOG_ERROR("E1000E", "Failed to allocate RX descriptors");
         return false;
     }
     
-    /* Align to 16 bytes */
-    uint32_t addr = (uint32_t)(uintptr_t)dev->rx_descs;
-    if (addr & 0xF) {
-        addr = (addr + 15) & ~0xF;
-        dev->rx_descs = (E1000RxDesc *)(uintptr_t)addr;
-    }
-    
     /* Allocate buffers and initialize descriptors */
     for (int i = 0; i < E1000_NUM_RX_DESC; i++) {
-        dev->rx_buffers[i] = (uint8_t *)kmalloc(E1000_RX_BUFFER_SIZE + 16);
+        dma_addr_t buf_dma;
+        dev->rx_buffers[i] = (uint8_t *)dma_pool_alloc(dev->buf_pool, &buf_dma);
         if (dev->rx_buffers[i] == NULL) {
             KLOG_ERROR("E1000E", "Failed to allocate RX buffer");
             return false;
         }
         
-        /* Align buffer */
-        uint32_t buf_addr = (uint32_t)(uintptr_t)dev->rx_buffers[i];
-        if (buf_addr & 0xF) {
-            buf_addr = (buf_addr + 15) & ~0xF;
-            dev->rx_buffers[i] = (uint8_t *)(uintptr_t)buf_addr;
-        }
-        
-        dev->rx_descs[i].buffer_addr = (uint64_t)(uintptr_t)dev->rx_buffers[i];
+        dev->rx_descs[i].buffer_addr = buf_dma;
         dev->rx_descs[i].status = 0;
     }
     
     /* Program the descriptor ring address */
-    uint32_t rx_ring_addr = (uint32_t)(uintptr_t)dev->rx_descs;
+    uint32_t rx_ring_addr = (uint32_t)dev->rx_descs_dma;
     e1000_write_reg(dev, E1000_RDBAL, rx_ring_addr);
-    e1000_write_reg(dev, E1000_RDBAH, 0);  /* 32-bit only */
+    e1000_write_reg(dev, E1000_RDBAH, (uint32_t)(dev->rx_descs_dma >> 32));
     
     /* Program the descriptor ring length */
     e1000_write_reg(dev, E1000_RDLEN, desc_size);
@@ -188,33 +176,30 @@ static bool e1000_init_rx(E1000Device *dev) {
  * Initialize TX descriptors and buffers.
  */
 static bool e1000_init_tx(E1000Device *dev) {
-    /* Allocate descriptor ring (16-byte aligned) */
+    /* Allocate descriptor ring (DMA-coherent, zeroed) */
     size_t desc_size = sizeof(E1000TxDesc) * E1000_NUM_TX_DESC;
-    dev->tx_descs = (E1000TxDesc *)kmalloc(desc_size + 16);
+    dev->tx_descs = (E1000TxDesc *)dma_alloc_coherent(desc_size, &dev->tx_descs_dma);
     if (dev->tx_descs == NULL) {
         KLOG_ERROR("E1000E", "Failed to allocate TX descriptors");
         return false;
     }
     
-    /* Align to 16 bytes */
-    uint32_t addr = (uint32_t)(uintptr_t)dev->tx_descs;
-    if (addr & 0xF) {
-        addr = (addr + 15) & ~0xF;
-        dev->tx_descs = (E1000TxDesc *)(uintptr_t)addr;
-    }
-    
-    /* Initialize descriptors */
+    /* Allocate buffers up front: the send path only copies into them */
     for (int i = 0; i < E1000_NUM_TX_DESC; i++) {
-        dev->tx_buffers[i] = NULL;  /* Allocated on demand */
-        dev->tx_descs[i].buffer_addr = 0;
+        dev->tx_buffers[i] = (uint8_t *)dma_pool_alloc(dev->buf_pool, &dev->tx_buffers_dma[i]);
+        if (dev->tx_buffers[i] == NULL) {
+            KLOG_ERROR("E1000E", "Failed to allocate TX buffer");
+            return false;
+        }
+        dev->tx_descs[i].buffer_addr = dev->tx_buffers_dma[i];
         dev->tx_descs[i].cmd = 0;
         dev->tx_descs[i].status = E1000_TXD_STAT_DD;  /* Mark as done */
     }
     
     /* Program the descriptor ring address */
-    uint32_t tx_ring_addr = (uint32_t)(uintptr_t)dev->tx_descs;
+    uint32_t tx_ring_addr = (uint32_t)dev->tx_descs_dma;
     e1000_write_reg(dev, E1000_TDBAL, tx_ring_addr);
-    e1000_write_reg(dev, E1000_TDBAH, 0);  /* 32-bit only */
+    e1000_write_reg(dev, E1000_TDBAH, (uint32_t)(dev->tx_descs_dma >> 32));
     
     /* Program the descriptor ring length */
     e1000_write_reg(dev, E1000_TDLEN, desc_size);
@@ -230,6 +215,29 @@ static bool e1000_init_tx(E1000Device *dev) {
     return true;
 }
 
+/**
+ * Release the buffers, the rings and the buffer pool after a failed
+ * initialization.
+ */
+static void e1000_free_dma(E1000Device *dev) {
+    for (int i = 0; i < E1000_NUM_RX_DESC; i++) {
+        dma_pool_free(dev->buf_pool, dev->rx_buffers[i]);
+        dev->rx_buffers[i] = NULL;
+    }
+    for (int i = 0; i < E1000_NUM_TX_DESC; i++) {
+        dma_pool_free(dev->buf_pool, dev->tx_buffers[i]);
+        dev->tx_buffers[i] = NULL;
+    }
+    
+    dma_free_coherent(dev->rx_descs, sizeof(E1000RxDesc) * E1000_NUM_RX_DESC);
+    dma_free_coherent(dev->tx_descs, sizeof(E1000TxDesc) * E1000_NUM_TX_DESC);
+    dma_pool_destroy(dev->buf_pool);
+    
+    dev->rx_descs = NULL;
+    dev->tx_descs = NULL;
+    dev->buf_pool = NULL;
+}
+
 /**
  * Enable RX.
  */
@@ -409,14 +417,6 @@ static int e1000_netif_send(NetInterface *netif, uint8_t *data, int len) {
         return -1;
     }
     
-    /* Allocate buffer if needed */
-    if (dev->tx_buffers[dev->tx_cur] == NULL) {
-        dev->tx_buffers[dev->tx_cur] = (uint8_t *)kmalloc(E1000_TX_BUFFER_SIZE);
-        if (dev->tx_buffers[dev->tx_cur] == NULL) {
-            return -1;
-        }
-    }
-    
     /* Copy data to buffer */
     uint8_t *buf = dev->tx_buffers[dev->tx_cur];
     for (int i = 0; i < len; i++) {
@@ -424,7 +424,7 @@ static int e1000_netif_send(NetInterface *netif, uint8_t *data, int len) {
     }
     
     /* Setup descriptor */
-    desc->buffer_addr = (uint64_t)(uintptr_t)buf;
+    desc->buffer_addr = dev->tx_buffers_dma[dev->tx_cur];
     desc->length = len;
     desc->cso = 0;
     desc->css = 0;
@@ -494,6 +494,7 @@ E1000Device *e1000e_init(PCIDevice *pci_dev) {
     dev->errors = 0;
     dev->rx_descs = NULL;
     dev->tx_descs = NULL;
+    dev->buf_pool = NULL;
     dev->rx_cur = 0;
     dev->tx_cur = 0;
     
@@ -580,14 +581,19 @@ E1000Device *e1000e_init(PCIDevice *pci_dev) {
         e1000_write_reg(dev, E1000_MTA + (i * 4), 0);
     }
     
-    /* Initialize RX */
-    if (!e1000_init_rx(dev)) {
+    /* Packet buffer pool shared by RX and TX */
+    dev->buf_pool = dma_pool_create("e1000e", E1000_RX_BUFFER_SIZE, 16);
+    if (dev->buf_pool == NULL) {
+        KLOG_ERROR("E1000E", "Failed to create DMA buffer pool");
+        iounmap(dev->mmio_base, dev->mmio_size);
         kfree(dev);
         return NULL;
     }
     
-    /* Initialize TX */
-    if (!e1000_init_tx(dev)) {
+    /* Initialize RX and TX (receiver and transmitter are still disabled) */
+    if (!e1000_init_rx(dev) || !e1000_init_tx(dev)) {
+        e1000_free_dma(dev);
+        iounmap(dev->mmio_base, dev->mmio_size);
         kfree(dev);
         return NULL;
     }
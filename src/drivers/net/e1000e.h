@@ -7,6 +7,7 @@
 #define E1000E_H
 
 #include "../pci.h"
+#include "../../mm/dma.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -258,13 +259,17 @@ typedef struct {
     /* MAC Address */
     uint8_t mac_addr[6];
     
-    /* Descriptors (16-byte aligned) */
+    /* Descriptors (DMA-coherent, page aligned) */
     E1000RxDesc *rx_descs;          /* RX descriptor ring */
     E1000TxDesc *tx_descs;          /* TX descriptor ring */
+    dma_addr_t rx_descs_dma;        /* Bus address of the RX ring */
+    dma_addr_t tx_descs_dma;        /* Bus address of the TX ring */
     
-    /* Buffers */
+    /* Buffers (from buf_pool, bus addresses computed once) */
+    dma_pool_t *buf_pool;
     uint8_t *rx_buffers[E1000_NUM_RX_DESC];
     uint8_t *tx_buffers[E1000_NUM_TX_DESC];
+    dma_addr_t tx_buffers_dma[E1000_NUM_TX_DESC];
     
     /* Ring indices */
     uint16_t rx_cur;                /* Current RX descriptor */
@@ -246,8 +246,8 @@ static void pcnet_receive(PCNetDevice *dev) {
       /* mcnt contient la taille du message (12 bits bas) */
       uint16_t len = desc->mcnt & 0x0FFF;
 
-      /* Récupérer le pointeur vers les données */
-      uint8_t *buffer = (uint8_t *)(uintptr_t)desc->rbadr;
+      /* Récupérer le pointeur vers les données (rbadr est une adresse bus) */
+      uint8_t *buffer = dev->rx_buffers + dev->rx_index * PCNET_BUFFER_SIZE;
 
       /* Passer le paquet à la couche Ethernet pour traitement (pas de log) */
       ethernet_handle_packet(buffer, len);
@@ -352,6 +352,56 @@ static void pcnet_print_mac(PCNetDevice *dev) {
   KLOG_INFO("PCNET", "MAC Address read from device");
 }
 
+/* ============================================ */
+/*           DMA Memory                         */
+/* ============================================ */
+
+/**
+ * Alloue une zone DMA cohérente adressable par la carte (sous 4 GiB).
+ */
+static void *pcnet_dma_alloc(size_t size, dma_addr_t *dma_handle) {
+  void *vaddr = dma_alloc_coherent(size, dma_handle);
+  if (vaddr != NULL && *dma_handle + size > 0x100000000ULL) {
+    KLOG_ERROR_HEX("PCNET", "DMA memory above 4 GiB, high: ",
+                   (uint32_t)(*dma_handle >> 32));
+    dma_free_coherent(vaddr, size);
+    return NULL;
+  }
+  return vaddr;
+}
+
+/**
+ * Alloue l'Init Block, les rings et les buffers de données.
+ * @return 0 si succès, -1 sinon (pcnet_free_dma libère ce qui a été alloué)
+ */
+static int pcnet_alloc_dma(PCNetDevice *dev) {
+  dev->init_block = (PCNetInitBlock *)pcnet_dma_alloc(sizeof(PCNetInitBlock),
+                                                      &dev->init_block_dma);
+  dev->rx_ring = (PCNetRxDesc *)pcnet_dma_alloc(
+      sizeof(PCNetRxDesc) * PCNET_RX_BUFFERS, &dev->rx_ring_dma);
+  dev->tx_ring = (PCNetTxDesc *)pcnet_dma_alloc(
+      sizeof(PCNetTxDesc) * PCNET_TX_BUFFERS, &dev->tx_ring_dma);
+  dev->rx_buffers = (uint8_t *)pcnet_dma_alloc(
+      PCNET_BUFFER_SIZE * PCNET_RX_BUFFERS, &dev->rx_buffers_dma);
+  dev->tx_buffers = (uint8_t *)pcnet_dma_alloc(
+      PCNET_BUFFER_SIZE * PCNET_TX_BUFFERS, &dev->tx_buffers_dma);
+
+  if (dev->init_block == NULL || dev->rx_ring == NULL ||
+      dev->tx_ring == NULL || dev->rx_buffers == NULL ||
+      dev->tx_buffers == NULL) {
+    return -1;
+  }
+  return 0;
+}
+
+static void pcnet_free_dma(PCNetDevice *dev) {
+  dma_free_coherent(dev->init_block, sizeof(PCNetInitBlock));
+  dma_free_coherent(dev->rx_ring, sizeof(PCNetRxDesc) * PCNET_RX_BUFFERS);
+  dma_free_coherent(dev->tx_ring, sizeof(PCNetTxDesc) * PCNET_TX_BUFFERS);
+  dma_free_coherent(dev->rx_buffers, PCNET_BUFFER_SIZE * PCNET_RX_BUFFERS);
+  dma_free_coherent(dev->tx_buffers, PCNET_BUFFER_SIZE * PCNET_TX_BUFFERS);
+}
+
 /* ============================================ */
 /*           Initialization                     */
 /* ============================================ */
@@ -545,77 +595,27 @@ PCNetDevice *pcnet_init(PCIDevice *pci_dev) {
   pcnet_read_mac(dev);
   pcnet_print_mac(dev);
 
-  /* Étape 5: Allouer l'Initialization Block */
+  /* Étape 5-7: Allouer l'Init Block, les rings et les buffers */
   /*
-   * L'Init Block doit être aligné sur 4 octets minimum.
-   * On alloue un peu plus pour s'assurer de l'alignement.
+   * Mémoire DMA cohérente : alignée sur une page (l'Init Block demande 4
+   * octets, les rings 16) et physiquement contiguë. La carte (SWSTYLE 2)
+   * n'adresse que 32 bits : tout doit tenir sous 4 GiB.
    */
-  dev->init_block = (PCNetInitBlock *)kmalloc(sizeof(PCNetInitBlock) + 16);
-  if (dev->init_block == NULL) {
-    KLOG_ERROR("PCNET", "Failed to allocate Init Block!");
+  if (pcnet_alloc_dma(dev) != 0) {
+    KLOG_ERROR("PCNET", "Failed to allocate DMA memory!");
+    pcnet_free_dma(dev);
     kfree(dev);
     return NULL;
   }
 
-  /* Aligner sur 16 octets si nécessaire */
-  uint32_t init_block_addr = (uint32_t)(uintptr_t)dev->init_block;
-  if (init_block_addr & 0xF) {
-    init_block_addr = (init_block_addr + 15) & ~0xF;
-    dev->init_block = (PCNetInitBlock *)(uintptr_t)init_block_addr;
-  }
-
-  KLOG_INFO_HEX("PCNET", "Init Block allocated at: ", (uint32_t)(uintptr_t)dev->init_block);
-
-  /* Vérifier l'alignement */
-  if ((uint32_t)(uintptr_t)dev->init_block & 0x3) {
-    KLOG_WARN("PCNET", "Init Block not 4-byte aligned!");
-  } else {
-    KLOG_INFO("PCNET", "Init Block alignment: OK");
-  }
-
-  /* Étape 6: Allouer les Descriptor Rings (alignés sur 16 octets) */
-  dev->rx_ring =
-      (PCNetRxDesc *)kmalloc(sizeof(PCNetRxDesc) * PCNET_RX_BUFFERS + 16);
-  dev->tx_ring =
-      (PCNetTxDesc *)kmalloc(sizeof(PCNetTxDesc) * PCNET_TX_BUFFERS + 16);
-
-  if (dev->rx_ring == NULL || dev->tx_ring == NULL) {
-    KLOG_ERROR("PCNET", "Failed to allocate descriptor rings!");
-    return NULL;
-  }
-
-  /* Aligner les rings sur 16 octets */
-  uint32_t rx_ring_addr = (uint32_t)(uintptr_t)dev->rx_ring;
-  if (rx_ring_addr & 0xF) {
-    rx_ring_addr = (rx_ring_addr + 15) & ~0xF;
-    dev->rx_ring = (PCNetRxDesc *)(uintptr_t)rx_ring_addr;
-  }
-
-  uint32_t tx_ring_addr = (uint32_t)(uintptr_t)dev->tx_ring;
-  if (tx_ring_addr & 0xF) {
-    tx_ring_addr = (tx_ring_addr + 15) & ~0xF;
-    dev->tx_ring = (PCNetTxDesc *)(uintptr_t)tx_ring_addr;
-  }
-
-  KLOG_INFO_HEX("PCNET", "RX Ring at: ", (uint32_t)(uintptr_t)dev->rx_ring);
-  KLOG_INFO_HEX("PCNET", "TX Ring at: ", (uint32_t)(uintptr_t)dev->tx_ring);
-
-  /* Étape 7: Allouer les buffers de données */
-  dev->rx_buffers = (uint8_t *)kmalloc(PCNET_BUFFER_SIZE * PCNET_RX_BUFFERS);
-  dev->tx_buffers = (uint8_t *)kmalloc(PCNET_BUFFER_SIZE * PCNET_TX_BUFFERS);
-
-  if (dev->rx_buffers == NULL || dev->tx_buffers == NULL) {
-    KLOG_ERROR("PCNET", "Failed to allocate data buffers!");
-    return NULL;
-  }
-
-  KLOG_INFO_HEX("PCNET", "RX Buffers at: ", (uint32_t)(uintptr_t)dev->rx_buffers);
-  KLOG_INFO_HEX("PCNET", "TX Buffers at: ", (uint32_t)(uintptr_t)dev->tx_buffers);
+  KLOG_INFO_HEX("PCNET", "Init Block at bus: ", (uint32_t)dev->init_block_dma);
+  KLOG_INFO_HEX("PCNET", "RX Ring at bus: ", (uint32_t)dev->rx_ring_dma);
+  KLOG_INFO_HEX("PCNET", "TX Ring at bus: ", (uint32_t)dev->tx_ring_dma);
 
   /* Étape 8: Initialiser les descripteurs RX */
   for (int i = 0; i < PCNET_RX_BUFFERS; i++) {
     dev->rx_ring[i].rbadr =
-        (uint32_t)(uintptr_t)(dev->rx_buffers + i * PCNET_BUFFER_SIZE);
+        (uint32_t)(dev->rx_buffers_dma + i * PCNET_BUFFER_SIZE);
     /* BCNT: bits 12-15 doivent être 1 (0xF000), bits 0-11 = complément à 2 de
      * la taille */
     dev->rx_ring[i].bcnt =
@@ -628,7 +628,7 @@ PCNetDevice *pcnet_init(PCIDevice *pci_dev) {
   /* Étape 9: Initialiser les descripteurs TX */
   for (int i = 0; i < PCNET_TX_BUFFERS; i++) {
     dev->tx_ring[i].tbadr =
-        (uint32_t)(uintptr_t)(dev->tx_buffers + i * PCNET_BUFFER_SIZE);
+        (uint32_t)(dev->tx_buffers_dma + i * PCNET_BUFFER_SIZE);
     dev->tx_ring[i].bcnt = 0xF000; /* Bits 12-15 = 1, taille = 0 */
     dev->tx_ring[i].status = 0;    /* OWN = 0 (CPU owned) */
     dev->tx_ring[i].misc = 0;
@@ -658,8 +658,8 @@ PCNetDevice *pcnet_init(PCIDevice *pci_dev) {
   }
 
   /* Adresses des rings */
-  dev->init_block->rdra = (uint32_t)(uintptr_t)dev->rx_ring;
-  dev->init_block->tdra = (uint32_t)(uintptr_t)dev->tx_ring;
+  dev->init_block->rdra = (uint32_t)dev->rx_ring_dma;
+  dev->init_block->tdra = (uint32_t)dev->tx_ring_dma;
 
   KLOG_INFO("PCNET", "Init Block configured");
 
@@ -724,7 +724,7 @@ bool pcnet_start(PCNetDevice *dev) {
   KLOG_INFO("PCNET", "Starting card...");
 
   /* Étape 1: Écrire l'adresse de l'Init Block dans CSR1 et CSR2 */
-  uint32_t init_addr = (uint32_t)(uintptr_t)dev->init_block;
+  uint32_t init_addr = (uint32_t)dev->init_block_dma;
 
   pcnet_write_csr(dev, CSR1, init_addr & 0xFFFF);         /* 16 bits bas */
   pcnet_write_csr(dev, CSR2, (init_addr >> 16) & 0xFFFF); /* 16 bits hauts */
@@ -805,7 +805,7 @@ bool pcnet_send(PCNetDevice *dev, const uint8_t *data, uint16_t len) {
   }
 
   /* Configurer le descripteur */
-  desc->tbadr = (uint32_t)(uintptr_t)buf;
+  desc->tbadr = (uint32_t)(dev->tx_buffers_dma + idx * PCNET_BUFFER_SIZE);
 
   /*
    * BCNT: 12 bits, complément à 2, bits 15-12 doivent être 1 (0xF000)
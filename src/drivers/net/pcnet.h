@@ -15,6 +15,7 @@
 #define PCNET_H
 
 #include "../pci.h"
+#include "../../mm/dma.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -199,13 +200,20 @@ typedef struct {
   
   uint8_t mac_addr[6]; /* MAC Address */
 
-  /* DMA Buffers (physiquement contigus) */
+  /* DMA Buffers (dma_alloc_coherent, physiquement contigus) */
   PCNetInitBlock *init_block; /* Initialization Block */
   PCNetRxDesc *rx_ring;       /* Receive Descriptor Ring */
   PCNetTxDesc *tx_ring;       /* Transmit Descriptor Ring */
   uint8_t *rx_buffers;        /* Receive Buffers */
   uint8_t *tx_buffers;        /* Transmit Buffers */
 
+  /* Adresses bus correspondantes (la carte n'adresse que 32 bits) */
+  dma_addr_t init_block_dma;
+  dma_addr_t rx_ring_dma;
+  dma_addr_t tx_ring_dma;
+  dma_addr_t rx_buffers_dma;
+  dma_addr_t tx_buffers_dma;
+
   /* Ring indices */
   int rx_index; /* Current receive index */
   int tx_index; /* Current transmit index */
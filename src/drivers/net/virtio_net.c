@@ -13,6 +13,7 @@
 #include "../../arch/x86_64/idt.h"
 #include "../../arch/x86_64/io.h"
 #include "../../mm/kheap.h"
+#include "../../mm/dma.h"
 #include "../../net/core/netdev.h"
 #include "../../net/l2/ethernet.h"
 #include "../../kernel/klog.h"
@@ -58,12 +59,16 @@ typedef struct {
 static VirtioNetDriver *g_driver = NULL;
 static NetInterface *g_netif = NULL;
 
-/* Taille des buffers RX */
+/* Taille des buffers RX/TX (header VirtIO + trame Ethernet) */
 #define RX_BUFFER_SIZE 2048
 #define RX_BUFFER_COUNT 16
 
+/* Pool DMA des buffers de paquets : adresse bus connue dès l'allocation */
+static dma_pool_t *g_buf_pool = NULL;
+
 /* Buffers RX pré-alloués */
 static uint8_t *rx_buffers[RX_BUFFER_COUNT];
+static dma_addr_t rx_buffers_dma[RX_BUFFER_COUNT];
 
 /* ============================================ */
 /*           Fonctions internes                 */
@@ -77,14 +82,15 @@ static void virtio_net_refill_rx(VirtioNetDriver *drv) {
     
     for (int i = 0; i < RX_BUFFER_COUNT && vq->num_free >= 1; i++) {
         if (rx_buffers[i] == NULL) {
-            rx_buffers[i] = (uint8_t *)kmalloc(RX_BUFFER_SIZE);
+            rx_buffers[i] = (uint8_t *)dma_pool_alloc(g_buf_pool, &rx_buffers_dma[i]);
             if (rx_buffers[i] == NULL) {
                 continue;
             }
         }
         
         /* Ajouter le buffer à la queue (device-writable) */
-        int idx = virtio_queue_add_buf(vq, rx_buffers[i], RX_BUFFER_SIZE, true, false);
+        int idx = virtio_queue_add_buf_dma(vq, rx_buffers[i], rx_buffers_dma[i],
+                                           RX_BUFFER_SIZE, true, false);
         if (idx < 0) {
             break;
         }
@@ -102,7 +108,8 @@ static void virtio_net_receive(VirtioNetDriver *drv) {
     
     while (virtio_queue_has_used(vq)) {
         uint32_t len;
-        uint8_t *buf = (uint8_t *)virtio_queue_get_used(vq, &len);
+        uint64_t buf_dma;
+        uint8_t *buf = (uint8_t *)virtio_queue_get_used_dma(vq, &len, &buf_dma);
         
         if (buf == NULL || len <= VIRTIO_NET_HDR_SIZE) {
             continue;
@@ -123,8 +130,8 @@ static void virtio_net_receive(VirtioNetDriver *drv) {
             }
         }
         
-        /* Remettre le buffer dans la queue RX */
-        virtio_queue_add_buf(vq, buf, RX_BUFFER_SIZE, true, false);
+        /* Remettre le buffer dans la queue RX (adresse bus déjà connue) */
+        virtio_queue_add_buf_dma(vq, buf, buf_dma, RX_BUFFER_SIZE, true, false);
     }
     
     /* Notifier le device */
@@ -185,7 +192,7 @@ static int virtio_netif_send(NetInterface *netif, uint8_t *data, int len) {
             uint32_t used_len;
             void *used_buf = virtio_queue_get_used(vq, &used_len);
             if (used_buf != NULL) {
-                kfree(used_buf);
+                dma_pool_free(g_buf_pool, used_buf);
             }
         }
         
@@ -195,9 +202,14 @@ static int virtio_netif_send(NetInterface *netif, uint8_t *data, int len) {
         }
     }
     
-    /* Allouer le header + données dans un seul buffer */
+    /* Allouer le header + données dans un seul buffer du pool DMA */
     uint32_t total_len = VIRTIO_NET_HDR_SIZE + len;
-    uint8_t *buf = (uint8_t *)kmalloc(total_len);
+    if (len <= 0 || total_len > RX_BUFFER_SIZE) {
+        drv->errors++;
+        return -1;
+    }
+    dma_addr_t buf_dma;
+    uint8_t *buf = (uint8_t *)dma_pool_alloc(g_buf_pool, &buf_dma);
     if (buf == NULL) {
         drv->errors++;
         return -1;
@@ -219,9 +231,9 @@ static int virtio_netif_send(NetInterface *netif, uint8_t *data, int len) {
     }
     
     /* Ajouter à la queue TX */
-    int idx = virtio_queue_add_buf(vq, buf, total_len, false, false);
+    int idx = virtio_queue_add_buf_dma(vq, buf, buf_dma, total_len, false, false);
     if (idx < 0) {
-        kfree(buf);
+        dma_pool_free(g_buf_pool, buf);
         drv->errors++;
         return -1;
     }
@@ -281,6 +293,17 @@ VirtIONetDevice *virtio_net_init(PCIDevice *pci_dev) {
         rx_buffers[i] = NULL;
     }
     
+    /* Pool des buffers de paquets (partagé RX/TX) */
+    if (g_buf_pool == NULL) {
+        g_buf_pool = dma_pool_create("virtio-net", RX_BUFFER_SIZE, 16);
+        if (g_buf_pool == NULL) {
+            KLOG_ERROR("VIRTIO-NET", "Failed to create DMA buffer pool");
+            kfree(drv);
+            virtio_destroy(vdev);
+            return NULL;
+        }
+    }
+    
     /* Enable Bus Mastering */
     pci_enable_bus_mastering(pci_dev);
     
@@ -0,0 +1,461 @@
+/* src/drivers/virtio/virtio_balloon.c - VirtIO Memory Balloon Driver
+ *
+ * Les pages du balloon ne sont jamais touchées par l'invité (l'hôte a pu
+ * en retirer la mémoire) : leurs PFN sont gardés à part, dans des chunks
+ * alloués par kmalloc.
+ */
+
+#include "virtio_balloon.h"
+#include "virtio_transport.h"
+#include "../pci.h"
+#include "../../mm/pmm.h"
+#include "../../mm/kheap.h"
+#include "../../mm/dma.h"
+#include "../../kernel/klog.h"
+#include "../../kernel/sync.h"
+#include "../../kernel/thread.h"
+#include "../../kernel/timer.h"
+
+/* PFN cédés à l'hôte, en pile de chunks */
+#define BALLOON_CHUNK_PFNS  1022
+
+typedef struct balloon_chunk {
+    struct balloon_chunk *next;
+    uint32_t count;
+    uint32_t pfns[BALLOON_CHUNK_PFNS];
+} balloon_chunk_t;
+
+typedef struct {
+    VirtioDevice *vdev;
+    VirtQueue inflate_vq;
+    VirtQueue deflate_vq;
+    VirtQueue report_vq;
+    uint32_t features;
+
+    /* Tableau de PFN transmis à l'hôte (DMA) */
+    uint32_t *pfn_array;
+    dma_addr_t pfn_array_dma;
+
+    balloon_chunk_t *chunks;
+    bool failed;                /* L'hôte ne répond plus : driver figé */
+
+    /* Free page reporting : mémoire libre à la dernière passe */
+    uint64_t report_baseline;
+    uint64_t last_report_ms;
+} VirtioBalloonDriver;
+
+static VirtioBalloonDriver *g_balloon = NULL;
+static virtio_balloon_stats_t g_stats;
+
+/* Sérialise l'usage des queues (thread balloon et virtio_balloon_deflate) */
+static mutex_t balloon_mutex = MUTEX_INIT;
+
+/* Réveil du thread balloon avant la fin de son attente (manque de mémoire) */
+static semaphore_t balloon_sem;
+
+/* ============================================ */
+/*           Fonctions internes                 */
+/* ============================================ */
+
+/**
+ * Attend que le device ait consommé count buffers de la queue.
+ * @return 0 si succès, -1 si timeout (le driver est alors figé)
+ */
+static int balloon_wait_used(VirtioBalloonDriver *drv, VirtQueue *vq, uint32_t count) {
+    uint64_t deadline = timer_get_uptime_ms() + VIRTIO_BALLOON_TIMEOUT_MS;
+
+    while (count > 0) {
+        if (virtio_queue_get_used(vq, NULL) != NULL) {
+            count--;
+            continue;
+        }
+        if (timer_get_uptime_ms() > deadline) {
+            KLOG_ERROR("BALLOON", "Host did not answer, driver disabled");
+            drv->failed = true;
+            return -1;
+        }
+        thread_yield();
+    }
+
+    /* Interruptions désactivées : acquitter l'ISR au passage */
+    drv->vdev->ops->ack_interrupt(drv->vdev);
+    return 0;
+}
+
+/* Transmet les count premiers PFN de pfn_array sur une queue */
+static int balloon_tell_host(VirtioBalloonDriver *drv, VirtQueue *vq, uint32_t count) {
+    if (virtio_queue_add_buf_dma(vq, drv->pfn_array, drv->pfn_array_dma,
+                                 count * sizeof(uint32_t), false, false) < 0) {
+        return -1;
+    }
+    virtio_notify(drv->vdev, vq);
+    return balloon_wait_used(drv, vq, 1);
+}
+
+static void balloon_set_actual(VirtioBalloonDriver *drv, uint32_t actual) {
+    g_stats.actual_pages = actual;
+    drv->vdev->ops->write_config32(drv->vdev, VIRTIO_BALLOON_CFG_ACTUAL, actual);
+}
+
+/**
+ * Retire jusqu'à count pages du PMM et les cède à l'hôte.
+ * @return Nombre de pages ajoutées au balloon
+ */
+static uint32_t balloon_inflate(VirtioBalloonDriver *drv, uint32_t count) {
+    if (count > VIRTIO_BALLOON_ARRAY_PFNS_MAX) {
+        count = VIRTIO_BALLOON_ARRAY_PFNS_MAX;
+    }
+
+    /* Place dans le chunk de tête pour tout le lot */
+    if (drv->chunks == NULL || BALLOON_CHUNK_PFNS - drv->chunks->count < count) {
+        balloon_chunk_t *chunk = (balloon_chunk_t *)kmalloc(sizeof(balloon_chunk_t));
+        if (chunk == NULL) {
+            return 0;
+        }
+        chunk->count = 0;
+        chunk->next = drv->chunks;
+        drv->chunks = chunk;
+    }
+
+    uint32_t n = 0;
+    while (n < count && pmm_get_free_blocks() > VIRTIO_BALLOON_MIN_FREE) {
+        void *frame = pmm_alloc_block();
+        if (frame == NULL) {
+            break;
+        }
+        drv->pfn_array[n++] = (uint32_t)(pmm_virt_to_phys(frame) >> VIRTIO_BALLOON_PFN_SHIFT);
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    if (balloon_tell_host(drv, &drv->inflate_vq, n) != 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            pmm_free_block(pmm_phys_to_virt((uint64_t)drv->pfn_array[i] << VIRTIO_BALLOON_PFN_SHIFT));
+        }
+        return 0;
+    }
+
+    balloon_chunk_t *chunk = drv->chunks;
+    for (uint32_t i = 0; i < n; i++) {
+        chunk->pfns[chunk->count++] = drv->pfn_array[i];
+    }
+
+    g_stats.inflated += n;
+    balloon_set_actual(drv, g_stats.actual_pages + n);
+    return n;
+}
+
+/**
+ * Retire les n PFN du sommet de la pile et libère les chunks vidés.
+ */
+static void balloon_chunks_drop(VirtioBalloonDriver *drv, uint32_t n) {
+    while (drv->chunks != NULL) {
+        balloon_chunk_t *chunk = drv->chunks;
+        uint32_t take = (chunk->count < n) ? chunk->count : n;
+        chunk->count -= take;
+        n -= take;
+        if (chunk->count > 0) {
+            break;
+        }
+        drv->chunks = chunk->next;
+        kfree(chunk);
+    }
+}
+
+/**
+ * Rend jusqu'à count pages du balloon au PMM.
+ * @return Nombre de pages rendues
+ */
+static uint32_t balloon_deflate(VirtioBalloonDriver *drv, uint32_t count) {
+    if (count > VIRTIO_BALLOON_ARRAY_PFNS_MAX) {
+        count = VIRTIO_BALLOON_ARRAY_PFNS_MAX;
+    }
+
+    /* Copier les PFN sans les retirer : ils ne quittent les chunks
+     * qu'une fois l'hôte prévenu */
+    uint32_t n = 0;
+    for (balloon_chunk_t *chunk = drv->chunks; chunk != NULL && n < count; chunk = chunk->next) {
+        for (uint32_t i = chunk->count; i > 0 && n < count; i--) {
+            drv->pfn_array[n++] = chunk->pfns[i - 1];
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Avec MUST_TELL_HOST, une page non signalée reste dans le balloon */
+    if (balloon_tell_host(drv, &drv->deflate_vq, n) != 0 &&
+        (drv->features & VIRTIO_BALLOON_F_MUST_TELL_HOST)) {
+        return 0;
+    }
+
+    balloon_chunks_drop(drv, n);
+    for (uint32_t i = 0; i < n; i++) {
+        pmm_free_block(pmm_phys_to_virt((uint64_t)drv->pfn_array[i] << VIRTIO_BALLOON_PFN_SHIFT));
+    }
+
+    g_stats.deflated += n;
+    balloon_set_actual(drv, g_stats.actual_pages - n);
+    return n;
+}
+
+/**
+ * Signale à l'hôte des blocs libres de 2 MiB : ils sont isolés le temps
+ * de l'échange puis rendus au PMM.
+ *
+ * Le PMM ne mémorise pas quels blocs ont déjà été signalés : une passe
+ * n'a lieu que si la mémoire libre a grossi d'au moins un bloc de 2 MiB
+ * depuis la précédente (ou depuis son point bas).
+ */
+static void balloon_report_free(VirtioBalloonDriver *drv) {
+    const uint64_t block_pages = 1ULL << VIRTIO_BALLOON_REPORT_ORDER;
+    uint64_t free_blocks = pmm_get_free_blocks();
+
+    if (free_blocks < drv->report_baseline) {
+        drv->report_baseline = free_blocks;
+    }
+    if (free_blocks < drv->report_baseline + block_pages ||
+        timer_get_uptime_ms() - drv->last_report_ms < VIRTIO_BALLOON_REPORT_INTERVAL_MS) {
+        return;
+    }
+
+    void *blocks[VIRTIO_BALLOON_REPORT_MAX];
+    uint32_t n = 0;
+    while (n < VIRTIO_BALLOON_REPORT_MAX && n < drv->report_vq.num_free &&
+           pmm_get_free_blocks() > VIRTIO_BALLOON_MIN_FREE + block_pages) {
+        void *block = pmm_alloc_blocks(block_pages);
+        if (block == NULL) {
+            break;
+        }
+        blocks[n++] = block;
+    }
+
+    uint32_t queued = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (virtio_queue_add_buf_dma(&drv->report_vq, blocks[i], pmm_virt_to_phys(blocks[i]),
+                                     (uint32_t)(block_pages * PMM_BLOCK_SIZE), true, false) >= 0) {
+            queued++;
+        }
+    }
+    if (queued > 0) {
+        virtio_notify(drv->vdev, &drv->report_vq);
+        if (balloon_wait_used(drv, &drv->report_vq, queued) == 0) {
+            g_stats.reported += queued * block_pages;
+        }
+    }
+
+    /* Un hôte muet garde peut-être les buffers : les blocs restent isolés */
+    if (!drv->failed) {
+        for (uint32_t i = 0; i < n; i++) {
+            pmm_free_blocks(blocks[i], block_pages);
+        }
+    }
+
+    drv->report_baseline = pmm_get_free_blocks();
+    drv->last_report_ms = timer_get_uptime_ms();
+}
+
+/* Libère un driver dont l'initialisation a échoué */
+static int balloon_init_fail(VirtioBalloonDriver *drv) {
+    dma_free_coherent(drv->pfn_array, VIRTIO_BALLOON_ARRAY_PFNS_MAX * sizeof(uint32_t));
+    virtio_destroy(drv->vdev);
+    kfree(drv);
+    return -1;
+}
+
+/**
+ * Callback du PMM sous VIRTIO_BALLOON_OOM_FREE blocs libres : réveille le
+ * thread s'il a des pages à rendre.
+ */
+static void balloon_pressure_kick(void) {
+    if (g_stats.actual_pages > 0) {
+        sem_post(&balloon_sem);
+    }
+}
+
+/**
+ * Thread "balloon" : suit la cible de l'hôte par lots, rend la mémoire en
+ * cas de manque (DEFLATE_ON_OOM) et signale les pages libres.
+ *
+ * Les queues sont en polling et la cible n'est connue qu'en relisant la
+ * configuration : entre deux lectures sans changement, l'attente double
+ * jusqu'à VIRTIO_BALLOON_POLL_MAX_MS. Un manque de mémoire réveille le
+ * thread aussitôt.
+ */
+static void balloon_thread_func(void *arg) {
+    VirtioBalloonDriver *drv = (VirtioBalloonDriver *)arg;
+    uint32_t poll_ms = VIRTIO_BALLOON_POLL_MS;
+
+    while (!drv->failed) {
+        uint32_t target = drv->vdev->ops->read_config32(drv->vdev, VIRTIO_BALLOON_CFG_NUM_PAGES);
+        uint32_t progress = 0;
+
+        mutex_lock(&balloon_mutex);
+        bool changed = (target != g_stats.target_pages);
+        g_stats.target_pages = target;
+        uint32_t actual = g_stats.actual_pages;
+        bool oom = (drv->features & VIRTIO_BALLOON_F_DEFLATE_ON_OOM) &&
+                   pmm_get_free_blocks() < VIRTIO_BALLOON_OOM_FREE;
+
+        if (oom && actual > 0) {
+            progress = balloon_deflate(drv, VIRTIO_BALLOON_ARRAY_PFNS_MAX);
+        } else if (target > actual) {
+            progress = balloon_inflate(drv, target - actual);
+        } else if (target < actual) {
+            progress = balloon_deflate(drv, actual - target);
+        } else if (drv->features & VIRTIO_BALLOON_F_PAGE_REPORTING) {
+            balloon_report_free(drv);
+        }
+        mutex_unlock(&balloon_mutex);
+
+        if (progress != 0) {
+            poll_ms = VIRTIO_BALLOON_POLL_MS;
+            thread_yield();
+            continue;
+        }
+
+        /* Cible atteinte (ou inatteignable) : attendre la prochaine demande */
+        if (changed) {
+            poll_ms = VIRTIO_BALLOON_POLL_MS;
+        } else if (poll_ms < VIRTIO_BALLOON_POLL_MAX_MS) {
+            poll_ms *= 2;
+            if (poll_ms > VIRTIO_BALLOON_POLL_MAX_MS) {
+                poll_ms = VIRTIO_BALLOON_POLL_MAX_MS;
+            }
+        }
+        sem_timedwait(&balloon_sem, poll_ms);
+    }
+}
+
+/* ============================================ */
+/*           API publique                       */
+/* ============================================ */
+
+int virtio_balloon_init(void) {
+    PCIDevice *pci_dev = pci_get_device(VIRTIO_BALLOON_PCI_VENDOR, VIRTIO_BALLOON_PCI_DEVICE_LEGACY);
+    if (pci_dev == NULL) {
+        pci_dev = pci_get_device(VIRTIO_BALLOON_PCI_VENDOR, VIRTIO_BALLOON_PCI_DEVICE_MODERN);
+    }
+    if (pci_dev == NULL) {
+        KLOG_INFO("BALLOON", "No VirtIO balloon device");
+        return -1;
+    }
+
+    KLOG_INFO("BALLOON", "=== VirtIO Balloon Driver ===");
+
+    VirtioDevice *vdev = virtio_create_from_pci(pci_dev);
+    if (vdev == NULL) {
+        KLOG_ERROR("BALLOON", "Failed to create VirtIO device");
+        return -1;
+    }
+    vdev->device_id = VIRTIO_DEVICE_BALLOON;
+
+    VirtioBalloonDriver *drv = (VirtioBalloonDriver *)kmalloc(sizeof(VirtioBalloonDriver));
+    if (drv == NULL) {
+        virtio_destroy(vdev);
+        return -1;
+    }
+    drv->vdev = vdev;
+    drv->chunks = NULL;
+    drv->failed = false;
+    drv->report_baseline = 0;
+    drv->last_report_ms = 0;
+
+    drv->pfn_array = (uint32_t *)dma_alloc_coherent(VIRTIO_BALLOON_ARRAY_PFNS_MAX * sizeof(uint32_t),
+                                                    &drv->pfn_array_dma);
+    if (drv->pfn_array == NULL) {
+        kfree(drv);
+        virtio_destroy(vdev);
+        return -1;
+    }
+
+    /* Enable Bus Mastering */
+    pci_enable_bus_mastering(pci_dev);
+
+    /* STATS_VQ et FREE_PAGE_HINT ne sont pas demandés : la queue de
+     * reporting est alors la troisième */
+    uint32_t wanted = VIRTIO_BALLOON_F_MUST_TELL_HOST | VIRTIO_BALLOON_F_DEFLATE_ON_OOM |
+                      VIRTIO_BALLOON_F_PAGE_REPORTING;
+    if (virtio_init_device(vdev, wanted) < 0) {
+        KLOG_ERROR("BALLOON", "Device initialization failed!");
+        return balloon_init_fail(drv);
+    }
+    drv->features = vdev->ops->get_features(vdev) & wanted;
+
+    if (virtio_setup_queue(vdev, &drv->inflate_vq, VIRTIO_BALLOON_INFLATE_QUEUE) < 0 ||
+        virtio_setup_queue(vdev, &drv->deflate_vq, VIRTIO_BALLOON_DEFLATE_QUEUE) < 0) {
+        KLOG_ERROR("BALLOON", "Queue setup failed!");
+        return balloon_init_fail(drv);
+    }
+    if ((drv->features & VIRTIO_BALLOON_F_PAGE_REPORTING) &&
+        virtio_setup_queue(vdev, &drv->report_vq, VIRTIO_BALLOON_REPORTING_QUEUE) < 0) {
+        KLOG_WARN("BALLOON", "Reporting queue setup failed, free page reporting disabled");
+        drv->features &= ~VIRTIO_BALLOON_F_PAGE_REPORTING;
+    }
+
+    /* Le driver fonctionne en polling */
+    drv->inflate_vq.avail->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+    drv->deflate_vq.avail->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+    if (drv->features & VIRTIO_BALLOON_F_PAGE_REPORTING) {
+        drv->report_vq.avail->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
+
+    if (virtio_finalize_init(vdev) < 0) {
+        KLOG_ERROR("BALLOON", "Failed to finalize init!");
+        return balloon_init_fail(drv);
+    }
+
+    g_balloon = drv;
+    g_stats.present = true;
+    g_stats.reporting = (drv->features & VIRTIO_BALLOON_F_PAGE_REPORTING) != 0;
+    balloon_set_actual(drv, 0);
+
+    semaphore_init(&balloon_sem, 0, 1);
+    if ((drv->features & VIRTIO_BALLOON_F_DEFLATE_ON_OOM) &&
+        pmm_register_pressure_hook(VIRTIO_BALLOON_OOM_FREE, balloon_pressure_kick) != 0) {
+        KLOG_WARN("BALLOON", "No PMM pressure hook, OOM deflate only on fault");
+    }
+
+    if (thread_create("balloon", balloon_thread_func, drv, THREAD_DEFAULT_STACK_SIZE,
+                      THREAD_PRIORITY_BACKGROUND) == NULL) {
+        KLOG_ERROR("BALLOON", "Failed to create balloon thread");
+        return -1;
+    }
+
+    KLOG_INFO_HEX("BALLOON", "Driver ready, features: ", drv->features);
+    return 0;
+
+}
+
+uint32_t virtio_balloon_deflate(uint32_t pages) {
+    VirtioBalloonDriver *drv = g_balloon;
+    if (drv == NULL) {
+        return 0;
+    }
+
+    /* Sans DEFLATE_ON_OOM, l'hôte seul décide de rendre la mémoire */
+    if (!(drv->features & VIRTIO_BALLOON_F_DEFLATE_ON_OOM)) {
+        return 0;
+    }
+
+    uint32_t total = 0;
+    mutex_lock(&balloon_mutex);
+    while (total < pages && !drv->failed) {
+        uint32_t n = balloon_deflate(drv, pages - total);
+        if (n == 0) {
+            break;
+        }
+        total += n;
+    }
+    mutex_unlock(&balloon_mutex);
+
+    return total;
+}
+
+void virtio_balloon_get_stats(virtio_balloon_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    *stats = g_stats;
+}
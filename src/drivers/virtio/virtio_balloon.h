@@ -0,0 +1,117 @@
+/* src/drivers/virtio/virtio_balloon.h - VirtIO Memory Balloon Driver
+ *
+ * Le balloon permet à l'hôte de reprendre la mémoire d'un invité inactif
+ * sans le redémarrer :
+ * - Inflate : l'hôte demande num_pages pages ; le driver les retire du PMM
+ *   et transmet leurs PFN à l'hôte, qui peut libérer la mémoire derrière.
+ * - Deflate : quand la cible baisse (ou que l'invité manque de mémoire avec
+ *   DEFLATE_ON_OOM), les pages sont rendues à l'hôte puis au PMM.
+ * - Free page reporting (optionnel) : des blocs libres de 2 MiB sont
+ *   signalés à l'hôte puis rendus aussitôt au PMM.
+ *
+ * Le driver repose sur l'abstraction virtio_transport (PCI legacy/modern,
+ * MMIO) et fonctionne en polling depuis le thread "balloon", que le PMM
+ * réveille en cas de manque de mémoire.
+ */
+
+#ifndef VIRTIO_BALLOON_H
+#define VIRTIO_BALLOON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================ */
+/*           Constantes VirtIO Balloon          */
+/* ============================================ */
+
+/* PCI Vendor/Device IDs (transitional et modern) */
+#define VIRTIO_BALLOON_PCI_VENDOR           0x1AF4
+#define VIRTIO_BALLOON_PCI_DEVICE_LEGACY    0x1002
+#define VIRTIO_BALLOON_PCI_DEVICE_MODERN    0x1045
+
+/* Feature bits */
+#define VIRTIO_BALLOON_F_MUST_TELL_HOST     (1 << 0)
+#define VIRTIO_BALLOON_F_STATS_VQ           (1 << 1)
+#define VIRTIO_BALLOON_F_DEFLATE_ON_OOM     (1 << 2)
+#define VIRTIO_BALLOON_F_FREE_PAGE_HINT     (1 << 3)
+#define VIRTIO_BALLOON_F_PAGE_POISON        (1 << 4)
+#define VIRTIO_BALLOON_F_PAGE_REPORTING     (1 << 5)
+
+/* Configuration space */
+#define VIRTIO_BALLOON_CFG_NUM_PAGES        0x00    /* Cible demandée par l'hôte */
+#define VIRTIO_BALLOON_CFG_ACTUAL           0x04    /* Pages effectivement cédées */
+
+/* Index des queues (sans STATS_VQ ni FREE_PAGE_HINT) */
+#define VIRTIO_BALLOON_INFLATE_QUEUE        0
+#define VIRTIO_BALLOON_DEFLATE_QUEUE        1
+#define VIRTIO_BALLOON_REPORTING_QUEUE      2
+
+/* Les PFN échangés sont toujours en pages de 4 KiB */
+#define VIRTIO_BALLOON_PFN_SHIFT            12
+#define VIRTIO_BALLOON_ARRAY_PFNS_MAX       256
+
+/* ============================================ */
+/*           Configuration du driver            */
+/* ============================================ */
+
+/* Période de lecture de la cible : POLL_MS après un changement, puis
+ * doublée à chaque lecture inchangée jusqu'à POLL_MAX_MS */
+#define VIRTIO_BALLOON_POLL_MS              200
+#define VIRTIO_BALLOON_POLL_MAX_MS          3200
+
+/* Délai maximal d'attente d'une réponse de l'hôte */
+#define VIRTIO_BALLOON_TIMEOUT_MS           1000
+
+/* Jamais d'inflate sous ce nombre de blocs libres */
+#define VIRTIO_BALLOON_MIN_FREE             2048
+
+/* Deflate (DEFLATE_ON_OOM) sous ce seuil, nettement plus bas que le
+ * précédent : un inflate arrêté à MIN_FREE ne déclenche pas de deflate */
+#define VIRTIO_BALLOON_OOM_FREE             (VIRTIO_BALLOON_MIN_FREE / 2)
+
+/* Free page reporting : blocs de 2^ORDER pages, au plus REPORT_MAX par passe */
+#define VIRTIO_BALLOON_REPORT_ORDER         9
+#define VIRTIO_BALLOON_REPORT_MAX           32
+#define VIRTIO_BALLOON_REPORT_INTERVAL_MS   2000
+
+/**
+ * Statistiques (commande meminfo).
+ */
+typedef struct {
+    bool present;               /* Device détecté et initialisé */
+    bool reporting;             /* Free page reporting négocié */
+    uint32_t target_pages;      /* Dernière cible lue (num_pages) */
+    uint32_t actual_pages;      /* Pages actuellement dans le balloon */
+    uint64_t inflated;          /* Pages cédées depuis le boot */
+    uint64_t deflated;          /* Pages rendues depuis le boot */
+    uint64_t reported;          /* Pages libres signalées depuis le boot */
+} virtio_balloon_stats_t;
+
+/* ============================================ */
+/*           API publique                       */
+/* ============================================ */
+
+/**
+ * Détecte le device balloon sur le bus PCI, l'initialise et démarre le
+ * thread "balloon". Appelé une fois le scheduler démarré.
+ *
+ * @return 0 si succès, -1 si absent ou échec
+ */
+int virtio_balloon_init(void);
+
+/**
+ * Rend immédiatement au PMM jusqu'à pages pages du balloon (mémoire
+ * nécessaire d'urgence, appelé par le fault handler avant zram). L'hôte
+ * est prévenu avant toute réutilisation. Sans effet si DEFLATE_ON_OOM n'a
+ * pas été négocié. Peut bloquer : contexte thread uniquement.
+ *
+ * @return Nombre de pages rendues
+ */
+uint32_t virtio_balloon_deflate(uint32_t pages);
+
+/**
+ * Copie les statistiques courantes.
+ */
+void virtio_balloon_get_stats(virtio_balloon_stats_t *stats);
+
+#endif /* VIRTIO_BALLOON_H */
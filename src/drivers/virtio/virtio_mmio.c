@@ -7,7 +7,7 @@
 #include "virtio_mmio.h"
 #include "../../kernel/mmio/mmio.h"
 #include "../../mm/kheap.h"
-#include "../../mm/pmm.h"
+#include "../../mm/dma.h"
 #include "../../kernel/klog.h"
 #include "../../kernel/console.h"
 
@@ -263,21 +263,16 @@ int virtio_mmio_setup_queue(VirtioMmioDevice *dev, VirtioMmioQueue *queue, uint1
     uint32_t total_size = desc_size + avail_size + used_size;
     total_size = (total_size + 4095) & ~4095; /* Aligner sur page */
     
-    void *queue_mem = pmm_alloc_blocks((total_size + 4095) / 4096);
+    dma_addr_t queue_dma;
+    void *queue_mem = dma_alloc_coherent(total_size, &queue_dma);
     if (queue_mem == NULL) {
         KLOG_ERROR("VIRTIO_MMIO", "Failed to allocate queue memory");
         return -1;
     }
     
-    /* Mettre à zéro */
-    uint8_t *ptr = (uint8_t *)queue_mem;
-    for (uint32_t i = 0; i < total_size; i++) {
-        ptr[i] = 0;
-    }
-    
     /* Assigner les pointeurs */
     queue->desc = queue_mem;
-    queue->desc_phys = (uint32_t)(uintptr_t)queue_mem;
+    queue->desc_phys = queue_dma;
     
     queue->avail = (uint8_t *)queue_mem + desc_size;
     queue->avail_phys = queue->desc_phys + desc_size;
@@ -304,14 +299,14 @@ int virtio_mmio_setup_queue(VirtioMmioDevice *dev, VirtioMmioQueue *queue, uint1
         /* VirtIO 1.0+ : adresses 64-bit séparées */
         virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_NUM, queue_size);
         
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_LOW, queue->desc_phys);
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_HIGH, 0);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_LOW, (uint32_t)queue->desc_phys);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_DESC_HIGH, (uint32_t)(queue->desc_phys >> 32));
         
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_AVAIL_LOW, queue->avail_phys);
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_AVAIL_HIGH, 0);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_AVAIL_LOW, (uint32_t)queue->avail_phys);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_AVAIL_HIGH, (uint32_t)(queue->avail_phys >> 32));
         
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_USED_LOW, queue->used_phys);
-        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_USED_HIGH, 0);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_USED_LOW, (uint32_t)queue->used_phys);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_USED_HIGH, (uint32_t)(queue->used_phys >> 32));
         
         /* Activer la queue */
         virtio_mmio_write32(dev, VIRTIO_MMIO_QUEUE_READY, 1);
@@ -320,7 +315,7 @@ int virtio_mmio_setup_queue(VirtioMmioDevice *dev, VirtioMmioQueue *queue, uint1
         virtio_mmio_write32(dev, VIRTIO_MMIO_LEGACY_GUEST_PAGE_SIZE, 4096);
         virtio_mmio_write32(dev, VIRTIO_MMIO_LEGACY_QUEUE_NUM, queue_size);
         virtio_mmio_write32(dev, VIRTIO_MMIO_LEGACY_QUEUE_ALIGN, 4096);
-        virtio_mmio_write32(dev, VIRTIO_MMIO_LEGACY_QUEUE_PFN, queue->desc_phys / 4096);
+        virtio_mmio_write32(dev, VIRTIO_MMIO_LEGACY_QUEUE_PFN, (uint32_t)(queue->desc_phys / 4096));
     }
     
     KLOG_INFO("VIRTIO_MMIO", "Queue setup complete");
@@ -131,10 +131,10 @@ typedef struct {
     uint16_t index;             /* Index de la queue */
     uint16_t size;              /* Nombre d'entrées */
     
-    /* Adresses physiques des structures */
-    uint32_t desc_phys;         /* Descriptor Table */
-    uint32_t avail_phys;        /* Available Ring */
-    uint32_t used_phys;         /* Used Ring */
+    /* Adresses physiques (bus) des structures */
+    uint64_t desc_phys;         /* Descriptor Table */
+    uint64_t avail_phys;        /* Available Ring */
+    uint64_t used_phys;         /* Used Ring */
     
     /* Pointeurs virtuels */
     void *desc;
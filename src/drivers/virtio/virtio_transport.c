@@ -11,6 +11,7 @@
 #include "../../kernel/mmio/pci_mmio.h"
 #include "../../mm/kheap.h"
 #include "../../mm/pmm.h"
+#include "../../mm/dma.h"
 #include "../../kernel/klog.h"
 #include "../../kernel/console.h"
 #include "../../arch/x86_64/io.h"
@@ -115,22 +116,18 @@ static int pci_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t index) {
     uint32_t total_size = used_offset + used_size;
     total_size = (total_size + 4095) & ~4095;
     
-    /* Allouer la mémoire */
-    void *queue_mem = pmm_alloc_blocks((total_size + 4095) / 4096);
+    /* Allouer la mémoire (physiquement contiguë, mise à zéro) */
+    dma_addr_t queue_dma;
+    void *queue_mem = dma_alloc_coherent(total_size, &queue_dma);
     if (queue_mem == NULL) {
         KLOG_ERROR("VIRTIO_PCI", "Failed to allocate queue memory");
         return -1;
     }
-    
-    /* Mettre à zéro */
-    uint8_t *ptr = (uint8_t *)queue_mem;
-    for (uint32_t i = 0; i < total_size; i++) {
-        ptr[i] = 0;
-    }
+    vq->mem_size = total_size;
     
     /* Assigner les pointeurs */
     vq->desc = (VirtqDesc *)queue_mem;
-    vq->desc_phys = (uint32_t)(uintptr_t)queue_mem;
+    vq->desc_phys = queue_dma;
     
     vq->avail = (VirtqAvail *)((uint8_t *)queue_mem + avail_offset);
     vq->avail_phys = vq->desc_phys + avail_offset;
@@ -155,7 +152,7 @@ static int pci_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t index) {
     }
     
     /* Configurer la queue dans le device (PFN = Page Frame Number) */
-    uint32_t pfn = vq->desc_phys / 4096;
+    uint32_t pfn = (uint32_t)(vq->desc_phys / 4096);
     dev->ops->write32(dev, PCI_LEGACY_QUEUE_ADDRESS, pfn);
     
     KLOG_INFO_HEX("VIRTIO_PCI", "Queue configured, PFN: ", pfn);
@@ -179,6 +176,10 @@ static uint32_t pci_read_config32(VirtioDevice *dev, uint16_t offset) {
     return dev->ops->read32(dev, PCI_LEGACY_CONFIG_START + offset);
 }
 
+static void pci_write_config32(VirtioDevice *dev, uint16_t offset, uint32_t val) {
+    dev->ops->write32(dev, PCI_LEGACY_CONFIG_START + offset, val);
+}
+
 static uint32_t pci_ack_interrupt(VirtioDevice *dev) {
     return dev->ops->read8(dev, PCI_LEGACY_ISR_STATUS);
 }
@@ -201,6 +202,7 @@ static const VirtioTransportOps pci_pio_ops = {
     .read_config8 = pci_read_config8,
     .read_config16 = pci_read_config16,
     .read_config32 = pci_read_config32,
+    .write_config32 = pci_write_config32,
     .ack_interrupt = pci_ack_interrupt,
 };
 
@@ -258,6 +260,7 @@ static const VirtioTransportOps pci_mmio_ops = {
     .read_config8 = pci_read_config8,
     .read_config16 = pci_read_config16,
     .read_config32 = pci_read_config32,
+    .write_config32 = pci_write_config32,
     .ack_interrupt = pci_ack_interrupt,
 };
 
@@ -362,22 +365,18 @@ static int pci_modern_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t ind
     uint32_t total_size = used_offset + used_size;
     total_size = (total_size + 4095) & ~4095;
     
-    /* Allouer la mémoire */
-    void *queue_mem = pmm_alloc_blocks((total_size + 4095) / 4096);
+    /* Allouer la mémoire (physiquement contiguë, mise à zéro) */
+    dma_addr_t queue_dma;
+    void *queue_mem = dma_alloc_coherent(total_size, &queue_dma);
     if (queue_mem == NULL) {
         KLOG_ERROR("VIRTIO_MODERN", "Failed to allocate queue memory");
         return -1;
     }
-    
-    /* Mettre à zéro */
-    uint8_t *ptr = (uint8_t *)queue_mem;
-    for (uint32_t i = 0; i < total_size; i++) {
-        ptr[i] = 0;
-    }
+    vq->mem_size = total_size;
     
     /* Assigner les pointeurs */
     vq->desc = (VirtqDesc *)queue_mem;
-    vq->desc_phys = (uint32_t)(uintptr_t)queue_mem;
+    vq->desc_phys = queue_dma;
     
     vq->avail = (VirtqAvail *)((uint8_t *)queue_mem + avail_offset);
     vq->avail_phys = vq->desc_phys + avail_offset;
@@ -410,18 +409,18 @@ static int pci_modern_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t ind
     mmiowb();
     
     /* Descriptor table address */
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_DESCLO, vq->desc_phys);
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_DESCHI, 0);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_DESCLO, (uint32_t)vq->desc_phys);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_DESCHI, (uint32_t)(vq->desc_phys >> 32));
     mmiowb();
     
     /* Available ring address */
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_AVAILLO, vq->avail_phys);
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_AVAILHI, 0);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_AVAILLO, (uint32_t)vq->avail_phys);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_AVAILHI, (uint32_t)(vq->avail_phys >> 32));
     mmiowb();
     
     /* Used ring address */
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_USEDLO, vq->used_phys);
-    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_USEDHI, 0);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_USEDLO, (uint32_t)vq->used_phys);
+    mmio_write32_off(cfg, VIRTIO_PCI_COMMON_Q_USEDHI, (uint32_t)(vq->used_phys >> 32));
     mmiowb();
     
     /* Lire et cacher le notify_offset pour cette queue */
@@ -468,6 +467,14 @@ static uint32_t pci_modern_read_config32(VirtioDevice *dev, uint16_t offset) {
     return mmio_read32_off(dev->transport.pci.device_cfg, offset);
 }
 
+static void pci_modern_write_config32(VirtioDevice *dev, uint16_t offset, uint32_t val) {
+    if (dev->transport.pci.device_cfg == NULL) {
+        return;
+    }
+    mmio_write32_off(dev->transport.pci.device_cfg, offset, val);
+    mmiowb();
+}
+
 static uint32_t pci_modern_ack_interrupt(VirtioDevice *dev) {
     if (dev == NULL || dev->transport.pci.isr == NULL) {
         return 0;
@@ -495,6 +502,7 @@ static const VirtioTransportOps pci_modern_ops = {
     .read_config8 = pci_modern_read_config8,
     .read_config16 = pci_modern_read_config16,
     .read_config32 = pci_modern_read_config32,
+    .write_config32 = pci_modern_write_config32,
     .ack_interrupt = pci_modern_ack_interrupt,
 };
 
@@ -592,22 +600,18 @@ static int virtio_mmio_setup_vq(VirtioDevice *dev, VirtQueue *vq, uint16_t index
     uint32_t total_size = used_offset + used_size;
     total_size = (total_size + 4095) & ~4095;
     
-    /* Allouer la mémoire */
-    void *queue_mem = pmm_alloc_blocks((total_size + 4095) / 4096);
+    /* Allouer la mémoire (physiquement contiguë, mise à zéro) */
+    dma_addr_t queue_dma;
+    void *queue_mem = dma_alloc_coherent(total_size, &queue_dma);
     if (queue_mem == NULL) {
         KLOG_ERROR("VIRTIO_MMIO", "Failed to allocate queue memory");
         return -1;
     }
-    
-    /* Mettre à zéro */
-    uint8_t *ptr = (uint8_t *)queue_mem;
-    for (uint32_t i = 0; i < total_size; i++) {
-        ptr[i] = 0;
-    }
+    vq->mem_size = total_size;
     
     /* Assigner les pointeurs */
     vq->desc = (VirtqDesc *)queue_mem;
-    vq->desc_phys = (uint32_t)(uintptr_t)queue_mem;
+    vq->desc_phys = queue_dma;
     
     vq->avail = (VirtqAvail *)((uint8_t *)queue_mem + avail_offset);
     vq->avail_phys = vq->desc_phys + avail_offset;
@@ -634,19 +638,19 @@ static int virtio_mmio_setup_vq(VirtioDevice *dev, VirtQueue *vq, uint16_t index
     if (dev->transport.mmio.version == 2) {
         /* VirtIO 1.0+ */
         mmio_write32_off(base, VIRTIO_MMIO_QUEUE_NUM, queue_size);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_DESC_LOW, vq->desc_phys);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_DESC_HIGH, 0);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_AVAIL_LOW, vq->avail_phys);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_AVAIL_HIGH, 0);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_USED_LOW, vq->used_phys);
-        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_USED_HIGH, 0);
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_DESC_LOW, (uint32_t)vq->desc_phys);
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_DESC_HIGH, (uint32_t)(vq->desc_phys >> 32));
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_AVAIL_LOW, (uint32_t)vq->avail_phys);
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_AVAIL_HIGH, (uint32_t)(vq->avail_phys >> 32));
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_USED_LOW, (uint32_t)vq->used_phys);
+        mmio_write32_off(base, VIRTIO_MMIO_QUEUE_USED_HIGH, (uint32_t)(vq->used_phys >> 32));
         mmio_write32_off(base, VIRTIO_MMIO_QUEUE_READY, 1);
     } else {
         /* Legacy */
         mmio_write32_off(base, VIRTIO_MMIO_LEGACY_GUEST_PAGE_SIZE, 4096);
         mmio_write32_off(base, VIRTIO_MMIO_LEGACY_QUEUE_NUM, queue_size);
         mmio_write32_off(base, VIRTIO_MMIO_LEGACY_QUEUE_ALIGN, 4096);
-        mmio_write32_off(base, VIRTIO_MMIO_LEGACY_QUEUE_PFN, vq->desc_phys / 4096);
+        mmio_write32_off(base, VIRTIO_MMIO_LEGACY_QUEUE_PFN, (uint32_t)(vq->desc_phys / 4096));
     }
     
     return 0;
@@ -668,6 +672,10 @@ static uint32_t virtio_mmio_read_cfg32(VirtioDevice *dev, uint16_t offset) {
     return mmio_read32_off(dev->transport.mmio.base, VIRTIO_MMIO_CONFIG + offset);
 }
 
+static void virtio_mmio_write_cfg32(VirtioDevice *dev, uint16_t offset, uint32_t val) {
+    mmio_write32_off(dev->transport.mmio.base, VIRTIO_MMIO_CONFIG + offset, val);
+}
+
 static uint32_t virtio_mmio_ack_int(VirtioDevice *dev) {
     uint32_t status = mmio_read32_off(dev->transport.mmio.base, VIRTIO_MMIO_INTERRUPT_STATUS);
     if (status) {
@@ -694,6 +702,7 @@ static const VirtioTransportOps mmio_ops = {
     .read_config8 = virtio_mmio_read_cfg8,
     .read_config16 = virtio_mmio_read_cfg16,
     .read_config32 = virtio_mmio_read_cfg32,
+    .write_config32 = virtio_mmio_write_cfg32,
     .ack_interrupt = virtio_mmio_ack_int,
 };
 
@@ -954,6 +963,15 @@ int virtio_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t index) {
 
 int virtio_queue_add_buf(VirtQueue *vq, void *buf, uint32_t len, 
                          bool device_writable, bool has_next) {
+    if (buf == NULL) {
+        return -1;
+    }
+    return virtio_queue_add_buf_dma(vq, buf, dma_virt_to_bus(buf), len,
+                                    device_writable, has_next);
+}
+
+int virtio_queue_add_buf_dma(VirtQueue *vq, void *buf, uint64_t dma, uint32_t len,
+                             bool device_writable, bool has_next) {
     if (vq == NULL || buf == NULL || vq->num_free == 0) {
         return -1;
     }
@@ -962,7 +980,7 @@ int virtio_queue_add_buf(VirtQueue *vq, void *buf, uint32_t len,
     VirtqDesc *desc = &vq->desc[idx];
     
     /* Configurer le descriptor */
-    desc->addr = (uint64_t)(uint32_t)(uintptr_t)buf;
+    desc->addr = dma;
     desc->len = len;
     desc->flags = 0;
     if (device_writable) {
@@ -1006,6 +1024,10 @@ bool virtio_queue_has_used(VirtQueue *vq) {
 }
 
 void *virtio_queue_get_used(VirtQueue *vq, uint32_t *len) {
+    return virtio_queue_get_used_dma(vq, len, NULL);
+}
+
+void *virtio_queue_get_used_dma(VirtQueue *vq, uint32_t *len, uint64_t *dma) {
     if (vq == NULL || !virtio_queue_has_used(vq)) {
         return NULL;
     }
@@ -1020,6 +1042,9 @@ void *virtio_queue_get_used(VirtQueue *vq, uint32_t *len) {
     if (len) {
         *len = elem->len;
     }
+    if (dma) {
+        *dma = vq->desc[desc_idx].addr;
+    }
     
     void *buf = vq->buffers[desc_idx];
     vq->buffers[desc_idx] = NULL;
@@ -42,6 +42,7 @@ typedef enum {
 #define VIRTIO_DEVICE_BLOCK             2
 #define VIRTIO_DEVICE_CONSOLE           3
 #define VIRTIO_DEVICE_ENTROPY           4
+#define VIRTIO_DEVICE_BALLOON           5
 
 /* Network device features */
 #define VIRTIO_NET_F_CSUM               (1 << 0)
@@ -59,6 +60,9 @@ typedef enum {
 #define VIRTQ_DESC_F_WRITE              2   /* Buffer is write-only (device writes) */
 #define VIRTQ_DESC_F_INDIRECT           4   /* Buffer contains list of descriptors */
 
+/* Available ring flags */
+#define VIRTQ_AVAIL_F_NO_INTERRUPT      1   /* Pas d'interruption à la consommation */
+
 /* Virtqueue Descriptor */
 typedef struct {
     uint64_t addr;      /* Adresse physique du buffer */
@@ -100,10 +104,11 @@ typedef struct {
     VirtqAvail *avail;          /* Available Ring */
     VirtqUsed *used;            /* Used Ring */
     
-    /* Adresses physiques */
-    uint32_t desc_phys;
-    uint32_t avail_phys;
-    uint32_t used_phys;
+    /* Adresses physiques (bus) */
+    uint64_t desc_phys;
+    uint64_t avail_phys;
+    uint64_t used_phys;
+    uint32_t mem_size;          /* Taille de la zone DMA des anneaux */
     
     /* État de la queue */
     uint16_t free_head;         /* Premier descriptor libre */
@@ -148,6 +153,7 @@ typedef struct {
     uint8_t  (*read_config8)(struct virtio_device *dev, uint16_t offset);
     uint16_t (*read_config16)(struct virtio_device *dev, uint16_t offset);
     uint32_t (*read_config32)(struct virtio_device *dev, uint16_t offset);
+    void     (*write_config32)(struct virtio_device *dev, uint16_t offset, uint32_t val);
     
     /* Interruptions */
     uint32_t (*ack_interrupt)(struct virtio_device *dev);
@@ -236,6 +242,14 @@ int virtio_setup_queue(VirtioDevice *dev, VirtQueue *vq, uint16_t index);
 int virtio_queue_add_buf(VirtQueue *vq, void *buf, uint32_t len, 
                          bool device_writable, bool has_next);
 
+/**
+ * Ajoute un buffer dont l'adresse bus est déjà connue (dma_pool,
+ * dma_alloc_coherent) : aucune traduction d'adresse sur le chemin rapide.
+ * @return Index du descriptor, ou -1 si échec
+ */
+int virtio_queue_add_buf_dma(VirtQueue *vq, void *buf, uint64_t dma, uint32_t len,
+                             bool device_writable, bool has_next);
+
 /**
  * Notifie le device qu'une queue a de nouveaux buffers.
  */
@@ -252,6 +266,12 @@ bool virtio_queue_has_used(VirtQueue *vq);
  */
 void *virtio_queue_get_used(VirtQueue *vq, uint32_t *len);
 
+/**
+ * Récupère un buffer consommé ainsi que son adresse bus.
+ * @return Pointeur vers le buffer, ou NULL si aucun
+ */
+void *virtio_queue_get_used_dma(VirtQueue *vq, uint32_t *len, uint64_t *dma);
+
 /**
  * Reset le device.
  */
@@ -3,6 +3,7 @@
 #include "vfs.h"
 #include "../drivers/ata.h"
 #include "../mm/kheap.h"
+#include "../mm/kmem_cache.h"
 #include "../kernel/klog.h"
 
 /* ===========================================
@@ -10,6 +11,7 @@
  * =========================================== */
 static vfs_filesystem_t ext2_fs_type;
 static vfs_dirent_t ext2_dirent;  /* Dirent statique pour readdir */
+static kmem_cache_t* ext2_node_cache = NULL;  /* Noeuds VFS créés par finddir */
 
 /* ===========================================
  * Fonctions utilitaires
@@ -1011,27 +1013,39 @@ static uint32_t ext2_ftype_to_vfs(uint8_t file_type)
 /* Forward declarations pour les callbacks VFS */
 static int ext2_vfs_mkdir(vfs_node_t* parent, const char* name);
 
+/* Libère un noeud VFS créé par ext2_create_node */
+static void ext2_free_node(vfs_node_t* node)
+{
+    if (node->fs_data) kfree(node->fs_data);
+    kmem_cache_free(ext2_node_cache, node);
+}
+
 /* Crée un noeud VFS à partir d'un inode Ext2 */
 static vfs_node_t* ext2_create_node(ext2_fs_t* fs, uint32_t inode_num, const char* name)
 {
-    vfs_node_t* node = (vfs_node_t*)kmalloc(sizeof(vfs_node_t));
+    if (ext2_node_cache == NULL) {
+        ext2_node_cache = kmem_cache_create("ext2_node", sizeof(vfs_node_t), 0, NULL);
+        if (ext2_node_cache == NULL) return NULL;
+    }
+    
+    vfs_node_t* node = (vfs_node_t*)kmem_cache_alloc(ext2_node_cache);
     if (node == NULL) return NULL;
     
     memset(node, 0, sizeof(vfs_node_t));
     
     ext2_node_data_t* data = (ext2_node_data_t*)kmalloc(sizeof(ext2_node_data_t));
     if (data == NULL) {
-        kfree(node);
+        kmem_cache_free(ext2_node_cache, node);
         return NULL;
     }
     
     data->fs = fs;
     data->inode_num = inode_num;
+    node->fs_data = data;
     
     /* Lire l'inode */
     if (ext2_read_inode(fs, inode_num, &data->inode) != 0) {
-        kfree(data);
-        kfree(node);
+        ext2_free_node(node);
         return NULL;
     }
     
@@ -1052,7 +1066,6 @@ static vfs_node_t* ext2_create_node(ext2_fs_t* fs, uint32_t inode_num, const cha
     node->atime = data->inode.i_atime;
     node->mtime = data->inode.i_mtime;
     node->ctime = data->inode.i_ctime;
-    node->fs_data = data;
     node->refcount = 0;
     
     /* Callbacks */
@@ -1411,6 +1424,7 @@ int ext2_vfs_create(vfs_node_t* parent, const char* name, uint32_t type)
     vfs_node_t* existing = ext2_vfs_finddir(parent, name);
     if (existing != NULL) {
         /* Le nom existe déjà */
+        ext2_free_node(existing);
         return -1;
     }
     
@@ -1479,6 +1493,7 @@ static int ext2_vfs_mkdir(vfs_node_t* parent, const char* name)
     vfs_node_t* existing = ext2_vfs_finddir(parent, name);
     if (existing != NULL) {
         /* Le nom existe déjà */
+        ext2_free_node(existing);
         return -1;
     }
     
@@ -1680,8 +1695,7 @@ int ext2_vfs_unlink(vfs_node_t* parent, const char* name)
         if (empty != 1) {
             KLOG_ERROR("EXT2", "unlink: directory not empty");
             /* Libérer le noeud cible */
-            if (target->fs_data) kfree(target->fs_data);
-            kfree(target);
+            ext2_free_node(target);
             return -1;
         }
     }
@@ -1691,8 +1705,7 @@ int ext2_vfs_unlink(vfs_node_t* parent, const char* name)
                                                    parent_data->inode_num, name);
     if (removed_inode < 0) {
         KLOG_ERROR("EXT2", "unlink: failed to remove dir entry");
-        if (target->fs_data) kfree(target->fs_data);
-        kfree(target);
+        ext2_free_node(target);
         return -1;
     }
     
@@ -1734,8 +1747,7 @@ int ext2_vfs_unlink(vfs_node_t* parent, const char* name)
     }
     
     /* Libérer le noeud VFS cible */
-    if (target->fs_data) kfree(target->fs_data);
-    kfree(target);
+    ext2_free_node(target);
     
     klog(LOG_INFO, "EXT2", "Removed: ");
     klog(LOG_INFO, "EXT2", name);
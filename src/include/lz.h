@@ -0,0 +1,43 @@
+/* src/include/lz.h - Compression LZ77 rapide (format proche de LZ4) */
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Format : une suite de séquences [token][littéraux][offset][longueur].
+ *   - token : 4 bits hauts = nombre de littéraux, 4 bits bas = longueur du
+ *     match moins LZ_MIN_MATCH ; 15 signifie "suivi d'octets de longueur"
+ *     (255 = continuer).
+ *   - offset : 2 octets little-endian, distance du match en arrière.
+ * La dernière séquence ne contient que des littéraux.
+ *
+ * Pensé pour des pages de 4 KiB : une passe, table de hachage fournie par
+ * l'appelant (pas d'allocation, utilisable sous spinlock).
+ */
+
+#define LZ_HASH_BITS        12
+#define LZ_HASH_SIZE        (1 << LZ_HASH_BITS)
+#define LZ_MIN_MATCH        4
+#define LZ_MAX_INPUT        65536
+
+/**
+ * Compresse src dans dst.
+ *
+ * @param table  Table de travail de LZ_HASH_SIZE entrées
+ * @return Taille compressée, ou 0 si elle dépasserait dst_cap
+ *         (ou si src_len > LZ_MAX_INPUT)
+ */
+size_t lz_compress(const void* src, size_t src_len, void* dst, size_t dst_cap,
+                   uint16_t* table);
+
+/**
+ * Décompresse src dans dst.
+ *
+ * @return Taille décompressée, ou -1 si les données sont corrompues ou ne
+ *         tiennent pas dans dst_cap
+ */
+int lz_decompress(const void* src, size_t src_len, void* dst, size_t dst_cap);
+
+#endif /* LZ_H */
@@ -19,11 +19,15 @@
  * 0x0000000000000000 - 0x00007FFFFFFFFFFF : User space (128 TB)
  * 0xFFFF800000000000 - 0xFFFF87FFFFFFFFFF : HHDM (Limine) - 8 TB
  * 0xFFFF900000000000 - 0xFFFF9FFFFFFFFFFF : MMIO Zone - 16 TB (PML4 #274-275)
+ * 0xFFFFA00000000000 - 0xFFFFA0FFFFFFFFFF : Kernel Heap (kmalloc) - 1 TB (PML4 #320-321)
+ * 0xFFFFA10000000000 - 0xFFFFA1000FFFFFFF : Kernel Stacks - 256 MB (PML4 #322)
  * 0xFFFFFFFF80000000 - 0xFFFFFFFFFFFFFFFF : Kernel code (mcmodel=kernel)
  *
  * Index PML4 pour référence:
  *   #256 = 0xFFFF800000000000 (HHDM start)
  *   #274 = 0xFFFF900000000000 (MMIO zone - SAFE)
+ *   #320 = 0xFFFFA00000000000 (Kernel heap - SAFE)
+ *   #322 = 0xFFFFA10000000000 (Kernel stacks - SAFE)
  *   #510 = 0xFFFFFF0000000000 (Recursive mapping - DANGER)
  *   #511 = 0xFFFFFFFF80000000 (Kernel code - DANGER)
  */
@@ -53,6 +57,39 @@
 #define MMIO_VIRT_END           0xFFFFA00000000000ULL  /* 16 TB */
 #define MMIO_VIRT_SIZE          (MMIO_VIRT_END - MMIO_VIRT_BASE)
 
+/* ========================================
+ * Zone Kernel Heap
+ * ======================================== */
+
+/* Zone virtuelle réservée au heap kernel (kmalloc).
+ * Le heap y est mappé page par page à la demande (PMM + vmm_map_page)
+ * et rend ses pages de fin quand elles redeviennent libres.
+ *
+ * Les premières pages sont mappées au boot, avant la création de tout
+ * processus : les PML4 user copient donc l'entrée #320 et partagent
+ * les tables du heap, y compris celles créées plus tard.
+ */
+#define KHEAP_VIRT_BASE         0xFFFFA00000000000ULL
+#define KHEAP_VIRT_END          0xFFFFA10000000000ULL  /* 1 TB */
+#define KHEAP_VIRT_SIZE         (KHEAP_VIRT_END - KHEAP_VIRT_BASE)
+
+/* ========================================
+ * Zone Kernel Stacks
+ * ======================================== */
+
+/* Stacks kernel des threads (voir mm/kstack.h). La zone est découpée en
+ * slots de KSTACK_SLOT_SIZE : la stack occupe le haut du slot, le bas reste
+ * non mappé et sert de guard page (un débordement fait un page fault au
+ * lieu d'écraser la stack voisine).
+ *
+ * Comme pour le heap, des stacks sont mappées au boot afin que l'entrée
+ * PML4 #322 existe avant la création du premier processus.
+ */
+#define KSTACK_VIRT_BASE        0xFFFFA10000000000ULL
+#define KSTACK_SLOT_SIZE        (64 * 1024)
+#define KSTACK_SLOT_COUNT       4096
+#define KSTACK_VIRT_END         (KSTACK_VIRT_BASE + (uint64_t)KSTACK_SLOT_SIZE * KSTACK_SLOT_COUNT)
+
 /* ========================================
  * Zone Kernel
  * ======================================== */
@@ -76,6 +113,15 @@
 #define USER_STACK_TOP          0x00007FFFFFFFE000ULL
 #define USER_STACK_SIZE         (16 * 4096)  /* 64 KB */
 
+/* Zone des mappings anonymes (mmap). Le heap brk grandit depuis la fin de
+ * l'image ELF jusqu'à USER_MMAP_BASE au plus. */
+#define USER_MMAP_BASE          0x0000100000000000ULL
+#define USER_MMAP_END           0x0000700000000000ULL
+
+/* Zone des segments de mémoire partagée (voir kernel/shm.h) */
+#define USER_SHM_BASE           0x0000700000000000ULL
+#define USER_SHM_END            0x0000780000000000ULL
+
 /* ========================================
  * Helpers
  * ======================================== */
@@ -4,6 +4,7 @@
 #include "klog.h"
 #include "../fs/vfs.h"
 #include "../mm/vmm.h"
+#include "../mm/vma.h"
 #include "../mm/pmm.h"
 #include "../mm/kheap.h"
 #include "../include/elf.h"
@@ -178,42 +179,28 @@ int elf_load_file(const char* filename, process_t* proc, elf_load_result_t* resu
         
         KLOG_INFO_DEC("ELF", "  Pages needed: ", num_pages);
         
-        /* Allouer et mapper les pages */
-        for (uint64_t page = 0; page < num_pages; page++) {
-            uint64_t virt_addr = vaddr_start + (page * PAGE_SIZE);
-            
-            /* Vérifier si la page n'est pas déjà mappée */
-            if (!vmm_is_mapped_in_dir(target_dir, virt_addr)) {
-                /* Allouer une page physique (retourne adresse virtuelle HHDM) */
-                void* page_virt = pmm_alloc_block();
-                if (page_virt == NULL) {
-                    KLOG_ERROR("ELF", "Out of physical memory!");
-                    kfree(phdrs);
-                    vfs_close(file);
-                    return ELF_ERR_MEMORY;
-                }
-                
-                /* Convertir en adresse physique pour le mapping */
-                uint64_t page_phys = pmm_virt_to_phys(page_virt);
-                
-                /* Déterminer les flags de la page */
-                uint64_t page_flags = PAGE_PRESENT | PAGE_USER;
-                if (phdr->p_flags & PF_W) {
-                    page_flags |= PAGE_RW;
-                }
-                
-                /* Mapper la page dans le directory cible */
-                if (vmm_map_page_in_dir(target_dir, page_phys, virt_addr, page_flags) != 0) {
-                    KLOG_ERROR("ELF", "Failed to map page!");
-                    pmm_free_block(page_virt);
-                    kfree(phdrs);
-                    vfs_close(file);
-                    return ELF_ERR_MEMORY;
-                }
-                
-                /* Mettre la page à zéro via l'adresse virtuelle HHDM */
-                memset(page_virt, 0, PAGE_SIZE);
-            }
+        /* Déterminer les flags de la page */
+        uint64_t page_flags = PAGE_USER;
+        if (phdr->p_flags & PF_W) {
+            page_flags |= PAGE_RW;
+        }
+        
+        /* Page partagée avec le segment précédent : déjà réservée */
+        if (vma_find(target_dir, vaddr_start) != NULL) {
+            vaddr_start += PAGE_SIZE;
+        }
+        
+        /*
+         * Réserver le segment sans l'allouer : seules les pages touchées par
+         * la copie du fichier ci-dessous sont peuplées, le reste (.bss) est
+         * alloué et mis à zéro au premier accès.
+         */
+        if (vaddr_start < vaddr_end &&
+            vma_reserve(target_dir, vaddr_start, vaddr_end - vaddr_start, page_flags) != 0) {
+            KLOG_ERROR("ELF", "Failed to reserve segment!");
+            kfree(phdrs);
+            vfs_close(file);
+            return ELF_ERR_MEMORY;
         }
         
         /* Copier les données du fichier vers la mémoire */
@@ -249,7 +236,7 @@ int elf_load_file(const char* filename, process_t* proc, elf_load_result_t* resu
             kfree(seg_buffer);
         }
         
-        /* Le .bss (p_memsz > p_filesz) est déjà à zéro grâce au memset précédent */
+        /* Le .bss (p_memsz > p_filesz) sera mis à zéro à la demande */
         
         /* Mettre à jour les statistiques */
         if (result != NULL) {
@@ -3,18 +3,23 @@
 #include "../arch/x86_64/idt.h"
 #include "../arch/x86_64/io.h"
 #include "../arch/x86_64/cpu.h"
+#include "../arch/x86_64/acpi.h"
+#include "../arch/x86_64/hpet.h"
 #include "../arch/x86_64/usermode.h"
 #include "../config/config.h"
 #include "../drivers/ata.h"
 #include "../drivers/net/pcnet.h"
 #include "../drivers/net/e1000e.h"
 #include "../drivers/pci.h"
+#include "../drivers/virtio/virtio_balloon.h"
 #include "mmio/mmio.h"
 #include "../fs/ext2.h"
 #include "../fs/vfs.h"
 #include "../include/limine.h"
+#include "../include/memlayout.h"
 #include "../include/string.h"
 #include "../mm/kheap.h"
+#include "../mm/kstack.h"
 #include "../mm/pmm.h"
 #include "../mm/vmm.h"
 #include "../net/core/net.h"
@@ -31,6 +36,7 @@
 #include "mouse.h"
 #include "keymap.h"
 #include "klog.h"
+#include "ktime.h"
 #include "process.h"
 #include "syscall.h"
 #include "timer.h"
@@ -90,6 +96,13 @@ static volatile struct limine_bootloader_info_request bootloader_info_request =
     .revision = 0
 };
 
+/* RSDP request (tables ACPI) */
+__attribute__((used, section(".limine_requests")))
+static volatile struct limine_rsdp_request rsdp_request = {
+    .id = LIMINE_RSDP_REQUEST_ID,
+    .revision = 0
+};
+
 /* Global pointers to Limine responses */
 static struct limine_memmap_response *g_memmap = NULL;
 static struct limine_hhdm_response *g_hhdm = NULL;
@@ -124,9 +137,6 @@ static void clear_debug_registers(void) {
 static uint32_t schedule_counter = 0;
 #define SCHEDULE_INTERVAL 2 /* Scheduler toutes les 2 ticks (~20ms à 100Hz) */
 
-/* Déclaration externe pour réveiller les threads en sleep */
-extern void scheduler_wake_sleeping(void);
-
 /**
  * Halt and catch fire - called on unrecoverable errors.
  */
@@ -245,32 +255,44 @@ void kmain(void) {
     KLOG_INFO_DEC("PMM", "Free memory (KiB): ", pmm_get_free_memory() / 1024);
 
     /* ============================================ */
-    /* Initialisation du Kernel Heap               */
+    /* Virtual Memory Manager (Paging)              */
     /* ============================================ */
+    /* Avant le heap : kheap_init mappe ses pages via vmm_map_page */
+    vmm_init();
 
-#define HEAP_PAGES 256 /* 1 MiB */
-    void *heap_mem = pmm_alloc_blocks(HEAP_PAGES);
+    /* ============================================ */
+    /* Initialisation du Kernel Heap               */
+    /* ============================================ */
 
-    if (heap_mem == NULL) {
+#define HEAP_INITIAL_PAGES 256 /* 1 MiB, puis extension à la demande */
+    if (kheap_init(HEAP_INITIAL_PAGES * PMM_BLOCK_SIZE) != 0) {
       KLOG_ERROR("HEAP", "Failed to allocate heap memory!");
     } else {
-      kheap_init(heap_mem, HEAP_PAGES * PMM_BLOCK_SIZE);
-
       KLOG_INFO("HEAP", "=== Kernel Heap (kmalloc) ===");
-      KLOG_INFO_HEX("HEAP", "Heap start: ", (uint32_t)(uintptr_t)heap_mem);
-      KLOG_INFO_DEC("HEAP", "Size (KiB): ", kheap_get_total_size() / 1024);
+      KLOG_INFO_HEX("HEAP", "Heap start (high): ", (uint32_t)(KHEAP_VIRT_BASE >> 32));
+      KLOG_INFO_DEC("HEAP", "Initial size (KiB): ", kheap_get_total_size() / 1024);
       KLOG_INFO_DEC("HEAP", "Header size (bytes): ", sizeof(KHeapBlock));
 
       /* ============================================ */
-      /* Virtual Memory Manager (Paging)              */
+      /* Kernel Stacks (avant tout processus)         */
       /* ============================================ */
-      vmm_init();
+      if (kstack_init() != 0) {
+        KLOG_ERROR("KSTACK", "Failed to initialize kernel stack zone");
+      }
 
       /* ============================================ */
       /* MMIO Subsystem                               */
       /* ============================================ */
       mmio_init();
 
+      /* ============================================ */
+      /* ACPI + HPET                                  */
+      /* ============================================ */
+      if (rsdp_request.response != NULL &&
+          acpi_init((uint64_t)rsdp_request.response->address) == 0) {
+        hpet_init();
+      }
+
       /* ============================================ */
       /* PCI Bus Enumeration                          */
       /* ============================================ */
@@ -434,6 +456,16 @@ void kmain(void) {
   /* ============================================ */
   init_usermode();
 
+  /* ============================================ */
+  /* Tick LAPIC/HPET, arrêté pendant l'idle       */
+  /* ============================================ */
+  if (timer_lapic_init() != 0 && timer_hpet_init() != 0) {
+    KLOG_INFO("KERNEL", "Keeping the PIT as tick source");
+  }
+
+  /* Horloge haute résolution (TSC invariant, sinon HPET) */
+  ktime_init();
+
   /* ============================================ */
   /* Initialiser le Multitasking                  */
   /* ============================================ */
@@ -442,6 +474,11 @@ void kmain(void) {
   /* Activer la préemption timer maintenant que le scheduler est prêt */
   timer_enable_scheduling();
 
+  /* ============================================ */
+  /* VirtIO Balloon (nécessite le scheduler)      */
+  /* ============================================ */
+  virtio_balloon_init();
+
   /* Lancer le shell interactif */
   shell_init();
 
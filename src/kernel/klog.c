@@ -1,6 +1,6 @@
 /* src/kernel/klog.c - Kernel Logging System Implementation */
 #include "klog.h"
-#include "timer.h"
+#include "ktime.h"
 #include "console.h"
 #include "../fs/vfs.h"
 #include "../mm/kheap.h"
@@ -206,16 +206,15 @@ static void do_log(klog_level_t level, const char* module, const char* msg,
     char formatted[KLOG_MAX_MSG_LEN];
     char timestamp[24];
     
-    /* Timestamp: [SSSSSS.mmm] où S=secondes depuis boot, m=millisecondes */
-    uint32_t uptime = (uint32_t)timer_get_uptime_ms();  /* Cast en 32-bit pour éviter __udivdi3 */
-    uint32_t seconds = uptime / 1000;
-    uint32_t ms = uptime % 1000;
+    /* Timestamp: [SSSSSS.uuuuuu] où S=secondes depuis boot, u=microsecondes */
+    uint64_t uptime_us = ktime_get_us();
+    uint32_t seconds = (uint32_t)(uptime_us / 1000000);
+    uint32_t us = (uint32_t)(uptime_us % 1000000);
     
-    char sec_str[12], ms_str[4];
+    char sec_str[12], us_str[8];
     uint_to_str(seconds, sec_str);
-    uint_to_str(ms, ms_str);
+    uint_to_str(us, us_str);
     
-    /* Padding pour les millisecondes (toujours 3 chiffres) */
     timestamp[0] = '[';
     int pos = 1;
     
@@ -225,15 +224,12 @@ static void do_log(klog_level_t level, const char* module, const char* msg,
     }
     timestamp[pos++] = '.';
     
-    /* Padding millisecondes */
-    if (ms < 10) {
-        timestamp[pos++] = '0';
-        timestamp[pos++] = '0';
-    } else if (ms < 100) {
+    /* Padding microsecondes (toujours 6 chiffres) */
+    for (uint32_t limit = 100000; limit > 1 && us < limit; limit /= 10) {
         timestamp[pos++] = '0';
     }
-    for (int i = 0; ms_str[i]; i++) {
-        timestamp[pos++] = ms_str[i];
+    for (int i = 0; us_str[i]; i++) {
+        timestamp[pos++] = us_str[i];
     }
     timestamp[pos++] = ']';
     timestamp[pos++] = ' ';
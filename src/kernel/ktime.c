@@ -0,0 +1,97 @@
+/* src/kernel/ktime.c - Horloge haute résolution (clocksource) */
+#include "ktime.h"
+#include "timer.h"
+#include "klog.h"
+#include "../arch/x86_64/cpu.h"
+#include "../arch/x86_64/hpet.h"
+
+/* Nanosecondes par tick (TIMER_FREQUENCY = 1000 Hz) */
+#define KTIME_NS_PER_TICK   (1000000000ULL / TIMER_FREQUENCY)
+
+static ktime_source_t g_source = KTIME_SOURCE_TICK;
+
+/* TSC ou HPET : ns = base_ns + ((compteur - cycles_base) * mult) >> 32 */
+static uint64_t g_cycles_base = 0;
+static uint64_t g_cycles_mult = 0;
+static uint64_t g_base_ns = 0;
+
+/**
+ * Bascule sur une source à compteur (interruptions désactivées pour que
+ * le raccord au tick et la base du compteur soient lus ensemble).
+ */
+static void ktime_switch(ktime_source_t source, uint64_t hz)
+{
+    /* (10^9 << 32) tient sur 64 bits : pas de division 128 bits */
+    g_cycles_mult = (1000000000ULL << 32) / hz;
+
+    uint64_t flags;
+    asm volatile("pushfq; pop %0; cli" : "=r"(flags) :: "memory");
+
+    /* Raccorder au temps déjà écoulé selon le tick */
+    g_base_ns = timer_get_ticks() * KTIME_NS_PER_TICK;
+    g_cycles_base = (source == KTIME_SOURCE_TSC) ? rdtsc() : hpet_read_counter();
+    g_source = source;
+
+    asm volatile("push %0; popfq" :: "r"(flags) : "memory", "cc");
+}
+
+void ktime_init(void)
+{
+    if (cpu_tsc_init() == 0) {
+        if (cpu_tsc_invariant()) {
+            ktime_switch(KTIME_SOURCE_TSC, cpu_tsc_hz());
+            KLOG_INFO("KTIME", "Clocksource: tsc");
+            return;
+        }
+        KLOG_INFO("KTIME", "TSC not invariant");
+    }
+
+    if (hpet_present()) {
+        ktime_switch(KTIME_SOURCE_HPET, hpet_frequency());
+        KLOG_INFO("KTIME", "Clocksource: hpet");
+        return;
+    }
+
+    KLOG_INFO("KTIME", "Clocksource: tick (1 ms)");
+}
+
+uint64_t ktime_get_ns(void)
+{
+    uint64_t cycles;
+
+    switch (g_source) {
+        case KTIME_SOURCE_TSC:
+            cycles = rdtsc();
+            break;
+        case KTIME_SOURCE_HPET:
+            cycles = hpet_read_counter();
+            break;
+        default:
+            return timer_get_ticks() * KTIME_NS_PER_TICK;
+    }
+
+    uint64_t delta = cycles - g_cycles_base;
+    return g_base_ns + (uint64_t)(((unsigned __int128)delta * g_cycles_mult) >> 32);
+}
+
+uint64_t ktime_get_us(void)
+{
+    return ktime_get_ns() / 1000;
+}
+
+ktime_source_t ktime_get_source(void)
+{
+    return g_source;
+}
+
+const char *ktime_source_name(void)
+{
+    switch (g_source) {
+        case KTIME_SOURCE_TSC:
+            return "tsc";
+        case KTIME_SOURCE_HPET:
+            return "hpet";
+        default:
+            return "tick";
+    }
+}
@@ -0,0 +1,53 @@
+/* src/kernel/ktime.h - Horloge haute résolution (clocksource) */
+#ifndef KTIME_H
+#define KTIME_H
+
+#include <stdint.h>
+
+/*
+ * Temps monotone depuis le boot, en nanosecondes.
+ *
+ * Source choisie par ktime_init(), de la plus précise à la moins précise :
+ * - TSC, s'il est invariant (fréquence constante quels que soient les
+ *   P/C-states) : rdtsc + multiplication, quelques ns de résolution ;
+ * - compteur principal du HPET : une lecture MMIO, résolution de 100 ns
+ *   au pire (souvent ~70 ns) ;
+ * - tick du timer (PIT, LAPIC ou HPET) : résolution de 1 ms.
+ *
+ * Un TSC non invariant peut ralentir ou s'arrêter en idle : il n'est pas
+ * utilisé.
+ */
+
+typedef enum {
+    KTIME_SOURCE_TICK = 0,
+    KTIME_SOURCE_TSC,
+    KTIME_SOURCE_HPET
+} ktime_source_t;
+
+/**
+ * Calibre et choisit la source. Appelé après timer_init() et hpet_init() ;
+ * avant, et en cas d'échec, le tick sert de source.
+ */
+void ktime_init(void);
+
+/**
+ * Nanosecondes depuis le boot (monotone).
+ */
+uint64_t ktime_get_ns(void);
+
+/**
+ * Microsecondes depuis le boot (monotone).
+ */
+uint64_t ktime_get_us(void);
+
+/**
+ * Source active.
+ */
+ktime_source_t ktime_get_source(void);
+
+/**
+ * Nom de la source active ("tsc", "hpet", "tick").
+ */
+const char *ktime_source_name(void);
+
+#endif /* KTIME_H */
@@ -0,0 +1,181 @@
+/* src/kernel/ktimer.c - Timers kernel à callback (callouts) */
+#include "ktimer.h"
+#include "thread.h"
+#include "sync.h"
+#include "timer.h"
+#include "klog.h"
+
+/* File des ktimers expirés, FIFO */
+static ktimer_t *g_expired_head = NULL;
+static ktimer_t *g_expired_tail = NULL;
+static spinlock_t g_ktimer_lock;
+
+/* Réveil de ktimerd (binaire : les expirations sont traitées par lots) */
+static semaphore_t g_ktimer_sem;
+static bool g_ktimer_ready = false;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+/* Callback de la roue de timers (contexte IRQ) */
+static void ktimer_expire(timer_entry_t *entry, void *arg)
+{
+    ktimer_t *timer = (ktimer_t *)arg;
+
+    uint64_t irq_flags = spinlock_irqsave(&g_ktimer_lock);
+
+    if (timer->period_ms > 0) {
+        timer_wheel_arm(entry, entry->expires + timer->period_ms);
+    }
+
+    bool wake = false;
+    if (!timer->queued) {
+        timer->queued = true;
+        timer->next = NULL;
+        if (g_expired_tail) {
+            g_expired_tail->next = timer;
+        } else {
+            g_expired_head = timer;
+        }
+        g_expired_tail = timer;
+        wake = true;
+    }
+
+    spinlock_irqrestore(&g_ktimer_lock, irq_flags);
+
+    if (wake) {
+        sem_post(&g_ktimer_sem);
+    }
+}
+
+/* Retire un ktimer de la file de ktimerd (g_ktimer_lock tenu) */
+static void ktimer_unqueue(ktimer_t *timer)
+{
+    ktimer_t *prev = NULL;
+    ktimer_t *curr = g_expired_head;
+    while (curr && curr != timer) {
+        prev = curr;
+        curr = curr->next;
+    }
+    if (!curr) return;
+
+    if (prev) {
+        prev->next = curr->next;
+    } else {
+        g_expired_head = curr->next;
+    }
+    if (g_expired_tail == curr) {
+        g_expired_tail = prev;
+    }
+    curr->next = NULL;
+    curr->queued = false;
+}
+
+/**
+ * Thread ktimerd : exécute les callbacks des ktimers expirés.
+ */
+static void ktimerd_thread_func(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        sem_wait(&g_ktimer_sem);
+
+        for (;;) {
+            uint64_t irq_flags = spinlock_irqsave(&g_ktimer_lock);
+            ktimer_t *timer = g_expired_head;
+            if (!timer) {
+                spinlock_irqrestore(&g_ktimer_lock, irq_flags);
+                break;
+            }
+            g_expired_head = timer->next;
+            if (!g_expired_head) {
+                g_expired_tail = NULL;
+            }
+            timer->next = NULL;
+            timer->queued = false;
+
+            ktimer_func_t func = timer->func;
+            void *func_arg = timer->arg;
+            spinlock_irqrestore(&g_ktimer_lock, irq_flags);
+
+            if (func) {
+                func(func_arg);
+            }
+        }
+    }
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+int ktimer_init(void)
+{
+    spinlock_init(&g_ktimer_lock);
+    semaphore_init(&g_ktimer_sem, 0, 1);
+
+    thread_t *thread = thread_create("ktimerd", ktimerd_thread_func, NULL,
+                                     THREAD_DEFAULT_STACK_SIZE,
+                                     THREAD_PRIORITY_HIGH);
+    if (!thread) {
+        KLOG_ERROR("KTIMER", "Failed to create ktimerd thread");
+        return -1;
+    }
+
+    g_ktimer_ready = true;
+    KLOG_INFO("KTIMER", "Callout thread started");
+    return 0;
+}
+
+void ktimer_setup(ktimer_t *timer, ktimer_func_t func, void *arg)
+{
+    if (!timer) return;
+
+    timer_entry_init(&timer->entry, ktimer_expire, timer);
+    timer->func = func;
+    timer->arg = arg;
+    timer->period_ms = 0;
+    timer->queued = false;
+    timer->next = NULL;
+}
+
+void ktimer_start(ktimer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+    if (!timer) return;
+
+    if (!g_ktimer_ready) {
+        KLOG_ERROR("KTIMER", "ktimerd not started");
+        return;
+    }
+
+    /* Avec un timer à 1000 Hz, 1 tick = 1 ms */
+    uint64_t irq_flags = spinlock_irqsave(&g_ktimer_lock);
+    timer->period_ms = period_ms;
+    timer_wheel_arm(&timer->entry, timer_get_ticks() + delay_ms);
+    spinlock_irqrestore(&g_ktimer_lock, irq_flags);
+}
+
+bool ktimer_cancel(ktimer_t *timer)
+{
+    if (!timer) return false;
+
+    uint64_t irq_flags = spinlock_irqsave(&g_ktimer_lock);
+
+    timer->period_ms = 0;
+    bool was_pending = timer_wheel_cancel(&timer->entry);
+    if (timer->queued) {
+        ktimer_unqueue(timer);
+        was_pending = true;
+    }
+
+    spinlock_irqrestore(&g_ktimer_lock, irq_flags);
+    return was_pending;
+}
+
+bool ktimer_pending(ktimer_t *timer)
+{
+    if (!timer) return false;
+    return timer->entry.pending || timer->queued;
+}
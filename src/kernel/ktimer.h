@@ -0,0 +1,67 @@
+/* src/kernel/ktimer.h - Timers kernel à callback (callouts) */
+#ifndef KTIMER_H
+#define KTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timer_wheel.h"
+
+/*
+ * Un ktimer exécute une fonction après un délai, une fois ou
+ * périodiquement, sans thread dédié qui boucle sur thread_sleep_ms.
+ *
+ * L'échéance est détectée par la roue de timers dans l'IRQ timer ; le
+ * ktimer est alors placé dans une file traitée par le thread "ktimerd"
+ * (l'équivalent d'un softirq) : le callback s'exécute en contexte thread
+ * et peut prendre des mutex ou allouer, mais doit rester court car tous
+ * les ktimers partagent ce thread. Un travail long passe par
+ * kwork_submit_delayed / kwork_submit_periodic (workqueue.h).
+ *
+ * Une échéance périodique est réarmée dans l'IRQ, sans dérive. Si le
+ * callback précédent n'a pas encore tourné, les expirations sont
+ * fusionnées en une seule exécution.
+ */
+
+typedef void (*ktimer_func_t)(void *arg);
+
+typedef struct ktimer {
+    timer_entry_t entry;        /* Entrée dans la roue de timers */
+    ktimer_func_t func;
+    void *arg;
+    uint32_t period_ms;         /* 0 = one-shot */
+    bool queued;                /* En attente dans la file de ktimerd */
+    struct ktimer *next;        /* File de ktimerd */
+} ktimer_t;
+
+/**
+ * Démarre le thread ktimerd. Appelé une fois le scheduler démarré.
+ *
+ * @return 0 si succès, -1 si échec
+ */
+int ktimer_init(void);
+
+/**
+ * Prépare un ktimer (non armé).
+ */
+void ktimer_setup(ktimer_t *timer, ktimer_func_t func, void *arg);
+
+/**
+ * Arme un ktimer : première exécution dans delay_ms, puis toutes les
+ * period_ms si period_ms > 0. Un ktimer déjà armé est reprogrammé.
+ */
+void ktimer_start(ktimer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * Désarme un ktimer et retire une expiration en attente. N'attend pas un
+ * callback déjà en cours d'exécution.
+ *
+ * @return true si le ktimer était armé ou en attente
+ */
+bool ktimer_cancel(ktimer_t *timer);
+
+/**
+ * Le ktimer est-il armé ou en attente d'exécution ?
+ */
+bool ktimer_pending(ktimer_t *timer);
+
+#endif /* KTIMER_H */
@@ -7,6 +7,9 @@
 #include "../fs/vfs.h"
 #include "../fs/file.h"
 #include "../mm/kheap.h"
+#include "../mm/vmm.h"
+#include "../mm/vma.h"
+#include "../include/memlayout.h"
 #include "../include/string.h"
 
 /* Mode de compatibilité Linux (par processus) */
@@ -106,29 +109,135 @@ static int32_t linux_sys_getpid(void)
     return syscall_do_getpid();
 }
 
+/**
+ * Retourne l'espace d'adressage user du processus courant, ou NULL si le
+ * processus s'exécute dans l'espace du kernel.
+ */
+static page_directory_t* linux_current_dir(process_t* proc)
+{
+    if (proc == NULL || proc->pml4 == NULL ||
+        proc->pml4 == (uint64_t*)vmm_get_kernel_directory()) {
+        return NULL;
+    }
+    return (page_directory_t*)proc->pml4;
+}
+
 /**
  * sys_brk - Changer la limite du segment de données
- * Simple implémentation : on ignore pour l'instant
+ * Le heap est une VMA allouée à la demande, juste après l'image ELF.
+ * Retourne le nouveau break, ou l'ancien si la demande est refusée.
  */
-static int32_t linux_sys_brk(void* addr)
+static int64_t linux_sys_brk(uint64_t addr)
 {
-    /* Pour l'instant, on retourne simplement l'adresse demandée */
-    /* Un vrai implémentation nécessiterait de gérer le heap userspace */
-    return (int32_t)addr;
+    process_t* proc = process_current();
+    page_directory_t* dir = linux_current_dir(proc);
+    if (dir == NULL || proc->brk_start == 0) {
+        return 0;
+    }
+    
+    /* brk(0) ou valeur hors zone : simple consultation */
+    if (addr < proc->brk_start || addr > USER_MMAP_BASE) {
+        return (int64_t)proc->brk;
+    }
+    
+    uint64_t old_end = PAGE_ALIGN_UP(proc->brk);
+    uint64_t new_end = PAGE_ALIGN_UP(addr);
+    
+    if (new_end > old_end) {
+        if (vma_reserve(dir, old_end, new_end - old_end, PAGE_RW | PAGE_USER | PAGE_NX) != 0) {
+            return (int64_t)proc->brk;
+        }
+    } else if (new_end < old_end) {
+        vma_unmap(dir, new_end, old_end - new_end);
+    }
+    
+    proc->brk = addr;
+    return (int64_t)addr;
 }
 
 /**
  * sys_mmap/mmap2 - Mapper de la mémoire
- * Stub pour l'instant
+ * Seuls les mappings anonymes sont supportés ; les pages sont allouées
+ * et mises à zéro au premier accès.
+ */
+static int64_t linux_sys_mmap(uint64_t addr, uint64_t length, int prot, int flags,
+                              int fd, uint64_t offset)
+{
+    (void)fd; (void)offset;
+    
+    page_directory_t* dir = linux_current_dir(process_current());
+    if (dir == NULL) {
+        return -LINUX_ENOMEM;
+    }
+    
+    if (length == 0 || (addr & (PAGE_SIZE - 1)) != 0) {
+        return -LINUX_EINVAL;
+    }
+    if (!(flags & LINUX_MAP_ANONYMOUS)) {
+        return -LINUX_ENODEV;  /* Pas de mapping de fichier */
+    }
+    
+    length = PAGE_ALIGN_UP(length);
+    if (length > USER_MMAP_END - USER_MMAP_BASE) {
+        return -LINUX_ENOMEM;
+    }
+    
+    /* PROT_NONE : plage réservée mais inaccessible depuis le user */
+    uint64_t page_flags = 0;
+    if (prot != LINUX_PROT_NONE) {
+        page_flags |= PAGE_USER;
+    }
+    if (prot & LINUX_PROT_WRITE) {
+        page_flags |= PAGE_RW;
+    }
+    if (!(prot & LINUX_PROT_EXEC)) {
+        page_flags |= PAGE_NX;
+    }
+    
+    if (flags & LINUX_MAP_FIXED) {
+        if (addr == 0 || addr + length > USER_SPACE_END || addr + length < addr) {
+            return -LINUX_EINVAL;
+        }
+        /* MAP_FIXED remplace ce qui se trouvait déjà là */
+        if (vma_unmap(dir, addr, length) != 0 ||
+            vma_reserve(dir, addr, length, page_flags) != 0) {
+            return -LINUX_ENOMEM;
+        }
+        return (int64_t)addr;
+    }
+    
+    /* L'adresse fournie n'est qu'un indice : l'utiliser si elle est libre */
+    if (addr != 0 && addr + length <= USER_SPACE_END && addr + length > addr &&
+        vma_reserve(dir, addr, length, page_flags) == 0) {
+        return (int64_t)addr;
+    }
+    
+    addr = vma_find_free(dir, USER_MMAP_BASE, USER_MMAP_END, length);
+    if (addr == 0 || vma_reserve(dir, addr, length, page_flags) != 0) {
+        return -LINUX_ENOMEM;
+    }
+    return (int64_t)addr;
+}
+
+/**
+ * sys_munmap - Retirer un mapping
  */
-static int32_t linux_sys_mmap(void* addr, uint32_t length, int prot, int flags, 
-                              int fd, uint32_t offset)
+static int64_t linux_sys_munmap(uint64_t addr, uint64_t length)
 {
-    (void)addr; (void)length; (void)prot; (void)flags; (void)fd; (void)offset;
+    page_directory_t* dir = linux_current_dir(process_current());
+    if (dir == NULL) {
+        return -LINUX_EINVAL;
+    }
     
-    /* Pour un binaire statique simple, on peut souvent ignorer mmap */
-    /* Retourner une erreur ou une adresse fictive */
-    return -1; /* EPERM */
+    if (length == 0 || (addr & (PAGE_SIZE - 1)) != 0 ||
+        addr + length > USER_SPACE_END || addr + length < addr) {
+        return -LINUX_EINVAL;
+    }
+    
+    if (vma_unmap(dir, addr, length) != 0) {
+        return -LINUX_ENOMEM;
+    }
+    return 0;
 }
 
 /**
@@ -225,7 +334,7 @@ static int32_t linux_sys_stub(const char* name)
  * Dispatcher principal
  * ======================================== */
 
-int32_t linux_syscall_handler(syscall_regs_t* regs)
+int64_t linux_syscall_handler(syscall_regs_t* regs)
 {
     uint64_t syscall_num = regs->rax;
     uint64_t arg1 = regs->rdi;
@@ -256,13 +365,16 @@ int32_t linux_syscall_handler(syscall_regs_t* regs)
             return linux_sys_getpid();
         
         case LINUX_SYS_BRK:
-            return linux_sys_brk((void*)arg1);
+            return linux_sys_brk(arg1);
         
         case LINUX_SYS_MMAP:
         case LINUX_SYS_MMAP2:
-            return linux_sys_mmap((void*)arg1, arg2, arg3, arg4, arg5, 
+            return linux_sys_mmap(arg1, arg2, arg3, arg4, arg5, 
                                   regs->r9); /* 6ème arg sur la stack */
         
+        case LINUX_SYS_MUNMAP:
+            return linux_sys_munmap(arg1, arg2);
+        
         case LINUX_SYS_GETCWD:
             return linux_sys_getcwd((char*)arg1, arg2);
         
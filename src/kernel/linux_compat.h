@@ -108,6 +108,25 @@
 #define LINUX_SOCK_DGRAM    2
 #define LINUX_SOCK_RAW      3
 
+/* mmap : protections */
+#define LINUX_PROT_NONE     0x0
+#define LINUX_PROT_READ     0x1
+#define LINUX_PROT_WRITE    0x2
+#define LINUX_PROT_EXEC     0x4
+
+/* mmap : flags */
+#define LINUX_MAP_SHARED    0x01
+#define LINUX_MAP_PRIVATE   0x02
+#define LINUX_MAP_FIXED     0x10
+#define LINUX_MAP_ANONYMOUS 0x20
+
+/* Codes d'erreur (retournés en négatif) */
+#define LINUX_ENOENT        2
+#define LINUX_ENOMEM        12
+#define LINUX_ENODEV        19
+#define LINUX_EINVAL        22
+#define LINUX_ENOSYS        38
+
 /* ========================================
  * Structures Linux
  * ======================================== */
@@ -166,7 +185,7 @@ void linux_compat_init(void);
  * @param regs  Pointeur vers les registres sauvegardés
  * @return Valeur de retour du syscall (ou code d'erreur négatif)
  */
-int32_t linux_syscall_handler(syscall_regs_t* regs);
+int64_t linux_syscall_handler(syscall_regs_t* regs);
 
 /**
  * Configure le processus courant comme "Linux mode".
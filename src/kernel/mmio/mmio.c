@@ -170,9 +170,20 @@ mmio_addr_t ioremap_flags(uint64_t phys_addr, uint64_t size, uint32_t flags)
         return NULL;
     }
     
-    /* Allouer l'adresse virtuelle */
+    /* Allouer l'adresse virtuelle.
+     * Pour une grande région, virt est placée à la même position que phys
+     * dans une page de 2 MiB afin que vmm_map_range puisse utiliser des
+     * grandes pages (moins d'entrées TLB pour les BARs et framebuffers). */
     uint64_t virt_addr = mmio_next_virt;
-    mmio_next_virt += size_aligned;
+    if (size_aligned >= PAGE_SIZE_2M) {
+        uint64_t phase = phys_aligned & (PAGE_SIZE_2M - 1);
+        virt_addr = ((mmio_next_virt - phase + PAGE_SIZE_2M - 1) & ~(PAGE_SIZE_2M - 1)) + phase;
+        if (virt_addr + size_aligned > MMIO_VIRT_END) {
+            KLOG_ERROR("MMIO", "ioremap: out of virtual address space!");
+            return NULL;
+        }
+    }
+    mmio_next_virt = virt_addr + size_aligned;
     
     /* Mapper chaque page avec les attributs MMIO (PCD + PWT pour désactiver le cache) */
     uint64_t page_flags = PAGE_PRESENT | PAGE_RW | PAGE_NOCACHE | PAGE_WRITETHROUGH | (flags & ~0xFFF);
@@ -182,8 +193,10 @@ mmio_addr_t ioremap_flags(uint64_t phys_addr, uint64_t size, uint32_t flags)
     KLOG_INFO_HEX("MMIO", "              to virt (low)  ", (uint32_t)virt_addr);
     KLOG_INFO_HEX("MMIO", "              size ", (uint32_t)size_aligned);
     
-    for (uint64_t off = 0; off < size_aligned; off += PAGE_SIZE) {
-        vmm_map_page(phys_aligned + off, virt_addr + off, page_flags);
+    if (vmm_map_range(phys_aligned, virt_addr, size_aligned, page_flags) != 0) {
+        KLOG_ERROR("MMIO", "ioremap: failed to map region!");
+        vmm_unmap_range(virt_addr, size_aligned);
+        return NULL;
     }
     
     /* Enregistrer la région */
@@ -212,10 +225,8 @@ void iounmap(mmio_addr_t virt_addr, uint64_t size)
         return;
     }
     
-    /* Unmapper chaque page */
-    for (uint64_t off = 0; off < region->size; off += PAGE_SIZE) {
-        vmm_unmap_page(region->virt_addr + off);
-    }
+    /* Unmapper la région (grandes pages comprises) */
+    vmm_unmap_range(region->virt_addr, region->size);
     
     /* Désenregistrer la région */
     mmio_unregister_region(region->virt_addr);
@@ -7,7 +7,10 @@
 #include "elf.h"
 #include "../mm/kheap.h"
 #include "../mm/vmm.h"
+#include "../mm/vma.h"
 #include "../mm/pmm.h"
+#include "../mm/kstack.h"
+#include "../mm/zram.h"
 #include "../include/string.h"
 #include "../fs/vfs.h"
 #include "../arch/x86_64/gdt.h"
@@ -100,6 +103,9 @@ void init_multitasking(void)
     /* Utiliser le Page Directory du kernel */
     idle_process->pml4 = (uint64_t*)vmm_get_kernel_directory();
     idle_process->cr3 = (uint64_t)idle_process->pml4;  /* Adresse physique pour CR3 */
+    idle_process->brk_start = 0;
+    idle_process->brk = 0;
+    idle_process->shm_attachments = NULL;
     
     /* Pas de stack allouée (on utilise la stack du kernel) */
     idle_process->stack_base = NULL;
@@ -136,9 +142,22 @@ void init_multitasking(void)
     /* Initialize the reaper thread for zombie cleanup */
     reaper_init();
 
+    /* Start the callout thread (ktimer, delayed work) */
+    if (ktimer_init() != 0) {
+        KLOG_ERROR("TASK", "Failed to initialize kernel timers");
+    }
+
     /* Initialize the kernel worker pool */
     workqueue_init();
 
+    /* Start the background page zeroing thread */
+    pmm_zero_thread_init();
+
+    /* Start compressed swap (kswapd armed on memory pressure) */
+    if (zram_init() != 0) {
+        KLOG_ERROR("TASK", "Failed to initialize compressed swap");
+    }
+
     KLOG_INFO("TASK", "Multitasking initialized");
     KLOG_INFO_DEC("TASK", "Idle process PID: ", idle_process->pid);
 }
@@ -161,7 +180,7 @@ process_t* create_kernel_thread(void (*function)(void), const char* name)
     }
     
     /* Allouer la stack kernel pour ce thread */
-    void* stack = kmalloc(KERNEL_STACK_SIZE);
+    void* stack = kstack_alloc(KERNEL_STACK_SIZE);
     if (stack == NULL) {
         KLOG_ERROR("TASK", "Failed to allocate kernel stack!");
         kfree(proc);
@@ -177,6 +196,9 @@ process_t* create_kernel_thread(void (*function)(void), const char* name)
     /* Page Directory (partagé avec le kernel pour les threads kernel) */
     proc->pml4 = (uint64_t*)vmm_get_kernel_directory();
     proc->cr3 = (uint64_t)proc->pml4;  /* Threads kernel partagent le même CR3 */
+    proc->brk_start = 0;
+    proc->brk = 0;
+    proc->shm_attachments = NULL;
     
     /* Stack */
     proc->stack_base = stack;
@@ -313,7 +335,9 @@ void switch_to(process_t* next)
     /* Effectuer le context switch ASM avec changement de CR3 */
     /* Note: Le changement de Page Directory (CR3) est fait dans switch_task */
     /* pour garantir une transition atomique entre les espaces mémoire */
-    switch_task(&prev->rsp, next->rsp, next->cr3);
+    page_directory_t* next_dir = next->pml4 ? (page_directory_t*)next->pml4
+                                            : vmm_get_kernel_directory();
+    switch_task(&prev->rsp, next->rsp, vmm_get_switch_cr3(next_dir));
 }
 
 void process_exit(void)
@@ -526,17 +550,14 @@ int process_execute(const char* filename)
     }
     
     /* Allouer une stack kernel pour ce processus (pour les syscalls) */
-    void* kernel_stack = kmalloc(KERNEL_STACK_SIZE);
+    void* kernel_stack = kstack_alloc(KERNEL_STACK_SIZE);
     if (kernel_stack == NULL) {
         KLOG_ERROR("EXEC", "Failed to allocate kernel stack!");
         kfree(proc);
         return -1;
     }
     
-    /* Initialiser la kernel stack à 0 pour éviter les problèmes de mémoire non initialisée */
-    for (uint32_t i = 0; i < KERNEL_STACK_SIZE; i++) {
-        ((uint8_t*)kernel_stack)[i] = 0;
-    }
+    /* kstack_alloc remplit la stack avec KSTACK_PAINT (mesure du high-water mark) */
     
     /* Initialiser le processus */
     proc->pid = next_pid++;
@@ -555,11 +576,14 @@ int process_execute(const char* filename)
     proc->pml4 = (uint64_t*)vmm_create_directory();
     if (proc->pml4 == NULL) {
         KLOG_ERROR("EXEC", "Failed to create page directory!");
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
     proc->cr3 = (uint64_t)proc->pml4;
+    proc->brk_start = 0;
+    proc->brk = 0;
+    proc->shm_attachments = NULL;
     
     KLOG_INFO_HEX("EXEC", "Created page directory at: ", proc->cr3);
     
@@ -574,36 +598,26 @@ int process_execute(const char* filename)
     if (err != ELF_OK) {
         KLOG_ERROR("EXEC", "Failed to load ELF file");
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
     
     KLOG_INFO_HEX("EXEC", "Entry point: ", elf_result.entry_point);
     
-    /* Allouer la stack utilisateur dans le Page Directory du processus */
+    /* Le heap user (brk) commence juste après l'image chargée */
+    proc->brk_start = PAGE_ALIGN_UP((uint64_t)elf_result.top_addr);
+    proc->brk = proc->brk_start;
+    
+    /* Réserver la stack utilisateur : les pages sont allouées au premier accès */
     uint64_t user_stack_bottom = USER_STACK_TOP - USER_STACK_SIZE;
-    for (uint64_t addr = user_stack_bottom; addr < USER_STACK_TOP; addr += PAGE_SIZE) {
-        if (!vmm_is_mapped_in_dir((page_directory_t*)proc->pml4, addr)) {
-            void* phys_page = pmm_alloc_block();
-            if (phys_page == NULL) {
-                KLOG_ERROR("EXEC", "Failed to allocate user stack!");
-                vmm_free_directory((page_directory_t*)proc->pml4);
-                kfree(kernel_stack);
-                kfree(proc);
-                return -1;
-            }
-            if (vmm_map_page_in_dir((page_directory_t*)proc->pml4, 
-                                     (uint64_t)phys_page, addr, 
-                                     PAGE_PRESENT | PAGE_RW | PAGE_USER) != 0) {
-                KLOG_ERROR("EXEC", "Failed to map user stack page!");
-                pmm_free_block(phys_page);
-                vmm_free_directory((page_directory_t*)proc->pml4);
-                kfree(kernel_stack);
-                kfree(proc);
-                return -1;
-            }
-        }
+    if (vma_reserve((page_directory_t*)proc->pml4, user_stack_bottom, USER_STACK_SIZE,
+                    PAGE_RW | PAGE_USER) != 0) {
+        KLOG_ERROR("EXEC", "Failed to reserve user stack!");
+        vmm_free_directory((page_directory_t*)proc->pml4);
+        kstack_free(kernel_stack);
+        kfree(proc);
+        return -1;
     }
     
     KLOG_INFO_HEX("EXEC", "User stack top: ", USER_STACK_TOP);
@@ -629,7 +643,7 @@ int process_execute(const char* filename)
                         user_rsp, user_stack_data, sizeof(user_stack_data)) != 0) {
         KLOG_ERROR("EXEC", "Failed to initialize user stack!");
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
@@ -674,7 +688,7 @@ int process_execute(const char* filename)
     if (main_thread == NULL) {
         KLOG_ERROR("EXEC", "Failed to create user thread!");
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
@@ -731,7 +745,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
     }
     
     /* Allouer une stack kernel pour ce processus (pour les syscalls) */
-    void* kernel_stack = kmalloc(KERNEL_STACK_SIZE);
+    void* kernel_stack = kstack_alloc(KERNEL_STACK_SIZE);
     if (kernel_stack == NULL) {
         KLOG_ERROR("EXEC", "Failed to allocate kernel stack!");
         console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
@@ -741,10 +755,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
         return -1;
     }
     
-    /* Initialiser la kernel stack à 0 pour éviter les problèmes de mémoire non initialisée */
-    for (uint32_t i = 0; i < KERNEL_STACK_SIZE; i++) {
-        ((uint8_t*)kernel_stack)[i] = 0;
-    }
+    /* kstack_alloc remplit la stack avec KSTACK_PAINT (mesure du high-water mark) */
     
     /* Initialiser le processus */
     proc->pid = next_pid++;
@@ -766,12 +777,15 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
         console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
         console_puts("Error: Failed to create page directory\n");
         console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
     proc->pml4 = (uint64_t*)dir;  /* Stocker le pointeur vers la structure */
     proc->cr3 = dir->pml4_phys;   /* CR3 = adresse PHYSIQUE du PML4 */
+    proc->brk_start = 0;
+    proc->brk = 0;
+    proc->shm_attachments = NULL;
     
     KLOG_INFO_HEX("EXEC", "Created page directory at: ", proc->cr3);
     
@@ -791,47 +805,29 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
         console_puts(")\n");
         console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
     
     KLOG_INFO_HEX("EXEC", "Entry point: ", elf_result.entry_point);
     
-    /* Allouer la stack utilisateur dans le Page Directory du processus */
+    /* Le heap user (brk) commence juste après l'image chargée */
+    proc->brk_start = PAGE_ALIGN_UP((uint64_t)elf_result.top_addr);
+    proc->brk = proc->brk_start;
+    
+    /* Réserver la stack utilisateur : les pages sont allouées au premier accès */
     uint64_t user_stack_bottom = USER_STACK_TOP - USER_STACK_SIZE;
-    for (uint64_t addr = user_stack_bottom; addr < USER_STACK_TOP; addr += PAGE_SIZE) {
-        if (!vmm_is_mapped_in_dir((page_directory_t*)proc->pml4, addr)) {
-            /* pmm_alloc_block retourne une adresse virtuelle HHDM */
-            void* page_virt = pmm_alloc_block();
-            if (page_virt == NULL) {
-                KLOG_ERROR("EXEC", "Failed to allocate user stack!");
-                console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
-                console_puts("Error: Failed to allocate user stack (phys memory)\n");
-                console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-                vmm_free_directory((page_directory_t*)proc->pml4);
-                kfree(kernel_stack);
-                kfree(proc);
-                return -1;
-            }
-            /* Convertir en adresse physique pour le mapping */
-            uint64_t page_phys = pmm_virt_to_phys(page_virt);
-            if (vmm_map_page_in_dir((page_directory_t*)proc->pml4, 
-                                     page_phys, addr, 
-                                     PAGE_PRESENT | PAGE_RW | PAGE_USER) != 0) {
-                KLOG_ERROR("EXEC", "Failed to map user stack page!");
-                console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
-                console_puts("Error: Failed to map user stack page\n");
-                console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
-                pmm_free_block(page_virt);
-                vmm_free_directory((page_directory_t*)proc->pml4);
-                kfree(kernel_stack);
-                kfree(proc);
-                return -1;
-            }
-            /* Mettre la page à zéro */
-            memset(page_virt, 0, PAGE_SIZE);
-        }
+    if (vma_reserve((page_directory_t*)proc->pml4, user_stack_bottom, USER_STACK_SIZE,
+                    PAGE_RW | PAGE_USER) != 0) {
+        KLOG_ERROR("EXEC", "Failed to reserve user stack!");
+        console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
+        console_puts("Error: Failed to reserve user stack\n");
+        console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+        vmm_free_directory((page_directory_t*)proc->pml4);
+        kstack_free(kernel_stack);
+        kfree(proc);
+        return -1;
     }
     
     KLOG_INFO_HEX("EXEC", "User stack top: ", USER_STACK_TOP);
@@ -849,7 +845,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
         console_puts("Error: Failed to allocate stack buffer\n");
         console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
@@ -873,7 +869,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
             console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
             kfree(stack_buffer);
             vmm_free_directory((page_directory_t*)proc->pml4);
-            kfree(kernel_stack);
+            kstack_free(kernel_stack);
             kfree(proc);
             return -1;
         }
@@ -929,7 +925,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
         console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
         kfree(stack_buffer);
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
@@ -977,7 +973,7 @@ int process_exec_and_wait(const char* filename, int argc, char** argv)
     if (main_thread == NULL) {
         KLOG_ERROR("EXEC", "Failed to create user thread!");
         vmm_free_directory((page_directory_t*)proc->pml4);
-        kfree(kernel_stack);
+        kstack_free(kernel_stack);
         kfree(proc);
         return -1;
     }
@@ -1046,6 +1042,9 @@ process_t* process_create_kernel(const char* name, thread_entry_t entry, void* a
     
     proc->pml4 = (uint64_t*)vmm_get_kernel_directory();
     proc->cr3 = (uint64_t)proc->pml4;
+    proc->brk_start = 0;
+    proc->brk = 0;
+    proc->shm_attachments = NULL;
     
     proc->stack_base = NULL;
     proc->stack_size = 0;
@@ -72,6 +72,9 @@ typedef struct process {
     
     /* ===== Mémoire ===== */
     uint64_t* pml4;                 /* PML4 (Page Map Level 4) */
+    uint64_t brk_start;             /* Début du heap user (fin de l'image ELF) */
+    uint64_t brk;                   /* Program break courant (0 = pas de heap) */
+    struct shm_attach* shm_attachments; /* Segments partagés mappés (triés par adresse) */
     
     /* ===== Stack ===== */
     void* stack_base;               /* Base de la stack allouée (pour kfree) */
@@ -0,0 +1,326 @@
+/* src/kernel/shm.c - Segments de mémoire partagée entre processus */
+#include "shm.h"
+#include "process.h"
+#include "klog.h"
+#include "../mm/pmm.h"
+#include "../mm/vmm.h"
+#include "../mm/kheap.h"
+#include "../include/memlayout.h"
+#include "../include/string.h"
+
+typedef struct shm_segment {
+    int id;
+    uint32_t key;
+    uint64_t size;              /* Multiple de PAGE_SIZE */
+    uint32_t page_count;
+    uint32_t refs;              /* Nombre de mappings */
+    bool destroyed;             /* Retiré de la table, libéré au dernier unmap */
+    void** frames;              /* Frames (adresses HHDM), page_count entrées */
+} shm_segment_t;
+
+static shm_segment_t* segments[SHM_MAX_SEGMENTS];
+static int next_id = 1;
+
+/* Protège segments[], les refs et les listes d'attachements des processus */
+static spinlock_t shm_lock;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+/* Trouve un segment vivant par identifiant ou par clé (shm_lock tenu) */
+static int find_slot_by_id(int id)
+{
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++) {
+        if (segments[i] != NULL && segments[i]->id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_slot_by_key(uint32_t key)
+{
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++) {
+        if (segments[i] != NULL && segments[i]->key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void segment_free(shm_segment_t* seg)
+{
+    for (uint32_t i = 0; i < seg->page_count; i++) {
+        if (seg->frames[i] != NULL) {
+            pmm_free_block(seg->frames[i]);
+        }
+    }
+    kfree(seg->frames);
+    kfree(seg);
+}
+
+static shm_segment_t* segment_alloc(uint32_t key, uint64_t size)
+{
+    shm_segment_t* seg = (shm_segment_t*)kmalloc(sizeof(shm_segment_t));
+    if (seg == NULL) {
+        return NULL;
+    }
+
+    seg->id = -1;
+    seg->key = key;
+    seg->size = size;
+    seg->page_count = (uint32_t)(size / PAGE_SIZE);
+    seg->refs = 0;
+    seg->destroyed = false;
+    seg->frames = (void**)kmalloc(seg->page_count * sizeof(void*));
+    if (seg->frames == NULL) {
+        kfree(seg);
+        return NULL;
+    }
+    memset(seg->frames, 0, seg->page_count * sizeof(void*));
+
+    for (uint32_t i = 0; i < seg->page_count; i++) {
+        seg->frames[i] = pmm_alloc_zeroed();
+        if (seg->frames[i] == NULL) {
+            segment_free(seg);
+            return NULL;
+        }
+    }
+
+    return seg;
+}
+
+/* Rend une référence, libère le segment détruit au dernier mapping */
+static void segment_put(shm_segment_t* seg)
+{
+    uint64_t irq_flags = spinlock_irqsave(&shm_lock);
+    seg->refs--;
+    bool release = (seg->refs == 0 && seg->destroyed);
+    spinlock_irqrestore(&shm_lock, irq_flags);
+
+    if (release) {
+        segment_free(seg);
+    }
+}
+
+/* Retire un attachement de la liste du processus (shm_lock tenu) */
+static void attach_unlink(process_t* proc, shm_attach_t* attach)
+{
+    shm_attach_t** link = &proc->shm_attachments;
+    while (*link != NULL && *link != attach) {
+        link = &(*link)->next;
+    }
+    if (*link == attach) {
+        *link = attach->next;
+    }
+}
+
+static void unmap_pages(page_directory_t* dir, uint64_t addr, uint64_t size)
+{
+    for (uint64_t off = 0; off < size; off += PAGE_SIZE) {
+        vmm_unmap_page_in_dir(dir, addr + off);
+    }
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+int shm_create(uint32_t key, uint64_t size)
+{
+    if (size == 0 || size > SHM_MAX_SIZE) {
+        return -1;
+    }
+    size = PAGE_ALIGN_UP(size);
+
+    uint64_t irq_flags;
+    if (key != SHM_KEY_PRIVATE) {
+        irq_flags = spinlock_irqsave(&shm_lock);
+        int slot = find_slot_by_key(key);
+        int id = (slot >= 0 && size <= segments[slot]->size) ? segments[slot]->id : -1;
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        if (slot >= 0) {
+            return id;
+        }
+    }
+
+    /* Allocation hors du lock : elle peut être longue */
+    shm_segment_t* seg = segment_alloc(key, size);
+    if (seg == NULL) {
+        KLOG_ERROR("SHM", "shm_create: out of memory");
+        return -1;
+    }
+
+    irq_flags = spinlock_irqsave(&shm_lock);
+
+    /* Un autre processus a pu créer la même clé entre-temps */
+    if (key != SHM_KEY_PRIVATE) {
+        int slot = find_slot_by_key(key);
+        if (slot >= 0) {
+            int id = (size <= segments[slot]->size) ? segments[slot]->id : -1;
+            spinlock_irqrestore(&shm_lock, irq_flags);
+            segment_free(seg);
+            return id;
+        }
+    }
+
+    int slot = -1;
+    for (int i = 0; i < SHM_MAX_SEGMENTS && slot < 0; i++) {
+        if (segments[i] == NULL) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        segment_free(seg);
+        KLOG_ERROR("SHM", "shm_create: segment table full");
+        return -1;
+    }
+
+    seg->id = next_id++;
+    segments[slot] = seg;
+    int id = seg->id;
+
+    spinlock_irqrestore(&shm_lock, irq_flags);
+    return id;
+}
+
+int shm_map(process_t* proc, int id, uint64_t* addr_out)
+{
+    if (proc == NULL || addr_out == NULL || proc->pml4 == NULL ||
+        proc->pml4 == (uint64_t*)vmm_get_kernel_directory()) {
+        return -1;
+    }
+    page_directory_t* dir = (page_directory_t*)proc->pml4;
+
+    shm_attach_t* attach = (shm_attach_t*)kmalloc(sizeof(shm_attach_t));
+    if (attach == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&shm_lock);
+
+    int slot = find_slot_by_id(id);
+    if (slot < 0) {
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        kfree(attach);
+        return -1;
+    }
+    shm_segment_t* seg = segments[slot];
+
+    /* Premier trou assez grand dans la zone (la liste est triée) */
+    uint64_t addr = USER_SHM_BASE;
+    shm_attach_t** link = &proc->shm_attachments;
+    while (*link != NULL && addr + seg->size > (*link)->addr) {
+        addr = (*link)->addr + (*link)->size;
+        link = &(*link)->next;
+    }
+    if (addr + seg->size > USER_SHM_END) {
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        kfree(attach);
+        return -1;
+    }
+
+    /* Réserver la plage avant de mapper hors du lock */
+    seg->refs++;
+    attach->segment = seg;
+    attach->addr = addr;
+    attach->size = seg->size;
+    attach->next = *link;
+    *link = attach;
+
+    spinlock_irqrestore(&shm_lock, irq_flags);
+
+    uint64_t flags = PAGE_PRESENT | PAGE_RW | PAGE_USER | PAGE_NX;
+    for (uint32_t i = 0; i < seg->page_count; i++) {
+        uint64_t virt = addr + (uint64_t)i * PAGE_SIZE;
+        uint64_t phys = pmm_virt_to_phys(seg->frames[i]);
+
+        /* vmm_map_page échoue silencieusement si une table manque */
+        if (vmm_map_page_in_dir(dir, phys, virt, flags) != 0 ||
+            vmm_get_phys_addr(dir, virt) != phys) {
+            KLOG_ERROR("SHM", "shm_map: failed to map segment");
+            unmap_pages(dir, addr, (uint64_t)i * PAGE_SIZE);
+
+            irq_flags = spinlock_irqsave(&shm_lock);
+            attach_unlink(proc, attach);
+            spinlock_irqrestore(&shm_lock, irq_flags);
+
+            segment_put(seg);
+            kfree(attach);
+            return -1;
+        }
+    }
+
+    *addr_out = addr;
+    return 0;
+}
+
+int shm_unmap(process_t* proc, uint64_t addr)
+{
+    if (proc == NULL || proc->pml4 == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&shm_lock);
+
+    shm_attach_t* attach = proc->shm_attachments;
+    while (attach != NULL && attach->addr != addr) {
+        attach = attach->next;
+    }
+    if (attach == NULL) {
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        return -1;
+    }
+    attach_unlink(proc, attach);
+
+    spinlock_irqrestore(&shm_lock, irq_flags);
+
+    unmap_pages((page_directory_t*)proc->pml4, attach->addr, attach->size);
+    segment_put(attach->segment);
+    kfree(attach);
+    return 0;
+}
+
+int shm_destroy(int id)
+{
+    uint64_t irq_flags = spinlock_irqsave(&shm_lock);
+
+    int slot = find_slot_by_id(id);
+    if (slot < 0) {
+        spinlock_irqrestore(&shm_lock, irq_flags);
+        return -1;
+    }
+
+    shm_segment_t* seg = segments[slot];
+    segments[slot] = NULL;
+    seg->destroyed = true;
+    bool release = (seg->refs == 0);
+
+    spinlock_irqrestore(&shm_lock, irq_flags);
+
+    if (release) {
+        segment_free(seg);
+    }
+    return 0;
+}
+
+void shm_detach_all(process_t* proc)
+{
+    if (proc == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&shm_lock);
+    shm_attach_t* attach = proc->shm_attachments;
+    proc->shm_attachments = NULL;
+    spinlock_irqrestore(&shm_lock, irq_flags);
+
+    while (attach != NULL) {
+        shm_attach_t* next = attach->next;
+        segment_put(attach->segment);
+        kfree(attach);
+        attach = next;
+    }
+}
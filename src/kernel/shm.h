@@ -0,0 +1,96 @@
+/* src/kernel/shm.h - Segments de mémoire partagée entre processus */
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+struct process;
+
+/*
+ * Un segment est un ensemble de frames PMM (mises à zéro à la création)
+ * que plusieurs processus mappent dans leur page_directory_t, dans la zone
+ * USER_SHM_BASE..USER_SHM_END (memlayout.h). Les données échangées ne sont
+ * jamais copiées par le kernel : producteur et consommateur écrivent et
+ * lisent les mêmes pages.
+ *
+ * Chaque mapping (attachement) tient une référence sur le segment.
+ * shm_destroy retire le segment de la table (sa clé redevient libre), mais
+ * les frames ne sont rendues au PMM qu'au dernier shm_unmap ; un processus
+ * qui se termine détache tous ses segments (shm_detach_all).
+ *
+ * Les pages partagées ne sont pas des VMAs : vmm_free_directory ne les
+ * libère pas et vmm_clone_directory recopie leurs PTE telles quelles.
+ */
+
+/* ========================================
+ * Configuration
+ * ======================================== */
+
+#define SHM_MAX_SEGMENTS        64
+#define SHM_MAX_SIZE            (16 * 1024 * 1024)
+
+/* Clé privée : shm_create crée toujours un nouveau segment */
+#define SHM_KEY_PRIVATE         0
+
+/* ========================================
+ * Types
+ * ======================================== */
+
+/**
+ * Mapping d'un segment dans un processus (liste triée par adresse).
+ */
+typedef struct shm_attach {
+    struct shm_segment* segment;
+    uint64_t addr;              /* Adresse user du premier octet */
+    uint64_t size;              /* Taille mappée (multiple de page) */
+    struct shm_attach* next;
+} shm_attach_t;
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+/**
+ * Crée un segment de size octets, ou retrouve celui qui porte déjà la clé.
+ *
+ * @param key   Clé partagée entre processus, ou SHM_KEY_PRIVATE
+ * @param size  Taille en octets (arrondie à la page, au plus SHM_MAX_SIZE)
+ * @return Identifiant du segment (>= 0), ou -1 si erreur (taille invalide,
+ *         segment existant trop petit, table pleine, plus de mémoire)
+ */
+int shm_create(uint32_t key, uint64_t size);
+
+/**
+ * Mappe un segment dans l'espace d'adressage d'un processus.
+ *
+ * @param proc      Processus cible (doit avoir son propre page directory)
+ * @param id        Identifiant retourné par shm_create
+ * @param addr_out  Reçoit l'adresse user du mapping
+ * @return 0 si succès, -1 si erreur
+ */
+int shm_map(struct process* proc, int id, uint64_t* addr_out);
+
+/**
+ * Démappe le segment mappé à addr et rend sa référence.
+ *
+ * @return 0 si succès, -1 si aucun segment n'est mappé à cette adresse
+ */
+int shm_unmap(struct process* proc, uint64_t addr);
+
+/**
+ * Retire un segment de la table. Les mappings existants restent valides
+ * jusqu'à leur shm_unmap.
+ *
+ * @return 0 si succès, -1 si l'identifiant est inconnu
+ */
+int shm_destroy(int id);
+
+/**
+ * Détache tous les segments d'un processus qui se termine (appelé par le
+ * reaper avant vmm_free_directory ; les PTE ne sont pas effacées).
+ */
+void shm_detach_all(struct process* proc);
+
+#endif /* SHM_H */
@@ -138,6 +138,7 @@ int mutex_lock(mutex_t *mutex)
         /* Add to wait queue */
         current->state = THREAD_STATE_BLOCKED;
         current->waiting_queue = &mutex->waiters;
+        current->waiting_lock = &mutex->lock;
         
         /* Simple manual enqueue to waiters */
         thread_t **tail = &mutex->waiters.head;
@@ -159,6 +160,7 @@ int mutex_lock(mutex_t *mutex)
         
         /* Remove from wait queue (we were woken) */
         current->waiting_queue = NULL;
+        current->waiting_lock = NULL;
     }
     
     /* Acquire the mutex */
@@ -310,6 +312,7 @@ void sem_wait(semaphore_t *sem)
         /* Add to wait queue */
         current->state = THREAD_STATE_BLOCKED;
         current->waiting_queue = &sem->waiters;
+        current->waiting_lock = &sem->lock;
         
         thread_t **tail = &sem->waiters.head;
         while (*tail) {
@@ -326,6 +329,7 @@ void sem_wait(semaphore_t *sem)
         spinlock_lock(&sem->lock);
         
         current->waiting_queue = NULL;
+        current->waiting_lock = NULL;
     }
     
     /* Decrement count */
@@ -384,6 +388,7 @@ bool sem_timedwait(semaphore_t *sem, uint32_t timeout_ms)
         /* Add to wait queue */
         current->state = THREAD_STATE_BLOCKED;
         current->waiting_queue = &sem->waiters;
+        current->waiting_lock = &sem->lock;
         
         thread_t **tail = &sem->waiters.head;
         while (*tail) {
@@ -398,12 +403,15 @@ bool sem_timedwait(semaphore_t *sem, uint32_t timeout_ms)
         /* Set wake time for timeout */
         current->wake_tick = start_tick + timeout_ticks;
         current->state = THREAD_STATE_SLEEPING;
+        thread_wake_timer_arm(current, current->wake_tick);
         
         spinlock_unlock(&sem->lock);
         scheduler_schedule();
+        thread_wake_timer_cancel(current);
         spinlock_lock(&sem->lock);
         
         current->waiting_queue = NULL;
+        current->waiting_lock = NULL;
         current->wake_tick = 0;
     }
     
@@ -487,6 +495,7 @@ void condvar_wait(condvar_t *cv, mutex_t *mutex)
     /* Add to wait queue BEFORE releasing mutex (atomic condition) */
     current->state = THREAD_STATE_BLOCKED;
     current->waiting_queue = &cv->waiters;
+    current->waiting_lock = &cv->lock;
     
     thread_t **tail = &cv->waiters.head;
     while (*tail) {
@@ -535,6 +544,7 @@ void condvar_wait(condvar_t *cv, mutex_t *mutex)
     mutex_lock(mutex);
     
     current->waiting_queue = NULL;
+    current->waiting_lock = NULL;
     current->needs_yield = false;  /* Reset flag */
     
     cpu_restore_flags(flags);
@@ -558,6 +568,7 @@ bool condvar_timedwait(condvar_t *cv, mutex_t *mutex, uint32_t timeout_ms)
     /* Add to wait queue */
     current->state = THREAD_STATE_SLEEPING;  /* Use SLEEPING for timeout support */
     current->waiting_queue = &cv->waiters;
+    current->waiting_lock = &cv->lock;
     current->wake_tick = start_tick + timeout_ticks;
     
     thread_t **tail = &cv->waiters.head;
@@ -576,7 +587,9 @@ bool condvar_timedwait(condvar_t *cv, mutex_t *mutex, uint32_t timeout_ms)
     mutex_unlock(mutex);
     
     /* Block until signaled or timeout */
+    thread_wake_timer_arm(current, current->wake_tick);
     scheduler_schedule();
+    thread_wake_timer_cancel(current);
     
     /* Check if we timed out */
     bool timed_out = (timer_get_ticks() - start_tick >= timeout_ticks);
@@ -599,6 +612,7 @@ bool condvar_timedwait(condvar_t *cv, mutex_t *mutex, uint32_t timeout_ms)
     }
     
     current->waiting_queue = NULL;
+    current->waiting_lock = NULL;
     current->wake_tick = 0;
     
     /* Re-acquire mutex */
@@ -703,6 +717,7 @@ void rwlock_rdlock(rwlock_t *rwlock)
         /* Add to readers wait queue */
         current->state = THREAD_STATE_BLOCKED;
         current->waiting_queue = &rwlock->readers;
+        current->waiting_lock = &rwlock->lock;
         
         thread_t **tail = &rwlock->readers.head;
         while (*tail) {
@@ -719,6 +734,7 @@ void rwlock_rdlock(rwlock_t *rwlock)
         spinlock_lock(&rwlock->lock);
         
         current->waiting_queue = NULL;
+        current->waiting_lock = NULL;
     }
     
     /* Acquire read lock */
@@ -771,6 +787,7 @@ void rwlock_wrlock(rwlock_t *rwlock)
         /* Add to writers wait queue */
         current->state = THREAD_STATE_BLOCKED;
         current->waiting_queue = &rwlock->writers;
+        current->waiting_lock = &rwlock->lock;
         
         thread_t **tail = &rwlock->writers.head;
         while (*tail) {
@@ -787,6 +804,7 @@ void rwlock_wrlock(rwlock_t *rwlock)
         spinlock_lock(&rwlock->lock);
         
         current->waiting_queue = NULL;
+        current->waiting_lock = NULL;
     }
     
     /* Acquire write lock */
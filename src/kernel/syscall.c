@@ -15,6 +15,7 @@
 #include "../net/core/net.h"
 #include "../mm/kheap.h"
 #include "sync.h"
+#include "shm.h"
 #include "timer.h"
 
 /* Macro pour activer/désactiver les interruptions */
@@ -514,6 +515,70 @@ static int sys_meminfo(meminfo_t* info)
     return 0;
 }
 
+/* ========================================
+ * Shared Memory Syscalls
+ * ======================================== */
+
+/**
+ * SYS_SHM_CREATE (110) - Créer un segment de mémoire partagée
+ * 
+ * @param key   Clé commune aux processus, ou SHM_KEY_PRIVATE (0)
+ * @param size  Taille en octets
+ * @return Identifiant du segment, ou -1 si erreur
+ */
+static int sys_shm_create(uint32_t key, uint64_t size)
+{
+    return shm_create(key, size);
+}
+
+/**
+ * SYS_SHM_MAP (111) - Mapper un segment dans le processus courant
+ * 
+ * L'adresse est retournée par pointeur : la zone des segments est
+ * au-dessus de 4 GiB et le retour des syscalls est sur 32 bits.
+ * 
+ * @param id        Identifiant du segment
+ * @param addr_out  Reçoit l'adresse du mapping
+ * @return 0 si succès, -1 si erreur
+ */
+static int sys_shm_map(int id, uint64_t* addr_out)
+{
+    if (addr_out == NULL) {
+        return -1;
+    }
+    
+    uint64_t addr;
+    if (shm_map(current_process, id, &addr) != 0) {
+        return -1;
+    }
+    *addr_out = addr;
+    return 0;
+}
+
+/**
+ * SYS_SHM_UNMAP (112) - Démapper un segment du processus courant
+ * 
+ * @param addr  Adresse retournée par SYS_SHM_MAP
+ * @return 0 si succès, -1 si erreur
+ */
+static int sys_shm_unmap(uint64_t addr)
+{
+    return shm_unmap(current_process, addr);
+}
+
+/**
+ * SYS_SHM_DESTROY (113) - Détruire un segment
+ * 
+ * Les processus qui l'ont mappé gardent leur mapping jusqu'à SYS_SHM_UNMAP.
+ * 
+ * @param id  Identifiant du segment
+ * @return 0 si succès, -1 si erreur
+ */
+static int sys_shm_destroy(int id)
+{
+    return shm_destroy(id);
+}
+
 /* ========================================
  * Socket Syscalls
  * ======================================== */
@@ -922,9 +987,8 @@ void syscall_dispatcher(syscall_regs_t* regs)
     
     /* Vérifier si le mode compatibilité Linux est actif */
     if (linux_compat_is_active()) {
-        /* Déléguer au handler Linux */
-        result = linux_syscall_handler(regs);
-        regs->rax = (uint32_t)result;
+        /* Déléguer au handler Linux (retour 64 bits : adresses de brk/mmap) */
+        regs->rax = (uint64_t)linux_syscall_handler(regs);
         return;
     }
     
@@ -1016,6 +1080,23 @@ void syscall_dispatcher(syscall_regs_t* regs)
         case SYS_MEMINFO:
             result = sys_meminfo((meminfo_t*)regs->rdi);
             break;
+        
+        /* Shared memory syscalls */
+        case SYS_SHM_CREATE:
+            result = sys_shm_create((uint32_t)regs->rdi, regs->rsi);
+            break;
+            
+        case SYS_SHM_MAP:
+            result = sys_shm_map((int)regs->rdi, (uint64_t*)regs->rsi);
+            break;
+            
+        case SYS_SHM_UNMAP:
+            result = sys_shm_unmap(regs->rdi);
+            break;
+            
+        case SYS_SHM_DESTROY:
+            result = sys_shm_destroy((int)regs->rdi);
+            break;
             
         default:
             KLOG_ERROR("SYSCALL", "Unknown syscall number!");
@@ -35,6 +35,12 @@
 #define SYS_CLEAR       101     /* Effacer l'écran */
 #define SYS_MEMINFO     102     /* Obtenir les infos mémoire */
 
+/* Shared memory syscalls */
+#define SYS_SHM_CREATE  110     /* Créer (ou retrouver par clé) un segment partagé */
+#define SYS_SHM_MAP     111     /* Mapper un segment dans le processus */
+#define SYS_SHM_UNMAP   112     /* Démapper un segment */
+#define SYS_SHM_DESTROY 113     /* Détruire un segment */
+
 /* Nombre maximum de syscalls */
 #define MAX_SYSCALLS    256
 
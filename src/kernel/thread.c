@@ -4,8 +4,12 @@
 #include "console.h"
 #include "klog.h"
 #include "timer.h"
+#include "ktime.h"
 #include "sync.h"
+#include "shm.h"
 #include "../mm/kheap.h"
+#include "../mm/kmem_cache.h"
+#include "../mm/kstack.h"
 #include "../mm/vmm.h"
 #include "../include/string.h"
 #include "../arch/x86_64/gdt.h"
@@ -21,17 +25,27 @@ extern void jump_to_user(uint64_t rsp, uint64_t rip, uint64_t cr3);
 /* Thread actuellement en cours d'exécution */
 static thread_t *g_current_thread = NULL;
 
-/* Run queues par priorité */
-static thread_t *g_run_queues[THREAD_PRIORITY_COUNT] = { NULL };
+/* Run queues par priorité : FIFO tête/queue, et bitmap des niveaux non
+ * vides pour trouver le plus prioritaire en un bsr */
+typedef struct {
+    thread_t *head;
+    thread_t *tail;
+} run_queue_t;
+
+static run_queue_t g_run_queues[THREAD_PRIORITY_COUNT];
+static uint32_t g_run_bitmap = 0;
 static spinlock_t g_scheduler_lock;
 
-/* Liste des threads en sleep */
+/* Liste des threads en sleep (affichage ; le réveil passe par la roue de timers) */
 static thread_t *g_sleep_queue = NULL;
 static spinlock_t g_sleep_lock;
 
 /* Compteur de TID */
 static uint32_t g_next_tid = 1;
 
+/* Cache des structures thread_t (join_waiters construite une fois) */
+static kmem_cache_t *g_thread_cache = NULL;
+
 /* Flag scheduler actif */
 static bool g_scheduler_active = false;
 
@@ -54,6 +68,7 @@ extern void task_entry_point(void);
 /* Forward declarations */
 static thread_priority_t scheduler_nice_to_priority(int8_t nice);
 static uint32_t scheduler_get_time_slice(thread_t *thread);
+static bool wait_queue_unlink_locked(wait_queue_t *queue, thread_t *thread);
 
 static void safe_strcpy(char *dest, const char *src, uint32_t max_len)
 {
@@ -86,6 +101,122 @@ static inline void cpu_restore_flags(uint64_t flags)
     __asm__ volatile("pushq %0; popfq" : : "r"(flags) : "memory", "cc");
 }
 
+/* ========================================
+ * Run queues (g_scheduler_lock tenu)
+ * ======================================== */
+
+/* Priorité non vide la plus haute, -1 si tout est vide */
+static inline int runq_highest(void)
+{
+    if (g_run_bitmap == 0) return -1;
+
+    uint32_t pri;
+    __asm__ ("bsrl %1, %0" : "=r"(pri) : "rm"(g_run_bitmap) : "cc");
+    return (int)pri;
+}
+
+/* Ajoute en fin de queue : round-robin dans une même priorité.
+ * wait_start_tick croît donc de la tête vers la queue (aging). */
+static void runq_push_tail(thread_t *thread, thread_priority_t pri)
+{
+    run_queue_t *rq = &g_run_queues[pri];
+
+    thread->wait_start_tick = timer_get_ticks();
+
+    thread->sched_next = NULL;
+    thread->sched_prev = rq->tail;
+    if (rq->tail) {
+        rq->tail->sched_next = thread;
+    } else {
+        rq->head = thread;
+    }
+    rq->tail = thread;
+
+    thread->sched_queue = (int8_t)pri;
+    g_run_bitmap |= (1u << pri);
+}
+
+/* Retire un thread de la queue où il a été rangé (sched_queue) */
+static void runq_remove(thread_t *thread)
+{
+    if (thread->sched_queue < 0) return;
+
+    run_queue_t *rq = &g_run_queues[thread->sched_queue];
+
+    if (thread->sched_prev) {
+        thread->sched_prev->sched_next = thread->sched_next;
+    } else {
+        rq->head = thread->sched_next;
+    }
+    if (thread->sched_next) {
+        thread->sched_next->sched_prev = thread->sched_prev;
+    } else {
+        rq->tail = thread->sched_prev;
+    }
+    if (!rq->head) {
+        g_run_bitmap &= ~(1u << thread->sched_queue);
+    }
+
+    thread->sched_next = NULL;
+    thread->sched_prev = NULL;
+    thread->sched_queue = -1;
+}
+
+/* Retire la tête de la queue la plus prioritaire, NULL si tout est vide */
+static thread_t *runq_pop_highest(void)
+{
+    int pri = runq_highest();
+    if (pri < 0) return NULL;
+
+    thread_t *thread = g_run_queues[pri].head;
+    runq_remove(thread);
+    return thread;
+}
+
+/* ========================================
+ * Timer de réveil
+ * ======================================== */
+
+/* Callback de la roue de timers (contexte IRQ) */
+static void thread_wake_timer_fn(timer_entry_t *timer, void *arg)
+{
+    (void)timer;
+    thread_t *thread = (thread_t *)arg;
+
+    /* Déjà réveillé (signal, post, kill) : rien à faire */
+    if (thread->state != THREAD_STATE_SLEEPING && thread->state != THREAD_STATE_BLOCKED) {
+        return;
+    }
+
+    wait_queue_t *queue = thread->waiting_queue;
+    if (queue) {
+        thread->wait_result = -ETIMEDOUT;
+        if (thread->waiting_lock) {
+            /* Queue d'un objet de synchronisation : son verrou la protège */
+            spinlock_lock(thread->waiting_lock);
+            wait_queue_unlink_locked(queue, thread);
+            spinlock_unlock(thread->waiting_lock);
+        } else {
+            wait_queue_remove(queue, thread);
+        }
+    }
+
+    thread->state = THREAD_STATE_READY;
+    scheduler_enqueue(thread);
+}
+
+void thread_wake_timer_arm(thread_t *thread, uint64_t wake_tick)
+{
+    if (!thread) return;
+    timer_wheel_arm(&thread->wake_timer, wake_tick);
+}
+
+void thread_wake_timer_cancel(thread_t *thread)
+{
+    if (!thread) return;
+    timer_wheel_cancel(&thread->wake_timer);
+}
+
 /* ========================================
  * Wait Queue Implementation
  * ======================================== */
@@ -126,16 +257,13 @@ static thread_t *wait_queue_dequeue_locked(wait_queue_t *queue)
     
     thread->wait_queue_next = NULL;
     thread->waiting_queue = NULL;
+    thread->waiting_lock = NULL;
     return thread;
 }
 
-/* Remove a specific thread from a wait queue (for timeout forced removal) */
-bool wait_queue_remove(wait_queue_t *queue, thread_t *thread)
+/* Unlink a specific thread from a wait queue (lock held by the caller) */
+static bool wait_queue_unlink_locked(wait_queue_t *queue, thread_t *thread)
 {
-    if (!queue || !thread) return false;
-    
-    spinlock_lock(&queue->lock);
-    
     /* Search for the thread in the queue */
     thread_t *prev = NULL;
     thread_t *curr = queue->head;
@@ -147,7 +275,6 @@ bool wait_queue_remove(wait_queue_t *queue, thread_t *thread)
     
     if (!curr) {
         /* Thread not found in queue */
-        spinlock_unlock(&queue->lock);
         return false;
     }
     
@@ -164,10 +291,20 @@ bool wait_queue_remove(wait_queue_t *queue, thread_t *thread)
     
     curr->wait_queue_next = NULL;
     curr->waiting_queue = NULL;
+    curr->waiting_lock = NULL;
     curr->current_wait_queue = NULL;
+    return true;
+}
+
+/* Remove a specific thread from a wait queue (for timeout forced removal) */
+bool wait_queue_remove(wait_queue_t *queue, thread_t *thread)
+{
+    if (!queue || !thread) return false;
     
+    spinlock_lock(&queue->lock);
+    bool removed = wait_queue_unlink_locked(queue, thread);
     spinlock_unlock(&queue->lock);
-    return true;
+    return removed;
 }
 
 bool wait_queue_wait_timeout(wait_queue_t *queue, wait_queue_predicate_t predicate, 
@@ -211,8 +348,12 @@ bool wait_queue_wait_timeout(wait_queue_t *queue, wait_queue_predicate_t predica
         
         spinlock_unlock(&queue->lock);
         
-        /* Céder le CPU - scheduler will check timeout */
+        /* Céder le CPU ; la roue de timers réveille au timeout */
+        if (thread->timeout_tick) {
+            thread_wake_timer_arm(thread, thread->timeout_tick);
+        }
         scheduler_schedule();
+        thread_wake_timer_cancel(thread);
         
         /* Back from sleep - check what happened */
         spinlock_lock(&queue->lock);
@@ -301,7 +442,7 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
     KLOG_INFO("THREAD", name ? name : "<unnamed>");
     
     /* Allouer la structure thread */
-    thread_t *thread = (thread_t *)kmalloc(sizeof(thread_t));
+    thread_t *thread = (thread_t *)kmem_cache_alloc(g_thread_cache);
     if (!thread) {
         KLOG_ERROR("THREAD", "Failed to allocate thread structure");
         return NULL;
@@ -312,10 +453,10 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
         stack_size = THREAD_DEFAULT_STACK_SIZE;
     }
     
-    void *stack = kmalloc(stack_size);
+    void *stack = kstack_alloc(stack_size);
     if (!stack) {
         KLOG_ERROR("THREAD", "Failed to allocate thread stack");
-        kfree(thread);
+        kmem_cache_free(g_thread_cache, thread);
         return NULL;
     }
     
@@ -338,6 +479,7 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
     
     thread->stack_base = stack;
     thread->stack_size = stack_size;
+    thread->stack_high_water = 0;
     thread->rsp0 = (uint64_t)stack + stack_size;
     
     thread->entry = entry;
@@ -356,13 +498,19 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
     thread->cpu_ticks = 0;
     thread->context_switches = 0;
     thread->run_start_tick = 0;
+    thread->cpu_ns = 0;
+    thread->run_start_ns = 0;
 
     /* SMP preparation */
     thread->cpu_affinity = 0xFFFFFFFF;  /* Can run on any CPU */
     thread->last_cpu = 0;               /* Default to CPU 0 */
 
     thread->wake_tick = 0;
+    timer_entry_init(&thread->wake_timer, thread_wake_timer_fn, thread);
+    thread->sleep_next = NULL;
+    thread->sleep_prev = NULL;
     thread->waiting_queue = NULL;
+    thread->waiting_lock = NULL;
     thread->wait_queue_next = NULL;
 
     /* Timeout support */
@@ -370,8 +518,8 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
     thread->wait_result = 0;
     thread->current_wait_queue = NULL;
 
-    /* Join support */
-    wait_queue_init(&thread->join_waiters);
+    /* Join support : join_waiters est construite par g_thread_cache
+     * et toujours vide quand la structure y est rendue */
 
     /* Reaper support */
     thread->zombie_next = NULL;
@@ -382,6 +530,7 @@ thread_t *thread_create(const char *name, thread_entry_t entry, void *arg,
 
     thread->sched_next = NULL;
     thread->sched_prev = NULL;
+    thread->sched_queue = -1;
     thread->proc_next = NULL;
 
     /* Préemption */
@@ -497,7 +646,7 @@ thread_t *thread_create_user(process_t *proc, const char *name,
     KLOG_INFO_HEX("THREAD", "User ESP: ", user_rsp);
     
     /* Allouer la structure thread */
-    thread_t *thread = (thread_t *)kmalloc(sizeof(thread_t));
+    thread_t *thread = (thread_t *)kmem_cache_alloc(g_thread_cache);
     if (!thread) {
         KLOG_ERROR("THREAD", "Failed to allocate thread structure");
         return NULL;
@@ -523,6 +672,7 @@ thread_t *thread_create_user(process_t *proc, const char *name,
     /* La stack du thread est la kernel stack (pour les syscalls) */
     thread->stack_base = kernel_stack;
     thread->stack_size = kernel_stack_size;
+    thread->stack_high_water = 0;
     thread->rsp0 = (uint64_t)kernel_stack + kernel_stack_size;
     
     thread->entry = NULL;  /* Pas de fonction entry pour user threads */
@@ -542,13 +692,19 @@ thread_t *thread_create_user(process_t *proc, const char *name,
     thread->cpu_ticks = 0;
     thread->context_switches = 0;
     thread->run_start_tick = 0;
+    thread->cpu_ns = 0;
+    thread->run_start_ns = 0;
 
     /* SMP preparation */
     thread->cpu_affinity = 0xFFFFFFFF;
     thread->last_cpu = 0;
 
     thread->wake_tick = 0;
+    timer_entry_init(&thread->wake_timer, thread_wake_timer_fn, thread);
+    thread->sleep_next = NULL;
+    thread->sleep_prev = NULL;
     thread->waiting_queue = NULL;
+    thread->waiting_lock = NULL;
     thread->wait_queue_next = NULL;
 
     /* Timeout support */
@@ -556,8 +712,8 @@ thread_t *thread_create_user(process_t *proc, const char *name,
     thread->wait_result = 0;
     thread->current_wait_queue = NULL;
 
-    /* Join support */
-    wait_queue_init(&thread->join_waiters);
+    /* Join support : join_waiters est construite par g_thread_cache
+     * et toujours vide quand la structure y est rendue */
 
     /* Reaper support */
     thread->zombie_next = NULL;
@@ -568,6 +724,7 @@ thread_t *thread_create_user(process_t *proc, const char *name,
 
     thread->sched_next = NULL;
     thread->sched_prev = NULL;
+    thread->sched_queue = -1;
     thread->proc_next = NULL;
 
     /* Préemption */
@@ -861,8 +1018,11 @@ uint64_t thread_get_cpu_time_ms(thread_t *thread)
 {
     if (!thread) return 0;
 
-    /* Timer runs at 1000 Hz, so ticks = milliseconds */
-    return thread->cpu_ticks;
+    uint64_t ns = thread->cpu_ns;
+    if (thread == g_current_thread && thread->run_start_ns > 0) {
+        ns += ktime_get_ns() - thread->run_start_ns;
+    }
+    return ns / 1000000;
 }
 
 void thread_yield(void)
@@ -883,27 +1043,39 @@ void thread_sleep_ticks(uint64_t ticks)
     thread->wake_tick = timer_get_ticks() + ticks;
     thread->state = THREAD_STATE_SLEEPING;
     
-    /* Ajouter à la sleep queue (triée par wake_tick) */
+    /* Ajouter à la sleep list, O(1) */
     spinlock_lock(&g_sleep_lock);
-    
-    if (!g_sleep_queue || thread->wake_tick < g_sleep_queue->wake_tick) {
-        thread->sched_next = g_sleep_queue;
-        g_sleep_queue = thread;
-    } else {
-        thread_t *prev = g_sleep_queue;
-        while (prev->sched_next && prev->sched_next->wake_tick <= thread->wake_tick) {
-            prev = prev->sched_next;
-        }
-        thread->sched_next = prev->sched_next;
-        prev->sched_next = thread;
+    thread->sleep_prev = NULL;
+    thread->sleep_next = g_sleep_queue;
+    if (g_sleep_queue) {
+        g_sleep_queue->sleep_prev = thread;
     }
-    
+    g_sleep_queue = thread;
     spinlock_unlock(&g_sleep_lock);
     
+    thread_wake_timer_arm(thread, thread->wake_tick);
+    
     /* scheduler_schedule() gère lui-même cli/sti et le context switch.
      * Au retour, les interruptions seront dans l'état approprié. */
     scheduler_schedule();
     
+    /* Réveil anticipé possible (thread_kill) */
+    thread_wake_timer_cancel(thread);
+    
+    uint64_t sleep_flags = spinlock_irqsave(&g_sleep_lock);
+    if (thread->sleep_prev) {
+        thread->sleep_prev->sleep_next = thread->sleep_next;
+    } else {
+        g_sleep_queue = thread->sleep_next;
+    }
+    if (thread->sleep_next) {
+        thread->sleep_next->sleep_prev = thread->sleep_prev;
+    }
+    thread->sleep_next = NULL;
+    thread->sleep_prev = NULL;
+    thread->wake_tick = 0;
+    spinlock_irqrestore(&g_sleep_lock, sleep_flags);
+    
     /* Restaurer l'état des interruptions d'avant l'appel */
     cpu_restore_flags(flags);
 }
@@ -953,8 +1125,15 @@ static void idle_thread_func(void *arg)
     (void)arg;
     KLOG_INFO("IDLE", "Idle thread started, enabling interrupts");
     for (;;) {
-        /* Enable interrupts and halt until next IRQ */
-        __asm__ volatile("sti; hlt");
+        cpu_cli();
+        if (g_run_bitmap == 0) {
+            /* Rien à exécuter : arrêter le tick jusqu'au prochain timer,
+             * puis halt jusqu'à la prochaine IRQ (sti; hlt est atomique) */
+            timer_idle_enter();
+            __asm__ volatile("sti; hlt; cli");
+            timer_idle_exit();
+        }
+        cpu_sti();
         
         /* After waking from hlt (IRQ occurred), check if another thread is ready.
          * This is necessary because the IRQ handler (e.g., keyboard) may have
@@ -966,6 +1145,13 @@ static void idle_thread_func(void *arg)
 /* Thread principal statique (représente le kernel/shell au boot) */
 static thread_t g_main_thread_struct;
 
+/* Constructeur de g_thread_cache */
+static void thread_ctor(void *obj)
+{
+    thread_t *thread = (thread_t *)obj;
+    wait_queue_init(&thread->join_waiters);
+}
+
 void scheduler_init(void)
 {
     KLOG_INFO("SCHED", "=== Initializing Scheduler ===");
@@ -973,10 +1159,17 @@ void scheduler_init(void)
     spinlock_init(&g_scheduler_lock);
     spinlock_init(&g_sleep_lock);
     
+    g_thread_cache = kmem_cache_create("thread", sizeof(thread_t), 0, thread_ctor);
+    if (!g_thread_cache) {
+        KLOG_ERROR("SCHED", "Failed to create thread cache");
+    }
+    
     /* Initialiser les run queues */
     for (int i = 0; i < THREAD_PRIORITY_COUNT; i++) {
-        g_run_queues[i] = NULL;
+        g_run_queues[i].head = NULL;
+        g_run_queues[i].tail = NULL;
     }
+    g_run_bitmap = 0;
     
     /* Créer le "thread main" statique qui représente le code kernel actuel
      * Ce thread n'a pas de stack préparée - il utilise la stack courante
@@ -993,6 +1186,7 @@ void scheduler_init(void)
     main_thread->exit_status = 0;
     main_thread->stack_base = NULL;  /* Pas de stack allouée */
     main_thread->stack_size = 0;
+    main_thread->stack_high_water = 0;
     main_thread->rsp = 0;  /* Sera rempli lors du premier switch */
     main_thread->rsp0 = 0;
     main_thread->entry = NULL;
@@ -1010,13 +1204,19 @@ void scheduler_init(void)
     main_thread->cpu_ticks = 0;
     main_thread->context_switches = 0;
     main_thread->run_start_tick = 0;
+    main_thread->cpu_ns = 0;
+    main_thread->run_start_ns = 0;
 
     /* SMP preparation */
     main_thread->cpu_affinity = 0xFFFFFFFF;
     main_thread->last_cpu = 0;
 
     main_thread->wake_tick = 0;
+    timer_entry_init(&main_thread->wake_timer, thread_wake_timer_fn, main_thread);
+    main_thread->sleep_next = NULL;
+    main_thread->sleep_prev = NULL;
     main_thread->waiting_queue = NULL;
+    main_thread->waiting_lock = NULL;
     main_thread->wait_queue_next = NULL;
 
     /* Timeout support */
@@ -1036,6 +1236,7 @@ void scheduler_init(void)
 
     main_thread->sched_next = NULL;
     main_thread->sched_prev = NULL;
+    main_thread->sched_queue = -1;
     main_thread->proc_next = NULL;
     main_thread->preempt_count = 0;
     main_thread->preempt_pending = false;
@@ -1076,12 +1277,6 @@ void scheduler_tick(void)
         g_current_thread->cpu_ticks++;
     }
 
-    /* Réveiller les threads endormis */
-    scheduler_wake_sleeping();
-
-    /* Check blocked threads with expired timeouts */
-    check_thread_timeouts();
-
     /* Décrémenter le time slice */
     if (g_current_thread != g_idle_thread && g_current_thread->time_slice_remaining > 0) {
         g_current_thread->time_slice_remaining--;
@@ -1093,47 +1288,26 @@ void scheduler_tick(void)
         g_current_thread->preempt_pending = true;
     }
 
-    /* Rocket Boost aging: check all run queues except UI for starvation
+    /* Rocket Boost aging: the run queues are FIFO, so the head of each
+     * queue is its longest waiter and only heads need checking. A thread is
+     * boosted at most once per wait, so the cost per tick is amortized O(1)
+     * whatever the number of runnable threads.
      * Note: We're in IRQ context (timer), use IRQ-safe spinlock for safety */
     uint64_t sched_flags = spinlock_irqsave(&g_scheduler_lock);
 
     for (int pri = THREAD_PRIORITY_IDLE; pri < THREAD_PRIORITY_UI; pri++) {
-        thread_t *thread = g_run_queues[pri];
+        if (!(g_run_bitmap & (1u << pri))) continue;
 
-        while (thread) {
-            thread_t *next = thread->sched_next;  /* Save next before we move thread */
-
-            /* Check if thread has been waiting too long */
-            if (!thread->is_boosted &&
-                (now - thread->wait_start_tick) >= THREAD_AGING_THRESHOLD) {
-
-                /* Remove from current queue */
-                if (thread->sched_prev) {
-                    thread->sched_prev->sched_next = thread->sched_next;
-                } else {
-                    g_run_queues[pri] = thread->sched_next;
-                }
-
-                if (thread->sched_next) {
-                    thread->sched_next->sched_prev = thread->sched_prev;
-                }
-
-                /* Boost to UI priority */
-                thread->priority = THREAD_PRIORITY_UI;
-                thread->is_boosted = true;
-                thread->wait_start_tick = now;  /* Reset wait timer */
+        thread_t *thread = g_run_queues[pri].head;
+        while (thread && (now - thread->wait_start_tick) >= THREAD_AGING_THRESHOLD) {
+            runq_remove(thread);
 
-                /* Insert at head of UI queue */
-                thread->sched_prev = NULL;
-                thread->sched_next = g_run_queues[THREAD_PRIORITY_UI];
+            /* Boost to UI priority (push resets the wait timer) */
+            thread->priority = THREAD_PRIORITY_UI;
+            thread->is_boosted = true;
+            runq_push_tail(thread, THREAD_PRIORITY_UI);
 
-                if (g_run_queues[THREAD_PRIORITY_UI]) {
-                    g_run_queues[THREAD_PRIORITY_UI]->sched_prev = thread;
-                }
-                g_run_queues[THREAD_PRIORITY_UI] = thread;
-            }
-
-            thread = next;
+            thread = g_run_queues[pri].head;
         }
     }
 
@@ -1147,25 +1321,10 @@ void scheduler_tick(void)
 /* Fonction utilisée par scheduler_preempt pour pick sans lock (déjà pris) */
 static thread_t *scheduler_pick_next_nolock(void)
 {
-    /* Parcourir les priorités de la plus haute à la plus basse */
-    for (int pri = THREAD_PRIORITY_COUNT - 1; pri >= THREAD_PRIORITY_IDLE; pri--) {
-        if (g_run_queues[pri]) {
-            thread_t *thread = g_run_queues[pri];
-            
-            /* Retirer de la queue */
-            g_run_queues[pri] = thread->sched_next;
-            if (thread->sched_next) {
-                thread->sched_next->sched_prev = NULL;
-            }
-            thread->sched_next = NULL;
-            thread->sched_prev = NULL;
-            
-            return thread;
-        }
-    }
-    
+    thread_t *thread = runq_pop_highest();
+
     /* Aucun thread prêt, retourner idle */
-    return g_idle_thread;
+    return thread ? thread : g_idle_thread;
 }
 
 /* Ajoute un thread à la run queue sans prendre le lock */
@@ -1178,13 +1337,9 @@ static void scheduler_enqueue_nolock(thread_t *thread)
         pri = THREAD_PRIORITY_NORMAL;
     }
     
-    thread->sched_prev = NULL;
-    thread->sched_next = g_run_queues[pri];
-    
-    if (g_run_queues[pri]) {
-        g_run_queues[pri]->sched_prev = thread;
-    }
-    g_run_queues[pri] = thread;
+    /* Déjà rangé (changement de priorité) : le déplacer */
+    runq_remove(thread);
+    runq_push_tail(thread, pri);
     
     if (thread->state != THREAD_STATE_RUNNING) {
         thread->state = THREAD_STATE_READY;
@@ -1213,9 +1368,6 @@ uint64_t scheduler_preempt(interrupt_frame_t *frame)
         return 0;
     }
     
-    /* Réveiller les threads endormis */
-    scheduler_wake_sleeping();
-    
     /* Décrémenter le time slice */
     if (g_current_thread != g_idle_thread && g_current_thread->time_slice_remaining > 0) {
         g_current_thread->time_slice_remaining--;
@@ -1254,7 +1406,9 @@ uint64_t scheduler_preempt(interrupt_frame_t *frame)
     /* Chercher un thread KERNEL dans les run queues (sans retirer) */
     thread_t *next = NULL;
     for (int pri = THREAD_PRIORITY_COUNT - 1; pri >= THREAD_PRIORITY_IDLE && !next; pri--) {
-        thread_t *t = g_run_queues[pri];
+        if (!(g_run_bitmap & (1u << pri))) continue;
+
+        thread_t *t = g_run_queues[pri].head;
         while (t) {
             /* Accepter seulement les threads kernel (owner == NULL) */
             if (t->owner == NULL && t != current) {
@@ -1276,27 +1430,21 @@ uint64_t scheduler_preempt(interrupt_frame_t *frame)
     }
     
     /* Retirer le thread sélectionné de sa queue */
-    thread_priority_t pri = next->priority;
-    if (next->sched_prev) {
-        next->sched_prev->sched_next = next->sched_next;
-    } else {
-        g_run_queues[pri] = next->sched_next;
-    }
-    if (next->sched_next) {
-        next->sched_next->sched_prev = next->sched_prev;
-    }
-    next->sched_next = NULL;
-    next->sched_prev = NULL;
+    runq_remove(next);
     
     /* On va changer de thread ! */
 
     uint64_t now = timer_get_ticks();
 
     /* CPU accounting: finalize current thread's run time */
+    uint64_t now_ns = ktime_get_ns();
     if (current->run_start_tick > 0) {
         uint64_t run_duration = now - current->run_start_tick;
         current->cpu_ticks += run_duration;
     }
+    if (current->run_start_ns > 0) {
+        current->cpu_ns += now_ns - current->run_start_ns;
+    }
 
     /* Boost demotion: if current thread was boosted, demote it back */
     if (current->is_boosted) {
@@ -1308,12 +1456,12 @@ uint64_t scheduler_preempt(interrupt_frame_t *frame)
     /* Remettre le thread actuel dans la run queue */
     if (current->state == THREAD_STATE_RUNNING) {
         current->state = THREAD_STATE_READY;
-        current->wait_start_tick = now;  /* Start aging timer */
         scheduler_enqueue_nolock(current);
     }
 
     /* CPU accounting: start next thread's run time */
     next->run_start_tick = now;
+    next->run_start_ns = now_ns;
     next->context_switches++;
 
     /* Recharger le time slice du nouveau thread (use priority-based slice) */
@@ -1379,26 +1527,6 @@ bool preempt_enabled(void)
     return g_current_thread->preempt_count == 0;
 }
 
-void scheduler_wake_sleeping(void)
-{
-    uint64_t now = timer_get_ticks();
-    
-    spinlock_lock(&g_sleep_lock);
-    
-    while (g_sleep_queue && g_sleep_queue->wake_tick <= now) {
-        thread_t *thread = g_sleep_queue;
-        g_sleep_queue = thread->sched_next;
-        thread->sched_next = NULL;
-        thread->state = THREAD_STATE_READY;
-        
-        spinlock_unlock(&g_sleep_lock);
-        scheduler_enqueue(thread);
-        spinlock_lock(&g_sleep_lock);
-    }
-    
-    spinlock_unlock(&g_sleep_lock);
-}
-
 void scheduler_enqueue(thread_t *thread)
 {
     if (!thread || thread->state == THREAD_STATE_RUNNING) return;
@@ -1406,25 +1534,7 @@ void scheduler_enqueue(thread_t *thread)
     /* Use IRQ-safe spinlock since this can be called from IRQ context
      * (e.g., condvar_broadcast from tcp_handle_packet in IRQ handler) */
     uint64_t flags = spinlock_irqsave(&g_scheduler_lock);
-    
-    thread_priority_t pri = thread->priority;
-    if (pri >= THREAD_PRIORITY_COUNT) {
-        pri = THREAD_PRIORITY_NORMAL;
-    }
-    
-    /* Ajouter en fin de queue (FIFO dans la même priorité) */
-    thread->sched_prev = NULL;
-    thread->sched_next = g_run_queues[pri];
-    
-    if (g_run_queues[pri]) {
-        g_run_queues[pri]->sched_prev = thread;
-    }
-    g_run_queues[pri] = thread;
-    
-    if (thread->state != THREAD_STATE_RUNNING) {
-        thread->state = THREAD_STATE_READY;
-    }
-    
+    scheduler_enqueue_nolock(thread);
     spinlock_irqrestore(&g_scheduler_lock, flags);
 }
 
@@ -1435,24 +1545,9 @@ void scheduler_dequeue(thread_t *thread)
     /* Use IRQ-safe spinlock for consistency with scheduler_enqueue */
     uint64_t flags = spinlock_irqsave(&g_scheduler_lock);
     
-    thread_priority_t pri = thread->priority;
-    if (pri >= THREAD_PRIORITY_COUNT) {
-        pri = THREAD_PRIORITY_NORMAL;
-    }
-    
-    /* Retirer de la liste */
-    if (thread->sched_prev) {
-        thread->sched_prev->sched_next = thread->sched_next;
-    } else if (g_run_queues[pri] == thread) {
-        g_run_queues[pri] = thread->sched_next;
-    }
-    
-    if (thread->sched_next) {
-        thread->sched_next->sched_prev = thread->sched_prev;
-    }
-    
-    thread->sched_next = NULL;
-    thread->sched_prev = NULL;
+    /* Retirer de la queue où il a été rangé, même si sa priorité a changé
+     * depuis (héritage de priorité, thread_set_priority) */
+    runq_remove(thread);
     
     spinlock_irqrestore(&g_scheduler_lock, flags);
 }
@@ -1461,29 +1556,11 @@ void scheduler_dequeue(thread_t *thread)
 static thread_t *scheduler_pick_next(void)
 {
     spinlock_lock(&g_scheduler_lock);
-    
-    /* Parcourir les priorités de la plus haute à la plus basse */
-    for (int pri = THREAD_PRIORITY_COUNT - 1; pri >= THREAD_PRIORITY_IDLE; pri--) {
-        if (g_run_queues[pri]) {
-            thread_t *thread = g_run_queues[pri];
-            
-            /* Retirer de la queue */
-            g_run_queues[pri] = thread->sched_next;
-            if (thread->sched_next) {
-                thread->sched_next->sched_prev = NULL;
-            }
-            thread->sched_next = NULL;
-            thread->sched_prev = NULL;
-            
-            spinlock_unlock(&g_scheduler_lock);
-            return thread;
-        }
-    }
-    
+    thread_t *thread = runq_pop_highest();
     spinlock_unlock(&g_scheduler_lock);
     
     /* Aucun thread prêt, retourner le thread idle */
-    return g_idle_thread;
+    return thread ? thread : g_idle_thread;
 }
 
 /* Fonction ASM de context switch (définie dans switch.s) */
@@ -1514,10 +1591,14 @@ void scheduler_schedule(void)
     uint64_t now = timer_get_ticks();
 
     /* CPU accounting: finalize current thread's run time */
+    uint64_t now_ns = ktime_get_ns();
     if (current && current->run_start_tick > 0) {
         uint64_t run_duration = now - current->run_start_tick;
         current->cpu_ticks += run_duration;
     }
+    if (current && current->run_start_ns > 0) {
+        current->cpu_ns += now_ns - current->run_start_ns;
+    }
 
     /* Boost demotion: if current thread was boosted, demote it back */
     if (current && current->is_boosted) {
@@ -1530,12 +1611,12 @@ void scheduler_schedule(void)
     if (current && (current->state == THREAD_STATE_RUNNING ||
                     current->state == THREAD_STATE_READY)) {
         current->state = THREAD_STATE_READY;
-        current->wait_start_tick = now;  /* Start aging timer */
         scheduler_enqueue(current);
     }
 
     /* CPU accounting: start next thread's run time */
     next->run_start_tick = now;
+    next->run_start_ns = now_ns;
     next->context_switches++;
 
     /* Basculer vers le nouveau thread */
@@ -1555,18 +1636,18 @@ void scheduler_schedule(void)
     }
     
     /* Context switch :
-     * Utiliser le CR3 du processus owner si disponible (user),
-     * sinon le CR3 du kernel (thread noyau).
+     * Utiliser l'espace d'adressage du processus owner si disponible (user),
+     * sinon celui du kernel (thread noyau). Avec PCID, la valeur de CR3
+     * porte l'identifiant de l'espace et évite de vider le TLB.
      */
-    uint64_t new_cr3;
-    if (next->owner && next->owner->cr3) {
-        new_cr3 = next->owner->cr3;
-    } else {
-        new_cr3 = vmm_get_kernel_cr3();
+    page_directory_t *next_dir = vmm_get_kernel_directory();
+    if (next->owner && next->owner->pml4) {
+        next_dir = (page_directory_t *)next->owner->pml4;
     }
+    uint64_t new_cr3 = vmm_get_switch_cr3(next_dir);
     
     /* Sanity check CR3 */
-    if (new_cr3 < 0x1000 || (new_cr3 & 0xFFF) != 0) {
+    if ((new_cr3 & PAGE_FRAME_MASK) < 0x1000) {
         KLOG_ERROR_HEX("SCHED", "FATAL: Invalid CR3 = ", (uint32_t)new_cr3);
         for (;;) asm volatile("hlt");
     }
@@ -1600,68 +1681,6 @@ void scheduler_schedule(void)
      */
 }
 
-/* ========================================
- * Timeout Checking (called from scheduler_tick)
- * ======================================== */
-
-void check_thread_timeouts(void)
-{
-    uint64_t now = timer_get_ticks();
-    
-    /* We need to check all blocked threads with timeouts.
-     * For now, we iterate through all run queues and check blocked threads.
-     * In a more complete implementation, we'd have a separate timeout queue.
-     */
-    
-    /* Note: Blocked threads are NOT in run queues - they're in wait queues.
-     * We need to check all threads that have a timeout set.
-     * This is done by storing current_wait_queue pointer in thread_t.
-     * 
-     * For efficiency, we iterate over known places:
-     * 1. The scheduler_wake_sleeping already handles sleep timeouts
-     * 2. We need to check threads blocked on wait queues
-     * 
-     * Since we don't have a global list of all threads, we rely on
-     * the timeout being checked when the thread is in a wait queue.
-     * The wait queue functions check timeout_tick.
-     * 
-     * A better approach: maintain a timeout heap, but for simplicity,
-     * we scan threads that have timeout_tick set and are BLOCKED.
-     */
-    
-    /* For now, we check threads that are blocked and have a timeout set.
-     * This requires iterating - in a production kernel, use a timer wheel.
-     * 
-     * Optimization: Keep a separate sorted timeout list.
-     * For now, blocked threads with timeout are woken by their wait queues
-     * checking thread->wait_result after scheduler_schedule returns.
-     */
-    
-    /* Simple implementation: Check all queues for timed-out blocked threads
-     * Note: Called from IRQ context, use IRQ-safe spinlock for safety */
-    uint64_t timeout_flags = spinlock_irqsave(&g_scheduler_lock);
-    
-    /* Scan all priority queues - but blocked threads aren't here!
-     * Blocked threads are in wait queues, not run queues.
-     * We need a different approach: check when the thread is about to sleep.
-     * The check happens in wait_queue_wait_timeout.
-     */
-    
-    spinlock_irqrestore(&g_scheduler_lock, timeout_flags);
-    
-    /* Alternative: use a global thread list or timeout list.
-     * For now, the timeout mechanism works as follows:
-     * 1. Thread calls wait_queue_wait_timeout with timeout_ms
-     * 2. Thread sets timeout_tick = now + timeout_ms
-     * 3. Thread goes to sleep (scheduler_schedule)
-     * 4. When scheduler_tick runs, we need to wake threads whose timeout expired
-     * 5. The woken thread finds wait_result = -ETIMEDOUT
-     * 
-     * Implementation: Add blocked threads to sleep queue with wake_tick = timeout_tick
-     * Then scheduler_wake_sleeping will wake them automatically!
-     */
-}
-
 /* ========================================
  * Reaper Thread - Zombie Cleanup
  * ======================================== */
@@ -1714,6 +1733,9 @@ static void reaper_thread_func(void *arg)
                 /* Réveiller les threads en attente sur ce processus (waitpid) */
                 wait_queue_wake_all(&proc->wait_queue);
                 
+                /* Rendre les segments partagés avant de libérer les tables */
+                shm_detach_all(proc);
+                
                 /* Libérer le Page Directory si ce n'est pas le kernel directory */
                 if (proc->pml4 && 
                     proc->pml4 != (uint64_t*)vmm_get_kernel_directory()) {
@@ -1724,7 +1746,7 @@ static void reaper_thread_func(void *arg)
                 
                 /* Libérer la kernel stack du processus */
                 if (proc->stack_base) {
-                    kfree(proc->stack_base);
+                    kstack_free(proc->stack_base);
                     proc->stack_base = NULL;
                 }
                 
@@ -1737,13 +1759,13 @@ static void reaper_thread_func(void *arg)
         
         /* Free thread stack */
         if (zombie->stack_base) {
-            kfree(zombie->stack_base);
+            kstack_free(zombie->stack_base);
             zombie->stack_base = NULL;
         }
         
         /* Don't free the main thread structure (it's static) */
         if (zombie != &g_main_thread_struct) {
-            kfree(zombie);
+            kmem_cache_free(g_thread_cache, zombie);
         }
     }
 }
@@ -1838,6 +1860,20 @@ static void print_thread_info(thread_t *thread, bool is_current)
     console_put_dec(thread->context_switches);
     console_puts("  ");
 
+    /* Stack high-water mark (KiB utilisés / taille) */
+    if (thread->stack_base) {
+        uint64_t used = kstack_high_water(thread->stack_base, thread->stack_size);
+        if (used > thread->stack_high_water) {
+            thread->stack_high_water = used;
+        }
+        console_put_dec((uint32_t)((thread->stack_high_water + 1023) / 1024));
+        console_puts("/");
+        console_put_dec((uint32_t)(thread->stack_size / 1024));
+        console_puts("K  ");
+    } else {
+        console_puts("-  ");
+    }
+
     /* Name */
     console_puts(thread->name);
 
@@ -1851,8 +1887,8 @@ static void print_thread_info(thread_t *thread, bool is_current)
 void thread_list_debug(void)
 {
     console_puts("\n=== Thread List ===\n");
-    console_puts("TID  State     Priority   Nice  B  CPU    Ctx  Name\n");
-    console_puts("---  -----     --------   ----  -  ---    ---  ----\n");
+    console_puts("TID  State     Priority   Nice  B  CPU    Ctx  Stack  Name\n");
+    console_puts("---  -----     --------   ----  -  ---    ---  -----  ----\n");
 
     cpu_cli();
 
@@ -1863,7 +1899,7 @@ void thread_list_debug(void)
 
     /* Afficher les threads dans les run queues */
     for (int pri = THREAD_PRIORITY_COUNT - 1; pri >= 0; pri--) {
-        thread_t *thread = g_run_queues[pri];
+        thread_t *thread = g_run_queues[pri].head;
         while (thread) {
             if (thread != g_current_thread) {
                 print_thread_info(thread, false);
@@ -1876,7 +1912,7 @@ void thread_list_debug(void)
     thread_t *sleep = g_sleep_queue;
     while (sleep) {
         print_thread_info(sleep, false);
-        sleep = sleep->sched_next;
+        sleep = sleep->sleep_next;
     }
 
     cpu_sti();
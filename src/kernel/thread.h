@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timer_wheel.h"
 
 /* ========================================
  * Constantes
@@ -183,6 +184,7 @@ struct thread {
     /* Stack */
     void *stack_base;               /* Base de la stack allouée */
     uint64_t stack_size;            /* Taille de la stack */
+    uint64_t stack_high_water;      /* Profondeur max observée (octets) */
     
     /* Point d'entrée */
     thread_entry_t entry;           /* Fonction d'entrée */
@@ -202,6 +204,8 @@ struct thread {
     uint64_t cpu_ticks;                 /* Total CPU time consumed (in ticks) */
     uint64_t context_switches;          /* Number of times scheduled */
     uint64_t run_start_tick;            /* When thread started running (for accounting) */
+    uint64_t cpu_ns;                    /* Total CPU time consumed (ktime, ns) */
+    uint64_t run_start_ns;              /* ktime when thread started running */
 
     /* SMP preparation */
     uint32_t cpu_affinity;              /* CPU affinity mask (0xFFFFFFFF = any CPU) */
@@ -209,9 +213,15 @@ struct thread {
 
     /* Sleep */
     uint64_t wake_tick;             /* Tick auquel réveiller le thread */
+    timer_entry_t wake_timer;       /* Réveil du sleep ou timeout d'attente */
+    thread_t *sleep_next;           /* Liste des threads en sleep (debug) */
+    thread_t *sleep_prev;
     
     /* Wait queue */
     wait_queue_t *waiting_queue;    /* Queue sur laquelle on attend */
+    spinlock_t *waiting_lock;       /* Verrou de l'objet qui protège cette queue
+                                     * (mutex, sem, condvar, rwlock ; NULL :
+                                     * waiting_queue->lock) */
     thread_t *wait_queue_next;      /* Prochain dans la wait queue */
 
     /* Timeout support (scheduler integrated) */
@@ -232,6 +242,7 @@ struct thread {
     /* Liste chaînée pour le scheduler */
     thread_t *sched_next;           /* Prochain dans la run queue */
     thread_t *sched_prev;           /* Précédent dans la run queue */
+    int8_t sched_queue;             /* Run queue qui le contient, -1 si aucune */
     
     /* Liste de tous les threads d'un process */
     thread_t *proc_next;            /* Prochain thread du même process */
@@ -464,15 +475,18 @@ void scheduler_enqueue(thread_t *thread);
 void scheduler_dequeue(thread_t *thread);
 
 /**
- * Réveille les threads dont le sleep est terminé.
+ * Arme le timer de réveil du thread courant avant un blocage borné.
+ * À l'échéance, s'il est toujours SLEEPING ou BLOCKED, il est retiré de
+ * sa wait queue sous waiting_lock (ou le verrou de la queue) avec
+ * wait_result = -ETIMEDOUT, et remis dans une run queue.
+ * Désarmé par thread_wake_timer_cancel() au retour de scheduler_schedule().
  */
-void scheduler_wake_sleeping(void);
+void thread_wake_timer_arm(thread_t *thread, uint64_t wake_tick);
 
 /**
- * Vérifie les threads bloqués avec timeout expiré.
- * Appelé depuis scheduler_tick().
+ * Désarme le timer de réveil (réveil anticipé ou timeout déjà traité).
  */
-void check_thread_timeouts(void);
+void thread_wake_timer_cancel(thread_t *thread);
 
 /* ========================================
  * Reaper Thread
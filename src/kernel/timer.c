@@ -1,8 +1,12 @@
 /* src/kernel/timer.c - PIT Timer & RTC Driver Implementation */
 #include "timer.h"
 #include "thread.h"
+#include "timer_wheel.h"
 #include "../arch/x86_64/io.h"
+#include "../arch/x86_64/lapic.h"
+#include "../arch/x86_64/hpet.h"
 #include "console.h"
+#include "klog.h"
 
 /* ===========================================
  * Variables globales
@@ -17,6 +21,35 @@ static uint32_t g_timer_frequency = TIMER_FREQUENCY;
 /* Timestamp de référence au boot (lu depuis RTC) */
 static uint32_t g_boot_timestamp = 0;
 
+/* Source du tick : PIT (IRQ0) jusqu'à timer_lapic_init, puis LAPIC ;
+ * sans LAPIC, comparateur 0 du HPET (IRQ0 en routage legacy) */
+static bool g_lapic_tick = false;
+static bool g_hpet_tick = false;
+
+/* Comptes du timer LAPIC par tick (calibrés sur le HPET ou le PIT) */
+static uint32_t g_lapic_counts_per_tick = 0;
+
+/* Tick arrêté pendant l'idle : le LAPIC est en one-shot */
+static volatile bool g_tick_stopped = false;
+
+/* Comptes écoulés du tick en cours à l'arrêt, et durée du one-shot */
+static uint32_t g_idle_partial = 0;
+static uint32_t g_idle_oneshot = 0;
+
+/* Tick HPET : comptes par tick et valeur du compteur au prochain tick */
+static uint32_t g_hpet_counts_per_tick = 0;
+static uint64_t g_hpet_next = 0;
+
+/* Tick LAPIC avec HPET : après l'idle, les ticks sont recalculés sur le
+ * compteur du HPET depuis une origine commune (valeur du compteur et
+ * nombre de ticks au démarrage du tick LAPIC) */
+static bool g_hpet_rebase = false;
+static uint64_t g_hpet_origin = 0;
+static uint64_t g_hpet_origin_ticks = 0;
+
+/* Le one-shot en cours mène à une frontière de tick */
+static bool g_tick_aligning = false;
+
 /* ===========================================
  * Fonctions internes
  * =========================================== */
@@ -95,19 +128,104 @@ void timer_enable_scheduling(void)
     g_timer_scheduling_enabled = true;
 }
 
+/**
+ * Relance le tick LAPIC après un one-shot et rattrape les ticks écoulés
+ * (interruptions désactivées).
+ *
+ * Avec un HPET, les ticks et la phase viennent de son compteur (échéances
+ * absolues : ni la calibration du LAPIC ni la durée de l'idle ne font
+ * dériver le tick) ; sinon, des comptes LAPIC écoulés depuis l'arrêt.
+ * La fraction de tick entamée n'est pas perdue : un one-shot mène d'abord
+ * jusqu'à la prochaine frontière de tick ; son interruption (on_boundary)
+ * compte ce tick et relance alors le mode périodique.
+ */
+static void timer_tick_restart(bool on_boundary)
+{
+    uint32_t counts_per_tick = g_lapic_counts_per_tick;
+    uint32_t remaining;
+
+    if (g_hpet_rebase) {
+        uint64_t since = hpet_read_counter() - g_hpet_origin;
+        uint64_t ticks = g_hpet_origin_ticks + since / g_hpet_counts_per_tick;
+        uint64_t left = g_hpet_counts_per_tick - since % g_hpet_counts_per_tick;
+
+        /* Le LAPIC peut expirer un peu avant la frontière selon le HPET,
+         * ou avoir pris de l'avance en périodique : ne jamais reculer */
+        if (on_boundary) {
+            g_timer_ticks++;
+        }
+        if (ticks > g_timer_ticks) {
+            g_timer_ticks = ticks;
+        }
+        remaining = on_boundary ? counts_per_tick
+                                : (uint32_t)(left * counts_per_tick / g_hpet_counts_per_tick);
+    } else {
+        uint64_t elapsed = (uint64_t)g_idle_partial + (g_idle_oneshot - lapic_timer_current());
+        g_timer_ticks += elapsed / counts_per_tick;
+        remaining = counts_per_tick - (uint32_t)(elapsed % counts_per_tick);
+    }
+
+    if (remaining == 0 || remaining >= counts_per_tick) {
+        g_tick_aligning = false;
+        g_tick_stopped = false;
+        lapic_timer_periodic(counts_per_tick);
+        return;
+    }
+
+    /* Tick toujours arrêté : même calcul à la prochaine interruption */
+    g_idle_partial = counts_per_tick - remaining;
+    g_idle_oneshot = remaining;
+    g_tick_aligning = true;
+    lapic_timer_oneshot(remaining);
+}
+
+/**
+ * Tick HPET : compte les ticks écoulés d'après le compteur principal et
+ * réarme le comparateur sur le suivant (interruptions désactivées).
+ * Une échéance écrite trop tard ne déclencherait jamais : on relit le
+ * compteur après l'avoir armée.
+ */
+static void timer_hpet_catch_up(void)
+{
+    do {
+        uint64_t now = hpet_read_counter();
+        while (g_hpet_next <= now) {
+            g_timer_ticks++;
+            g_hpet_next += g_hpet_counts_per_tick;
+        }
+        hpet_oneshot_arm(g_hpet_next);
+    } while (hpet_read_counter() >= g_hpet_next);
+
+    g_tick_stopped = false;
+}
+
 uint64_t timer_handler_preempt(void *frame)
 {
-    g_timer_ticks++;
+    if (g_hpet_tick) {
+        timer_hpet_catch_up();
+    } else if (g_tick_stopped) {
+        /* Fin du one-shot de l'idle, ou de l'alignement sur un tick */
+        timer_tick_restart(g_tick_aligning);
+    } else {
+        g_timer_ticks++;
+    }
     
-    /* Envoyer EOI au PIC (Important: avant le scheduler!) */
-    outb(0x20, 0x20);
+    /* Envoyer EOI (Important: avant le scheduler!) */
+    if (g_lapic_tick) {
+        lapic_eoi();
+    } else {
+        outb(0x20, 0x20);
+    }
     
     /* Ne pas appeler le scheduler tant que le multitasking n'est pas prêt */
     if (!g_timer_scheduling_enabled) {
         return 0;
     }
     
-    /* Gestion du temps et réveil des threads endormis */
+    /* Timers expirés (réveil des threads endormis, timeouts) */
+    timer_wheel_run(g_timer_ticks);
+    
+    /* Gestion du temps (quantum, aging) */
     scheduler_tick();
     
     /* APPEL CRITIQUE : On demande au scheduler de préempter si besoin.
@@ -131,6 +249,8 @@ void timer_init(uint32_t frequency)
     
     g_timer_frequency = frequency;
     
+    timer_wheel_init();
+    
     /* Calcul du diviseur pour obtenir la fréquence désirée */
     uint32_t divisor = PIT_FREQUENCY / frequency;
     
@@ -167,6 +287,151 @@ void timer_init(uint32_t frequency)
     console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
 }
 
+int timer_lapic_init(void)
+{
+    if (lapic_init() != 0) {
+        return -1;
+    }
+    
+    /* Calibration : comptes LAPIC écoulés pendant quelques ticks, mesurés
+     * sur le compteur du HPET s'il existe, sinon sur les IRQ du PIT */
+    lapic_timer_start_masked(0xFFFFFFFF);
+    
+    uint32_t begin;
+    uint32_t end;
+    if (hpet_present()) {
+        uint64_t span = hpet_frequency() * TIMER_LAPIC_CALIBRATE_TICKS / g_timer_frequency;
+        uint64_t start = hpet_read_counter();
+        begin = lapic_timer_current();
+        while (hpet_read_counter() - start < span) {
+            asm volatile("pause");
+        }
+        end = lapic_timer_current();
+    } else {
+        uint64_t start = g_timer_ticks;
+        while (g_timer_ticks == start) {
+            asm volatile("hlt");
+        }
+        begin = lapic_timer_current();
+        start = g_timer_ticks;
+        while (g_timer_ticks < start + TIMER_LAPIC_CALIBRATE_TICKS) {
+            asm volatile("hlt");
+        }
+        end = lapic_timer_current();
+    }
+    lapic_timer_stop();
+    
+    uint32_t counts = (begin - end) / TIMER_LAPIC_CALIBRATE_TICKS;
+    if (counts == 0) {
+        KLOG_ERROR("TIMER", "LAPIC timer calibration failed");
+        return -1;
+    }
+    
+    /* Basculer le tick du PIT vers le LAPIC */
+    asm volatile("cli");
+    outb(0x21, inb(0x21) | 0x01);   /* Masquer l'IRQ0 */
+    g_lapic_counts_per_tick = counts;
+    g_lapic_tick = true;
+    lapic_timer_periodic(counts);
+    if (hpet_present()) {
+        g_hpet_counts_per_tick = (uint32_t)(hpet_frequency() / g_timer_frequency);
+        g_hpet_origin = hpet_read_counter();
+        g_hpet_origin_ticks = g_timer_ticks;
+        g_hpet_rebase = true;
+    }
+    asm volatile("sti");
+    
+    KLOG_INFO_DEC("TIMER", "LAPIC tick source, counts per tick: ", counts);
+    return 0;
+}
+
+int timer_hpet_init(void)
+{
+    if (!hpet_present()) {
+        return -1;
+    }
+    
+    uint32_t counts = (uint32_t)(hpet_frequency() / g_timer_frequency);
+    
+    /* Basculer le tick du PIT vers le comparateur 0 (même IRQ0) */
+    asm volatile("cli");
+    if (hpet_oneshot_init() != 0) {
+        asm volatile("sti");
+        return -1;
+    }
+    g_hpet_counts_per_tick = counts;
+    g_hpet_next = hpet_read_counter() + counts;
+    g_hpet_tick = true;
+    timer_hpet_catch_up();
+    asm volatile("sti");
+    
+    KLOG_INFO_DEC("TIMER", "HPET tick source, counts per tick: ", counts);
+    return 0;
+}
+
+void timer_idle_enter(void)
+{
+    if ((!g_lapic_tick && !g_hpet_tick) || g_tick_stopped || !g_timer_scheduling_enabled) {
+        return;
+    }
+    
+    /* Le prochain tick périodique porterait le compteur à now + 1 */
+    uint64_t now = g_timer_ticks;
+    uint64_t next = timer_wheel_next_expiry();
+    if (next <= now + 1) {
+        return;
+    }
+    
+    uint32_t counts_per_tick = g_lapic_tick ? g_lapic_counts_per_tick : g_hpet_counts_per_tick;
+    uint64_t max_ticks = 0xFFFFFFFFULL / counts_per_tick;
+    uint64_t delta = next - now;
+    if (delta > max_ticks) {
+        delta = max_ticks;
+    }
+    
+    if (g_hpet_tick) {
+        /* g_hpet_next est le tick now + 1 : comparateur sur le tick now + delta */
+        uint64_t deadline = g_hpet_next + (delta - 1) * g_hpet_counts_per_tick;
+        g_tick_stopped = true;
+        hpet_oneshot_arm(deadline);
+        if (hpet_read_counter() >= deadline) {
+            timer_hpet_catch_up();
+        }
+        return;
+    }
+    
+    /* Compteur lu avant l'IRR : un tick échu entre les deux est vu en
+     * attente. Il sera délivré au sti et compté normalement ; l'armer en
+     * one-shot le ferait passer pour la fin de l'idle, à elapsed ~ 0. */
+    uint32_t current = lapic_timer_current();
+    if (lapic_timer_pending()) {
+        return;
+    }
+    
+    /* One-shot aligné sur la frontière de tick où le timer expire */
+    g_idle_partial = g_lapic_counts_per_tick - current;
+    g_idle_oneshot = (uint32_t)(delta * g_lapic_counts_per_tick - g_idle_partial);
+    g_tick_stopped = true;
+    lapic_timer_oneshot(g_idle_oneshot);
+}
+
+void timer_idle_exit(void)
+{
+    if (!g_tick_stopped) {
+        return;
+    }
+    
+    if (g_hpet_tick) {
+        timer_hpet_catch_up();
+        return;
+    }
+    
+    /* One-shot expiré mais pas encore délivré : le handler relancera le tick */
+    if (!lapic_timer_pending()) {
+        timer_tick_restart(false);
+    }
+}
+
 uint64_t timer_get_ticks(void)
 {
     return g_timer_ticks;
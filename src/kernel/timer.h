@@ -19,6 +19,9 @@
 /* Fréquence cible pour les ticks (1000 Hz = 1 tick par ms) */
 #define TIMER_FREQUENCY 1000
 
+/* Durée de calibration du timer LAPIC (en ticks) */
+#define TIMER_LAPIC_CALIBRATE_TICKS 50
+
 /* ===========================================
  * RTC (Real-Time Clock) Ports
  * =========================================== */
@@ -72,6 +75,39 @@ typedef struct {
  */
 void timer_init(uint32_t frequency);
 
+/**
+ * Fait du timer LAPIC la source du tick (calibré sur le HPET s'il est actif,
+ * sinon sur le PIT ; l'IRQ0 est ensuite masquée). Avec un HPET, le tick
+ * est recalé sur son compteur à chaque sortie d'idle. Nécessite les
+ * interruptions et mmio_init().
+ * @return 0 si succès, -1 si pas de LAPIC (le PIT reste la source)
+ */
+int timer_lapic_init(void);
+
+/**
+ * Sans LAPIC : fait du comparateur 0 du HPET la source du tick, réarmé en
+ * one-shot à chaque tick sur le compteur principal (routage legacy vers
+ * l'IRQ0, le PIT est déconnecté). Nécessite hpet_init().
+ * @return 0 si succès, -1 si pas de HPET capable (le PIT reste la source)
+ */
+int timer_hpet_init(void);
+
+/**
+ * Tickless idle : appelé par le thread idle, interruptions désactivées et
+ * run queues vides, juste avant hlt. Arrête le tick périodique et programme
+ * un one-shot (LAPIC ou HPET) sur la prochaine échéance de la roue de timers.
+ * Sans effet tant que le tick vient du PIT.
+ */
+void timer_idle_enter(void);
+
+/**
+ * Sortie de l'idle (interruptions désactivées) : rattrape les ticks écoulés
+ * et relance le tick périodique, après un one-shot jusqu'à la prochaine
+ * frontière de tick (la fraction entamée est conservée). Sans effet si le
+ * tick tourne.
+ */
+void timer_idle_exit(void);
+
 /**
  * Retourne le nombre de ticks depuis le démarrage.
  * @return Nombre de ticks
@@ -0,0 +1,238 @@
+/* src/kernel/timer_wheel.c - Roue de timers hiérarchique */
+#include "timer_wheel.h"
+#include "thread.h"
+
+/* Têtes (sentinelles) des listes circulaires de chaque case */
+static timer_entry_t g_wheel[TWHEEL_LEVELS][TWHEEL_SIZE];
+
+/* Prochain tick à traiter */
+static uint64_t g_wheel_tick = 0;
+
+/* Timers armés (roue vide : rien à parcourir) */
+static uint32_t g_wheel_pending = 0;
+
+static spinlock_t g_wheel_lock;
+
+/* ========================================
+ * Fonctions internes (g_wheel_lock tenu)
+ * ======================================== */
+
+static inline void entry_unlink(timer_entry_t *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = timer;
+    timer->prev = timer;
+}
+
+static inline void entry_link_tail(timer_entry_t *head, timer_entry_t *timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+/**
+ * Range un timer dans la case de son échéance, au niveau le plus fin
+ * qui la couvre depuis g_wheel_tick.
+ */
+static void wheel_insert(timer_entry_t *timer)
+{
+    uint64_t expires = timer->expires;
+    if (expires < g_wheel_tick) {
+        expires = g_wheel_tick;
+    }
+
+    uint64_t delta = expires - g_wheel_tick;
+    if (delta > TWHEEL_MAX_DELTA) {
+        /* Horizon : la cascade le replacera plus tard */
+        delta = TWHEEL_MAX_DELTA;
+        expires = g_wheel_tick + delta;
+    }
+
+    int level = 0;
+    while (level < TWHEEL_LEVELS - 1 &&
+           delta >= (1ULL << (TWHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    uint32_t slot = (uint32_t)(expires >> (TWHEEL_BITS * level)) & TWHEEL_MASK;
+    entry_link_tail(&g_wheel[level][slot], timer);
+}
+
+/**
+ * Redistribue une case d'un niveau supérieur vers les niveaux plus fins.
+ *
+ * @return Index de la case (0 : le niveau suivant doit aussi cascader)
+ */
+static uint32_t wheel_cascade(int level)
+{
+    uint32_t slot = (uint32_t)(g_wheel_tick >> (TWHEEL_BITS * level)) & TWHEEL_MASK;
+    timer_entry_t *head = &g_wheel[level][slot];
+
+    while (head->next != head) {
+        timer_entry_t *timer = head->next;
+        entry_unlink(timer);
+        wheel_insert(timer);
+    }
+
+    return slot;
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+void timer_wheel_init(void)
+{
+    for (int level = 0; level < TWHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TWHEEL_SIZE; slot++) {
+            g_wheel[level][slot].next = &g_wheel[level][slot];
+            g_wheel[level][slot].prev = &g_wheel[level][slot];
+        }
+    }
+    g_wheel_tick = 0;
+    g_wheel_pending = 0;
+    spinlock_init(&g_wheel_lock);
+}
+
+void timer_entry_init(timer_entry_t *timer, timer_callback_t callback, void *arg)
+{
+    timer->next = timer;
+    timer->prev = timer;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->pending = false;
+}
+
+void timer_wheel_arm(timer_entry_t *timer, uint64_t expires)
+{
+    uint64_t irq_flags = spinlock_irqsave(&g_wheel_lock);
+
+    if (timer->pending) {
+        entry_unlink(timer);
+    } else {
+        timer->pending = true;
+        g_wheel_pending++;
+    }
+
+    timer->expires = expires;
+    wheel_insert(timer);
+
+    spinlock_irqrestore(&g_wheel_lock, irq_flags);
+}
+
+bool timer_wheel_cancel(timer_entry_t *timer)
+{
+    uint64_t irq_flags = spinlock_irqsave(&g_wheel_lock);
+
+    bool was_pending = timer->pending;
+    if (was_pending) {
+        entry_unlink(timer);
+        timer->pending = false;
+        g_wheel_pending--;
+    }
+
+    spinlock_irqrestore(&g_wheel_lock, irq_flags);
+    return was_pending;
+}
+
+uint64_t timer_wheel_next_expiry(void)
+{
+    uint64_t irq_flags = spinlock_irqsave(&g_wheel_lock);
+
+    uint64_t next = UINT64_MAX;
+    if (g_wheel_pending > 0) {
+        /* Niveau 0 : une case non vide expire exactement à son tick */
+        for (uint32_t i = 0; i < TWHEEL_SIZE; i++) {
+            uint64_t tick = g_wheel_tick + i;
+            timer_entry_t *head = &g_wheel[0][tick & TWHEEL_MASK];
+            if (head->next != head) {
+                next = tick;
+                break;
+            }
+        }
+
+        /* Niveaux supérieurs : rien n'expire avant la cascade de la case */
+        for (int level = 1; level < TWHEEL_LEVELS; level++) {
+            uint32_t shift = TWHEEL_BITS * level;
+            uint64_t base = g_wheel_tick >> shift;
+            /* Case courante : cascade en attente seulement si on est aligné */
+            uint32_t first = ((g_wheel_tick & ((1ULL << shift) - 1)) == 0) ? 0 : 1;
+
+            for (uint32_t i = first; i <= TWHEEL_SIZE; i++) {
+                uint64_t cascade = (base + i) << shift;
+                if (cascade >= next) {
+                    break;
+                }
+                timer_entry_t *head = &g_wheel[level][(base + i) & TWHEEL_MASK];
+                if (head->next != head) {
+                    next = cascade;
+                    break;
+                }
+            }
+        }
+    }
+
+    spinlock_irqrestore(&g_wheel_lock, irq_flags);
+    return next;
+}
+
+void timer_wheel_run(uint64_t now)
+{
+    uint64_t irq_flags = spinlock_irqsave(&g_wheel_lock);
+
+    while (g_wheel_tick <= now) {
+        if (g_wheel_pending == 0) {
+            /* Rien d'armé : inutile de parcourir les ticks un à un */
+            g_wheel_tick = now + 1;
+            break;
+        }
+
+        uint32_t index = (uint32_t)g_wheel_tick & TWHEEL_MASK;
+        if (index == 0) {
+            for (int level = 1; level < TWHEEL_LEVELS; level++) {
+                if (wheel_cascade(level) != 0) {
+                    break;
+                }
+            }
+        }
+
+        /* Détacher la case : un timer réarmé dans son callback (même pour
+         * une échéance passée) part au tick suivant, pas dans ce parcours */
+        timer_entry_t expired;
+        timer_entry_t *head = &g_wheel[0][index];
+        if (head->next != head) {
+            expired.next = head->next;
+            expired.prev = head->prev;
+            expired.next->prev = &expired;
+            expired.prev->next = &expired;
+            head->next = head;
+            head->prev = head;
+        } else {
+            expired.next = &expired;
+            expired.prev = &expired;
+        }
+        g_wheel_tick++;
+
+        while (expired.next != &expired) {
+            timer_entry_t *timer = expired.next;
+            entry_unlink(timer);
+            timer->pending = false;
+            g_wheel_pending--;
+
+            timer_callback_t callback = timer->callback;
+            void *arg = timer->arg;
+
+            spinlock_irqrestore(&g_wheel_lock, irq_flags);
+            if (callback != NULL) {
+                callback(timer, arg);
+            }
+            irq_flags = spinlock_irqsave(&g_wheel_lock);
+        }
+    }
+
+    spinlock_irqrestore(&g_wheel_lock, irq_flags);
+}
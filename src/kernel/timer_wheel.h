@@ -0,0 +1,84 @@
+/* src/kernel/timer_wheel.h - Roue de timers hiérarchique */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Facilité de timers unique du kernel : sommeils des threads, timeouts des
+ * attentes bornées (wait queues, sémaphores, condvars) et timers à callback.
+ *
+ * TWHEEL_LEVELS niveaux de TWHEEL_SIZE cases : le niveau 0 a la
+ * granularité d'un tick, chaque niveau suivant couvre TWHEEL_SIZE fois
+ * plus de temps. Un timer est rangé dans la case de son échéance au niveau
+ * qui la couvre : armer et annuler sont en O(1). Quand le niveau 0 fait un
+ * tour, la case courante du niveau supérieur est redistribuée (cascade).
+ * À chaque tick, seule la case courante du niveau 0 est parcourue : elle
+ * ne contient que des timers qui expirent.
+ *
+ * Les échéances au-delà de TWHEEL_MAX_DELTA ticks (~4,6 h à 1000 Hz) sont
+ * rangées à l'horizon et recascadées jusqu'à leur échéance réelle.
+ */
+
+#define TWHEEL_BITS         6
+#define TWHEEL_SIZE         (1 << TWHEEL_BITS)
+#define TWHEEL_MASK         (TWHEEL_SIZE - 1)
+#define TWHEEL_LEVELS       4
+#define TWHEEL_MAX_DELTA    ((1ULL << (TWHEEL_BITS * TWHEEL_LEVELS)) - 1)
+
+typedef struct timer_entry timer_entry_t;
+
+/**
+ * Callback d'expiration, appelé en contexte IRQ (timer) sans lock tenu :
+ * il doit rester court et ne pas bloquer. Le timer peut y être réarmé.
+ */
+typedef void (*timer_callback_t)(timer_entry_t *timer, void *arg);
+
+struct timer_entry {
+    timer_entry_t *next;        /* Liste circulaire de la case */
+    timer_entry_t *prev;
+    uint64_t expires;           /* Tick absolu d'expiration */
+    timer_callback_t callback;
+    void *arg;
+    bool pending;               /* Armé et pas encore expiré */
+};
+
+/**
+ * Initialise la roue (appelé par timer_init).
+ */
+void timer_wheel_init(void);
+
+/**
+ * Prépare un timer (non armé).
+ */
+void timer_entry_init(timer_entry_t *timer, timer_callback_t callback, void *arg);
+
+/**
+ * Arme un timer pour le tick absolu expires, O(1). Un timer déjà armé est
+ * déplacé ; une échéance passée expire au prochain tick.
+ */
+void timer_wheel_arm(timer_entry_t *timer, uint64_t expires);
+
+/**
+ * Désarme un timer, O(1).
+ *
+ * @return true si le timer était armé, false s'il avait déjà expiré
+ */
+bool timer_wheel_cancel(timer_entry_t *timer);
+
+/**
+ * Minorant du prochain tick où un timer expire (ou une case cascade),
+ * UINT64_MAX si aucun timer n'est armé. Sert au tick tickless : réveiller
+ * trop tôt ne coûte qu'un nouveau calcul.
+ */
+uint64_t timer_wheel_next_expiry(void);
+
+/**
+ * Fait expirer les timers jusqu'au tick now inclus.
+ * Appelé depuis l'IRQ timer.
+ */
+void timer_wheel_run(uint64_t now);
+
+#endif /* TIMER_WHEEL_H */
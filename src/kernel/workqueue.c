@@ -6,6 +6,7 @@
 #include "console.h"
 #include "klog.h"
 #include "../mm/kheap.h"
+#include "../mm/kmem_cache.h"
 #include "../include/string.h"
 
 /* ============================================ */
@@ -14,6 +15,12 @@
 
 static worker_pool_t *g_kernel_pool = NULL;
 
+/* Cache des work items, partagé par tous les pools */
+static kmem_cache_t *g_work_item_cache = NULL;
+
+/* Protects the queued/rerun flags of every delayed work */
+static spinlock_t g_dwork_lock;
+
 /* ============================================ */
 /*           Internal Functions                 */
 /* ============================================ */
@@ -56,7 +63,7 @@ static void worker_thread_func(void *arg)
             if (item->func) {
                 item->func(item->arg);
             }
-            kfree(item);
+            kmem_cache_free(g_work_item_cache, item);
         }
     }
     
@@ -71,6 +78,77 @@ static void worker_thread_func(void *arg)
     }
 }
 
+/**
+ * Runs a delayed work in a worker; clears queued afterwards so that a
+ * periodic work never overlaps with itself. A one-shot expiry that came
+ * in meanwhile (e.g. the function re-armed itself) runs it again.
+ */
+static void delayed_work_run(void *arg)
+{
+    delayed_work_t *dwork = (delayed_work_t *)arg;
+    
+    for (;;) {
+        if (dwork->func) {
+            dwork->func(dwork->arg);
+        }
+        
+        uint64_t flags = spinlock_irqsave(&g_dwork_lock);
+        bool again = dwork->rerun;
+        dwork->rerun = false;
+        if (!again) {
+            dwork->queued = false;
+        }
+        spinlock_irqrestore(&g_dwork_lock, flags);
+        
+        if (!again) {
+            break;
+        }
+    }
+}
+
+/**
+ * ktimer callback (ktimerd context) - hands the work over to the pool
+ */
+static void delayed_work_timer_fn(void *arg)
+{
+    delayed_work_t *dwork = (delayed_work_t *)arg;
+    
+    uint64_t flags = spinlock_irqsave(&g_dwork_lock);
+    if (dwork->queued) {
+        /* Previous run still pending: a periodic work skips this period,
+         * a one-shot work runs once more when it completes */
+        if (dwork->timer.period_ms == 0) {
+            dwork->rerun = true;
+        }
+        spinlock_irqrestore(&g_dwork_lock, flags);
+        return;
+    }
+    dwork->queued = true;
+    spinlock_irqrestore(&g_dwork_lock, flags);
+    
+    if (kwork_submit(delayed_work_run, dwork) != 0) {
+        dwork->queued = false;
+    }
+}
+
+static int delayed_work_start(delayed_work_t *dwork, work_func_t func, void *arg,
+                              uint32_t delay_ms, uint32_t period_ms)
+{
+    if (!dwork || !func || !g_kernel_pool) {
+        return -1;
+    }
+    
+    /* Only the first submission sets the timer up; later ones reschedule */
+    if (!ktimer_pending(&dwork->timer) && !dwork->queued) {
+        ktimer_setup(&dwork->timer, delayed_work_timer_fn, dwork);
+    }
+    dwork->func = func;
+    dwork->arg = arg;
+    
+    ktimer_start(&dwork->timer, delay_ms, period_ms);
+    return 0;
+}
+
 /* ============================================ */
 /*           Worker Pool API                    */
 /* ============================================ */
@@ -84,6 +162,15 @@ worker_pool_t *worker_pool_create(uint32_t num_workers)
     KLOG_INFO("WORKQ", "Creating worker pool with workers:");
     KLOG_INFO_DEC("WORKQ", "Count: ", num_workers);
     
+    /* Le premier pool crée le cache des work items */
+    if (!g_work_item_cache) {
+        g_work_item_cache = kmem_cache_create("work_item", sizeof(work_item_t), 0, NULL);
+        if (!g_work_item_cache) {
+            KLOG_ERROR("WORKQ", "Failed to create work item cache");
+            return NULL;
+        }
+    }
+    
     /* Allocate pool structure */
     worker_pool_t *pool = (worker_pool_t *)kmalloc(sizeof(worker_pool_t));
     if (!pool) {
@@ -164,7 +251,7 @@ int worker_pool_submit(worker_pool_t *pool, work_func_t func, void *arg)
     }
     
     /* Allocate work item */
-    work_item_t *item = (work_item_t *)kmalloc(sizeof(work_item_t));
+    work_item_t *item = (work_item_t *)kmem_cache_alloc(g_work_item_cache);
     if (!item) {
         KLOG_ERROR("WORKQ", "Failed to allocate work item");
         return -1;
@@ -267,7 +354,7 @@ void worker_pool_destroy(worker_pool_t *pool)
     work_item_t *item = pool->queue.head;
     while (item) {
         work_item_t *next = item->next;
-        kfree(item);
+        kmem_cache_free(g_work_item_cache, item);
         item = next;
     }
     
@@ -309,6 +396,8 @@ void workqueue_init(void)
 {
     KLOG_INFO("WORKQ", "Initializing global kernel worker pool");
     
+    spinlock_init(&g_dwork_lock);
+    
     g_kernel_pool = worker_pool_create(KERNEL_WORKER_COUNT);
     
     if (!g_kernel_pool) {
@@ -329,6 +418,44 @@ int kwork_submit(work_func_t func, void *arg)
     return worker_pool_submit(g_kernel_pool, func, arg);
 }
 
+int kwork_submit_delayed(delayed_work_t *dwork, work_func_t func, void *arg,
+                         uint32_t delay_ms)
+{
+    return delayed_work_start(dwork, func, arg, delay_ms, 0);
+}
+
+int kwork_submit_periodic(delayed_work_t *dwork, work_func_t func, void *arg,
+                          uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return -1;
+    }
+    
+    return delayed_work_start(dwork, func, arg, period_ms, period_ms);
+}
+
+bool kwork_cancel_delayed(delayed_work_t *dwork)
+{
+    if (!dwork) {
+        return false;
+    }
+    
+    uint64_t flags = spinlock_irqsave(&g_dwork_lock);
+    dwork->rerun = false;
+    spinlock_irqrestore(&g_dwork_lock, flags);
+    
+    return ktimer_cancel(&dwork->timer);
+}
+
+bool kwork_delayed_pending(delayed_work_t *dwork)
+{
+    if (!dwork) {
+        return false;
+    }
+    
+    return dwork->queued || ktimer_pending(&dwork->timer);
+}
+
 void workqueue_shutdown(void)
 {
     if (g_kernel_pool) {
@@ -8,6 +8,7 @@
  * - Configurable number of workers (default: 4)
  * - Graceful shutdown with timeout
  * - Global kernel work pool for easy async work submission
+ * - Delayed and periodic work on top of ktimer (no dedicated thread)
  */
 #ifndef WORKQUEUE_H
 #define WORKQUEUE_H
@@ -16,6 +17,7 @@
 #include <stdbool.h>
 #include "thread.h"
 #include "sync.h"
+#include "ktimer.h"
 
 /* ============================================ */
 /*           Work Item Structure                */
@@ -65,6 +67,24 @@ typedef struct worker_pool {
     bool running;               /* Pool is accepting work */
 } worker_pool_t;
 
+/* ============================================ */
+/*           Delayed Work Structure             */
+/* ============================================ */
+
+/**
+ * Delayed work - a ktimer that submits func to the kernel pool when it
+ * expires. Owned by the caller: zero-initialised before first use (static
+ * or memset), and kept valid until cancelled and any submitted run has
+ * completed.
+ */
+typedef struct delayed_work {
+    ktimer_t timer;             /* Expiry timer */
+    work_func_t func;           /* Function to execute */
+    void *arg;                  /* Argument to pass to function */
+    volatile bool queued;       /* Submitted to the pool, not yet run */
+    volatile bool rerun;        /* One-shot expiry while queued: run again */
+} delayed_work_t;
+
 /* Default number of kernel workers */
 #define KERNEL_WORKER_COUNT     4
 
@@ -146,6 +166,53 @@ void workqueue_init(void);
  */
 int kwork_submit(work_func_t func, void *arg);
 
+/**
+ * Submit work to the global kernel pool after a delay.
+ * Re-submitting a pending delayed work reschedules it. An expiry while
+ * the previous run is still queued or running (e.g. re-armed from its own
+ * function) is not lost: the function runs again once it returns.
+ *
+ * @param dwork Caller-owned delayed work
+ * @param func Function to execute
+ * @param arg Argument to pass to function
+ * @param delay_ms Delay before submission
+ * @return 0 on success, -1 on failure
+ */
+int kwork_submit_delayed(delayed_work_t *dwork, work_func_t func, void *arg,
+                         uint32_t delay_ms);
+
+/**
+ * Submit work to the global kernel pool every period_ms, first run after
+ * one period. A period is skipped while the previous run is still queued
+ * or running, so a slow function never piles up in the pool.
+ *
+ * @param dwork Caller-owned delayed work
+ * @param func Function to execute
+ * @param arg Argument to pass to function
+ * @param period_ms Period between submissions (must be > 0)
+ * @return 0 on success, -1 on failure
+ */
+int kwork_submit_periodic(delayed_work_t *dwork, work_func_t func, void *arg,
+                          uint32_t period_ms);
+
+/**
+ * Cancel a delayed or periodic work. A run already submitted to the pool
+ * still executes.
+ *
+ * @param dwork Delayed work to cancel
+ * @return true if the work was pending
+ */
+bool kwork_cancel_delayed(delayed_work_t *dwork);
+
+/**
+ * Is a delayed work armed, queued in the pool or running?
+ * Safe from any context, including IRQ.
+ *
+ * @param dwork Delayed work (zero-initialised or previously submitted)
+ * @return true if a run is still to come or in progress
+ */
+bool kwork_delayed_pending(delayed_work_t *dwork);
+
 /**
  * Shutdown the global kernel worker pool.
  * Called during kernel shutdown.
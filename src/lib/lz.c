@@ -0,0 +1,182 @@
+/* src/lib/lz.c - Compression LZ77 rapide (format proche de LZ4) */
+#include "../include/lz.h"
+
+#define LZ_MAX_OFFSET       65535
+#define LZ_RUN_MASK         15
+
+static inline uint32_t read32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Hachage multiplicatif (Knuth) de 4 octets */
+static inline uint32_t lz_hash(uint32_t value)
+{
+    return (value * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/* Écrit une longueur étendue (après un champ de token à 15) */
+static inline size_t put_length(uint8_t* out, size_t op, size_t len)
+{
+    while (len >= 255) {
+        out[op++] = 255;
+        len -= 255;
+    }
+    out[op++] = (uint8_t)len;
+    return op;
+}
+
+/**
+ * Émet une séquence : lit_len littéraux puis, si match_len != 0, un match.
+ * @return Nouvelle position dans out, ou 0 si dst_cap serait dépassé
+ */
+static size_t emit_sequence(uint8_t* out, size_t op, size_t cap,
+                            const uint8_t* lit, size_t lit_len,
+                            size_t offset, size_t match_len)
+{
+    size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+    size_t need = 1 + lit_len / 255 + 1 + lit_len;
+    if (match_len) {
+        need += 2 + ml / 255 + 1;
+    }
+    if (op + need > cap) {
+        return 0;
+    }
+
+    size_t token = op++;
+    out[token] = (uint8_t)((lit_len >= LZ_RUN_MASK ? LZ_RUN_MASK : lit_len) << 4);
+    if (lit_len >= LZ_RUN_MASK) {
+        op = put_length(out, op, lit_len - LZ_RUN_MASK);
+    }
+    for (size_t i = 0; i < lit_len; i++) {
+        out[op++] = lit[i];
+    }
+
+    if (match_len) {
+        out[op++] = (uint8_t)(offset & 0xFF);
+        out[op++] = (uint8_t)(offset >> 8);
+        out[token] |= (uint8_t)(ml >= LZ_RUN_MASK ? LZ_RUN_MASK : ml);
+        if (ml >= LZ_RUN_MASK) {
+            op = put_length(out, op, ml - LZ_RUN_MASK);
+        }
+    }
+
+    return op;
+}
+
+size_t lz_compress(const void* src, size_t src_len, void* dst, size_t dst_cap,
+                   uint16_t* table)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t* out = (uint8_t*)dst;
+
+    if (src_len > LZ_MAX_INPUT || table == NULL) {
+        return 0;
+    }
+
+    /* Une entrée périmée est sans danger : le match est revérifié */
+    for (size_t i = 0; i < LZ_HASH_SIZE; i++) {
+        table[i] = 0;
+    }
+
+    size_t ip = 0;
+    size_t anchor = 0;
+    size_t op = 0;
+
+    while (ip + LZ_MIN_MATCH <= src_len) {
+        uint32_t seq = read32(in + ip);
+        uint32_t h = lz_hash(seq);
+        size_t ref = table[h];
+        table[h] = (uint16_t)ip;
+
+        if (ref < ip && ip - ref <= LZ_MAX_OFFSET && read32(in + ref) == seq) {
+            size_t len = LZ_MIN_MATCH;
+            while (ip + len < src_len && in[ref + len] == in[ip + len]) {
+                len++;
+            }
+
+            op = emit_sequence(out, op, dst_cap, in + anchor, ip - anchor, ip - ref, len);
+            if (op == 0) {
+                return 0;
+            }
+            ip += len;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+
+    /* Derniers littéraux (éventuellement aucun) */
+    return emit_sequence(out, op, dst_cap, in + anchor, src_len - anchor, 0, 0);
+}
+
+int lz_decompress(const void* src, size_t src_len, void* dst, size_t dst_cap)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t* out = (uint8_t*)dst;
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < src_len) {
+        uint8_t token = in[ip++];
+
+        /* Littéraux */
+        size_t lit_len = token >> 4;
+        if (lit_len == LZ_RUN_MASK) {
+            uint8_t b;
+            do {
+                if (ip >= src_len) {
+                    return -1;
+                }
+                b = in[ip++];
+                lit_len += b;
+            } while (b == 255);
+        }
+        if (lit_len > src_len - ip || lit_len > dst_cap - op) {
+            return -1;
+        }
+        for (size_t i = 0; i < lit_len; i++) {
+            out[op++] = in[ip++];
+        }
+
+        /* Dernière séquence : pas de match */
+        if (ip == src_len) {
+            break;
+        }
+
+        /* Match */
+        if (src_len - ip < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return -1;
+        }
+
+        size_t match_len = token & LZ_RUN_MASK;
+        if (match_len == LZ_RUN_MASK) {
+            uint8_t b;
+            do {
+                if (ip >= src_len) {
+                    return -1;
+                }
+                b = in[ip++];
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+        if (match_len > dst_cap - op) {
+            return -1;
+        }
+
+        /* Copie octet par octet : le match peut chevaucher la sortie */
+        const uint8_t* ref = out + op - offset;
+        for (size_t i = 0; i < match_len; i++) {
+            out[op++] = ref[i];
+        }
+    }
+
+    return (int)op;
+}
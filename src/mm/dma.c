@@ -0,0 +1,203 @@
+/* src/mm/dma.c - Mémoire DMA cohérente pour les drivers */
+#include "dma.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "kheap.h"
+#include "../kernel/klog.h"
+#include "../kernel/thread.h"
+#include "../include/string.h"
+
+/* Taille minimale d'un chunk de pool (plusieurs buffers de paquets) */
+#define DMA_POOL_CHUNK_MIN_PAGES    4
+
+/* Un chunk commence par cet en-tête ; les objets suivent */
+typedef struct dma_pool_chunk {
+    struct dma_pool_chunk* next;
+    size_t size;                    /* Taille totale du chunk (octets) */
+} dma_pool_chunk_t;
+
+/* Objet libre : le lien est stocké dans l'objet lui-même */
+typedef struct dma_pool_free_obj {
+    struct dma_pool_free_obj* next;
+} dma_pool_free_obj_t;
+
+struct dma_pool {
+    char name[16];
+    size_t obj_size;                /* Taille d'un objet (alignement inclus) */
+    size_t first_offset;            /* Offset du premier objet dans un chunk */
+    size_t chunk_size;              /* Taille d'un chunk (multiple de page) */
+    dma_pool_chunk_t* chunks;       /* Chunks alloués */
+    dma_pool_free_obj_t* free_list; /* Objets libres */
+    uint32_t total_objs;
+    uint32_t used_objs;
+    spinlock_t lock;
+};
+
+/* ========================================
+ * Allocations cohérentes
+ * ======================================== */
+
+void* dma_alloc_coherent(size_t size, dma_addr_t* dma_handle)
+{
+    if (size == 0) {
+        return NULL;
+    }
+
+    uint64_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    void* vaddr = pmm_alloc_blocks(pages);
+    if (vaddr == NULL) {
+        KLOG_ERROR("DMA", "Out of contiguous physical memory");
+        return NULL;
+    }
+
+    memset(vaddr, 0, pages * PAGE_SIZE);
+
+    if (dma_handle != NULL) {
+        *dma_handle = pmm_virt_to_phys(vaddr);
+    }
+    return vaddr;
+}
+
+void dma_free_coherent(void* vaddr, size_t size)
+{
+    if (vaddr == NULL || size == 0) {
+        return;
+    }
+
+    pmm_free_blocks(vaddr, (size + PAGE_SIZE - 1) / PAGE_SIZE);
+}
+
+dma_addr_t dma_virt_to_bus(const void* vaddr)
+{
+    return vmm_get_physical((uint64_t)vaddr);
+}
+
+/* ========================================
+ * Pools d'objets
+ * ======================================== */
+
+/**
+ * Ajoute un chunk au pool et découpe ses objets (pool->lock tenu).
+ */
+static int dma_pool_grow(dma_pool_t* pool)
+{
+    dma_addr_t dma;
+    dma_pool_chunk_t* chunk = (dma_pool_chunk_t*)dma_alloc_coherent(pool->chunk_size, &dma);
+    if (chunk == NULL) {
+        return -1;
+    }
+
+    chunk->size = pool->chunk_size;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    uint8_t* base = (uint8_t*)chunk;
+    for (size_t off = pool->first_offset; off + pool->obj_size <= pool->chunk_size;
+         off += pool->obj_size) {
+        dma_pool_free_obj_t* obj = (dma_pool_free_obj_t*)(base + off);
+        obj->next = pool->free_list;
+        pool->free_list = obj;
+        pool->total_objs++;
+    }
+
+    return 0;
+}
+
+dma_pool_t* dma_pool_create(const char* name, size_t size, size_t align)
+{
+    if (align == 0) {
+        align = sizeof(void*);
+    }
+    if (size == 0 || (align & (align - 1)) != 0 || align > PAGE_SIZE) {
+        return NULL;
+    }
+
+    dma_pool_t* pool = (dma_pool_t*)kmalloc(sizeof(dma_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(dma_pool_t));
+
+    if (name != NULL) {
+        strncpy(pool->name, name, sizeof(pool->name) - 1);
+    }
+
+    if (size < sizeof(dma_pool_free_obj_t)) {
+        size = sizeof(dma_pool_free_obj_t);
+    }
+    pool->obj_size = (size + align - 1) & ~(align - 1);
+    pool->first_offset = (sizeof(dma_pool_chunk_t) + align - 1) & ~(align - 1);
+
+    /* Au moins DMA_POOL_CHUNK_MIN_PAGES pages, et de quoi loger un objet */
+    size_t chunk = DMA_POOL_CHUNK_MIN_PAGES * PAGE_SIZE;
+    if (pool->first_offset + pool->obj_size > chunk) {
+        chunk = PAGE_ALIGN_UP(pool->first_offset + pool->obj_size);
+    }
+    pool->chunk_size = chunk;
+
+    spinlock_init(&pool->lock);
+    return pool;
+}
+
+void* dma_pool_alloc(dma_pool_t* pool, dma_addr_t* dma_handle)
+{
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&pool->lock);
+
+    if (pool->free_list == NULL && dma_pool_grow(pool) != 0) {
+        spinlock_irqrestore(&pool->lock, irq_flags);
+        KLOG_ERROR("DMA", "dma_pool_alloc: out of memory");
+        return NULL;
+    }
+
+    dma_pool_free_obj_t* obj = pool->free_list;
+    pool->free_list = obj->next;
+    pool->used_objs++;
+
+    spinlock_irqrestore(&pool->lock, irq_flags);
+
+    /* Les chunks sont dans le HHDM : la traduction est une soustraction */
+    if (dma_handle != NULL) {
+        *dma_handle = pmm_virt_to_phys(obj);
+    }
+    return obj;
+}
+
+void dma_pool_free(dma_pool_t* pool, void* vaddr)
+{
+    if (pool == NULL || vaddr == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&pool->lock);
+
+    dma_pool_free_obj_t* obj = (dma_pool_free_obj_t*)vaddr;
+    obj->next = pool->free_list;
+    pool->free_list = obj;
+    pool->used_objs--;
+
+    spinlock_irqrestore(&pool->lock, irq_flags);
+}
+
+void dma_pool_destroy(dma_pool_t* pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    if (pool->used_objs != 0) {
+        KLOG_WARN("DMA", "dma_pool_destroy: objects still in use");
+    }
+
+    dma_pool_chunk_t* chunk = pool->chunks;
+    while (chunk != NULL) {
+        dma_pool_chunk_t* next = chunk->next;
+        dma_free_coherent(chunk, chunk->size);
+        chunk = next;
+    }
+
+    kfree(pool);
+}
@@ -0,0 +1,88 @@
+/* src/mm/dma.h - Mémoire DMA cohérente pour les drivers */
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ========================================
+ * Types
+ * ======================================== */
+
+/* Adresse vue par le périphérique (adresse physique, pas d'IOMMU) */
+typedef uint64_t dma_addr_t;
+
+/*
+ * Pool d'objets DMA de taille fixe (buffers de paquets, petits descripteurs).
+ * Les objets sont découpés dans des chunks physiquement contigus obtenus
+ * par dma_alloc_coherent : l'adresse bus d'un objet est calculée une seule
+ * fois, à l'allocation, sans parcourir les tables de pages.
+ */
+typedef struct dma_pool dma_pool_t;
+
+/* ========================================
+ * Allocations cohérentes
+ * ======================================== */
+
+/**
+ * Alloue une zone physiquement contiguë, alignée sur une page et mise à
+ * zéro, pour un anneau de descripteurs ou un buffer partagé avec un
+ * périphérique (x86 : DMA cohérent avec le cache, rien à synchroniser).
+ *
+ * @param size        Taille en octets (arrondie à la page)
+ * @param dma_handle  Reçoit l'adresse bus de la zone
+ * @return Adresse virtuelle (HHDM), ou NULL si plus de mémoire contiguë
+ */
+void* dma_alloc_coherent(size_t size, dma_addr_t* dma_handle);
+
+/**
+ * Libère une zone obtenue par dma_alloc_coherent.
+ *
+ * @param vaddr  Adresse virtuelle retournée à l'allocation
+ * @param size   Taille passée à l'allocation
+ */
+void dma_free_coherent(void* vaddr, size_t size);
+
+/**
+ * Traduit une adresse virtuelle kernel quelconque (heap, HHDM) en adresse
+ * bus. Chemin lent (parcours des tables) réservé au code qui ne connaît pas
+ * encore l'adresse bus de ses buffers ; le buffer ne doit pas traverser de
+ * frontière de page.
+ */
+dma_addr_t dma_virt_to_bus(const void* vaddr);
+
+/* ========================================
+ * Pools d'objets
+ * ======================================== */
+
+/**
+ * Crée un pool d'objets DMA.
+ *
+ * @param name   Nom (debug)
+ * @param size   Taille d'un objet en octets
+ * @param align  Alignement d'un objet (puissance de 2, 0 = 8 octets)
+ * @return Le pool, ou NULL si paramètres invalides ou plus de mémoire
+ */
+dma_pool_t* dma_pool_create(const char* name, size_t size, size_t align);
+
+/**
+ * Alloue un objet du pool (utilisable en contexte d'interruption).
+ *
+ * @param pool        Pool source
+ * @param dma_handle  Reçoit l'adresse bus de l'objet
+ * @return Adresse virtuelle de l'objet, ou NULL si plus de mémoire
+ */
+void* dma_pool_alloc(dma_pool_t* pool, dma_addr_t* dma_handle);
+
+/**
+ * Rend un objet au pool.
+ */
+void dma_pool_free(dma_pool_t* pool, void* vaddr);
+
+/**
+ * Détruit un pool et rend tous ses chunks (les objets ne doivent plus être
+ * utilisés par le périphérique).
+ */
+void dma_pool_destroy(dma_pool_t* pool);
+
+#endif /* DMA_H */
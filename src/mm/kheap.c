@@ -1,16 +1,50 @@
-/* src/kheap.c - Kernel Heap Allocator avec Liste Chaînée */
+/* src/kheap.c - Kernel Heap Allocator (boundary tags + free lists ségrégées) */
 #include "kheap.h"
+#include "kheap_prof.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "../include/memlayout.h"
 #include "../kernel/thread.h"
 
 /* Pointeur vers le premier bloc du heap */
 static KHeapBlock* heap_start = NULL;
 
-/* Taille totale du heap */
+/* Taille totale du heap (toujours un multiple de PAGE_SIZE) */
 static size_t heap_total_size = 0;
 
+/* Taille initiale : le heap ne rend jamais de pages en dessous */
+static size_t heap_min_size = 0;
+
+/* Sérialise les extensions/réductions du heap (pris avant heap_lock) */
+static spinlock_t heap_grow_lock;
+
 /* Spinlock pour protéger l'accès concurrent au heap */
 static spinlock_t heap_lock;
 
+/* Free lists ségrégées : bin i contient les blocs libres de taille [2^i, 2^(i+1)) */
+static KHeapBlock* heap_bins[KHEAP_BIN_COUNT];
+
+/* Bitmap des bins non vides (bit i = heap_bins[i] != NULL) */
+static uint32_t heap_bin_bitmap = 0;
+
+/**
+ * Cache d'une classe de taille du slab allocator.
+ * Chaque classe a son propre lock pour ne pas sérialiser
+ * les allocations de tailles différentes.
+ */
+typedef struct {
+    size_t object_size;         /* Taille des objets */
+    KHeapSlab* partial;         /* Slabs ayant au moins un objet libre */
+    size_t slab_count;          /* Nombre total de slabs (pages) */
+    size_t empty_count;         /* Slabs entièrement libres gardés en cache */
+    size_t objects_total;       /* Capacité cumulée */
+    size_t objects_used;        /* Objets alloués */
+    spinlock_t lock;
+} kheap_slab_cache_t;
+
+static kheap_slab_cache_t slab_caches[KHEAP_SLAB_CLASS_COUNT];
+static bool slab_ready = false;
+
 /**
  * Aligne une taille sur 8 octets (alignement naturel pour 64-bit).
  * Cela améliore les performances et évite des problèmes d'alignement.
@@ -20,108 +54,583 @@ static inline size_t align8(size_t size)
     return (size + 7) & ~((size_t)7);
 }
 
+/* Fin (exclue) de la zone du heap */
+static inline uint8_t* heap_end_addr(void)
+{
+    return (uint8_t*)heap_start + heap_total_size;
+}
+
+/* Vérifie qu'un header est bien dans le heap */
+static inline bool block_in_heap(KHeapBlock* block)
+{
+    return heap_start != NULL &&
+           (uint8_t*)block >= (uint8_t*)heap_start &&
+           (uint8_t*)block + KHEAP_BLOCK_OVERHEAD <= heap_end_addr();
+}
+
+/* Fixe la taille d'un bloc et met à jour son footer */
+static inline void block_set_size(KHeapBlock* block, size_t size)
+{
+    block->size = size;
+    KHEAP_BLOCK_FOOTER(block)->size = size;
+}
+
+/* Bloc physiquement suivant, ou NULL en fin de heap */
+static inline KHeapBlock* block_next_phys(KHeapBlock* block)
+{
+    uint8_t* next = (uint8_t*)block + KHEAP_BLOCK_OVERHEAD + block->size;
+    if (next + KHEAP_BLOCK_OVERHEAD > heap_end_addr()) {
+        return NULL;
+    }
+    return (KHeapBlock*)next;
+}
+
+/* Bloc physiquement précédent (via son footer), ou NULL en début de heap */
+static inline KHeapBlock* block_prev_phys(KHeapBlock* block)
+{
+    if (block == heap_start) {
+        return NULL;
+    }
+    KHeapFooter* footer = (KHeapFooter*)((uint8_t*)block - sizeof(KHeapFooter));
+    return (KHeapBlock*)((uint8_t*)block - KHEAP_BLOCK_OVERHEAD - footer->size);
+}
+
+/* Index du bin pour une taille : floor(log2(size)) */
+static inline size_t bin_index(size_t size)
+{
+    size_t idx = (size_t)(63 - __builtin_clzll((uint64_t)size));
+    return (idx < KHEAP_BIN_COUNT) ? idx : KHEAP_BIN_COUNT - 1;
+}
+
+/* Insère un bloc libre en tête de son bin */
+static void bin_insert(KHeapBlock* block)
+{
+    size_t idx = bin_index(block->size);
+
+    block->is_free = true;
+    block->prev_free = NULL;
+    block->next_free = heap_bins[idx];
+    if (heap_bins[idx]) {
+        heap_bins[idx]->prev_free = block;
+    }
+    heap_bins[idx] = block;
+    heap_bin_bitmap |= (1u << idx);
+}
+
+/* Retire un bloc libre de son bin */
+static void bin_remove(KHeapBlock* block)
+{
+    size_t idx = bin_index(block->size);
+
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        heap_bins[idx] = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (heap_bins[idx] == NULL) {
+        heap_bin_bitmap &= ~(1u << idx);
+    }
+
+    block->next_free = NULL;
+    block->prev_free = NULL;
+    block->is_free = false;
+}
+
 /**
- * Tente de découper un bloc en deux si l'espace restant est suffisant.
+ * Cherche un bloc libre d'au moins size octets.
+ * D'abord un first fit dans le bin de la taille demandée, puis la tête
+ * du premier bin supérieur non vide (qui convient forcément), trouvé
+ * en O(1) grâce au bitmap.
+ */
+static KHeapBlock* bin_find(size_t size)
+{
+    size_t idx = bin_index(size);
+
+    for (KHeapBlock* b = heap_bins[idx]; b != NULL; b = b->next_free) {
+        if (b->size >= size) {
+            return b;
+        }
+    }
+
+    if (idx + 1 >= KHEAP_BIN_COUNT) {
+        return NULL;
+    }
+
+    uint32_t mask = heap_bin_bitmap & ~((1u << (idx + 1)) - 1);
+    if (mask == 0) {
+        return NULL;
+    }
+    return heap_bins[__builtin_ctz(mask)];
+}
+
+/**
+ * Tente de découper un bloc utilisé en deux si l'espace restant est suffisant.
+ * Le reste devient un bloc libre inséré dans son bin.
  * 
- * @param block Le bloc à découper
+ * @param block Le bloc à découper (non libre, hors des bins)
  * @param size La taille demandée (alignée)
  */
 static void split_block(KHeapBlock* block, size_t size)
 {
     /* 
      * On ne split que si l'espace restant peut contenir :
-     * - Un nouveau header (sizeof(KHeapBlock))
+     * - Un nouveau header et un footer
      * - Au moins KHEAP_MIN_BLOCK_SIZE octets de données
      */
     size_t remaining = block->size - size;
-    size_t min_split_size = sizeof(KHeapBlock) + KHEAP_MIN_BLOCK_SIZE;
     
-    if (remaining >= min_split_size) {
-        /* Calculer l'adresse du nouveau bloc */
-        /* IMPORTANT: On cast en uint8_t* pour faire de l'arithmétique en octets */
-        uint8_t* block_addr = (uint8_t*)block;
-        uint8_t* new_block_addr = block_addr + sizeof(KHeapBlock) + size;
+    if (remaining >= KHEAP_BLOCK_OVERHEAD + KHEAP_MIN_BLOCK_SIZE) {
+        block_set_size(block, size);
         
-        KHeapBlock* new_block = (KHeapBlock*)new_block_addr;
+        KHeapBlock* new_block = block_next_phys(block);
+        new_block->magic = KHEAP_BLOCK_MAGIC;
+        block_set_size(new_block, remaining - KHEAP_BLOCK_OVERHEAD);
+        bin_insert(new_block);
+    }
+    /* Sinon, on laisse le bloc entier (un peu de gaspillage mais évite la fragmentation) */
+}
+
+/**
+ * Fusionne un bloc libre (hors des bins) avec ses voisins physiques libres.
+ * Temps constant grâce aux boundary tags.
+ * 
+ * @return Le bloc résultant (peut être le voisin précédent)
+ */
+static KHeapBlock* coalesce_block(KHeapBlock* block)
+{
+    KHeapBlock* next = block_next_phys(block);
+    if (next != NULL && next->is_free) {
+        bin_remove(next);
+        next->magic = 0;
+        block_set_size(block, block->size + KHEAP_BLOCK_OVERHEAD + next->size);
+    }
+    
+    KHeapBlock* prev = block_prev_phys(block);
+    if (prev != NULL && prev->is_free) {
+        bin_remove(prev);
+        block->magic = 0;
+        block_set_size(prev, prev->size + KHEAP_BLOCK_OVERHEAD + block->size);
+        block = prev;
+    }
+    
+    return block;
+}
+
+/* ============================================ */
+/*        Extension / réduction du heap         */
+/* ============================================ */
+
+/* Nombre de pages 4 KiB dans une grande page de 2 MiB */
+#define HEAP_HUGE_PAGES     (PAGE_SIZE_2M / PAGE_SIZE)
+
+/**
+ * Démappe des pages du heap et rend leurs frames au PMM.
+ * Les grandes pages entièrement couvertes sont rendues d'un bloc.
+ */
+static void heap_unmap_pages(uint64_t virt, size_t count)
+{
+    size_t i = 0;
+    while (i < count) {
+        uint64_t addr = virt + i * PAGE_SIZE;
+        uint64_t phys = vmm_get_physical(addr);
         
-        /* Initialiser le nouveau bloc libre */
-        new_block->size = remaining - sizeof(KHeapBlock);
-        new_block->is_free = true;
-        new_block->next = block->next;
+        if (phys != 0 && vmm_get_page_size(addr) == PAGE_SIZE_2M &&
+            (addr & (PAGE_SIZE_2M - 1)) == 0 && count - i >= HEAP_HUGE_PAGES) {
+            vmm_unmap_range(addr, PAGE_SIZE_2M);
+            pmm_free_blocks(pmm_phys_to_virt(phys), HEAP_HUGE_PAGES);
+            i += HEAP_HUGE_PAGES;
+            continue;
+        }
         
-        /* Mettre à jour le bloc original */
-        block->size = size;
-        block->next = new_block;
+        if (phys != 0) {
+            vmm_unmap_page(addr);
+            pmm_free_block(pmm_phys_to_virt(phys));
+        }
+        i++;
     }
-    /* Sinon, on laisse le bloc entier (un peu de gaspillage mais évite la fragmentation) */
 }
 
 /**
- * Tente de fusionner un bloc avec le suivant s'il est libre.
+ * Mappe count pages fraîches du PMM à partir de virt.
+ * Chaque tranche de 2 MiB alignée est mappée en une grande page si le
+ * PMM a un bloc contigu (les blocs buddy d'ordre 9 sont alignés sur
+ * 2 MiB), sinon page par page.
+ * En cas d'échec, les pages déjà mappées sont rendues.
  * 
- * @param block Le bloc à fusionner
+ * @return true si toutes les pages ont été mappées
  */
-static void coalesce_block(KHeapBlock* block)
+static bool heap_map_pages(uint64_t virt, size_t count)
 {
-    if (block == NULL || block->next == NULL) {
-        return;
+    size_t i = 0;
+    while (i < count) {
+        uint64_t addr = virt + i * PAGE_SIZE;
+        
+        if ((addr & (PAGE_SIZE_2M - 1)) == 0 && count - i >= HEAP_HUGE_PAGES) {
+            void* frames = pmm_alloc_blocks(HEAP_HUGE_PAGES);
+            if (frames != NULL) {
+                if (vmm_map_range(pmm_virt_to_phys(frames), addr, PAGE_SIZE_2M,
+                                  PAGE_PRESENT | PAGE_RW) == 0) {
+                    i += HEAP_HUGE_PAGES;
+                    continue;
+                }
+                vmm_unmap_range(addr, PAGE_SIZE_2M);
+                pmm_free_blocks(frames, HEAP_HUGE_PAGES);
+            }
+        }
+        
+        void* frame = pmm_alloc_block();
+        if (frame == NULL) {
+            heap_unmap_pages(virt, i);
+            return false;
+        }
+        
+        uint64_t phys = pmm_virt_to_phys(frame);
+        vmm_map_page(phys, addr, PAGE_PRESENT | PAGE_RW);
+        
+        /* vmm_map_page échoue silencieusement si une table manque */
+        if (vmm_get_physical(addr) != phys) {
+            pmm_free_block(frame);
+            heap_unmap_pages(virt, i);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+/**
+ * Étend le heap d'au moins size octets de données utiles.
+ * Les nouvelles pages sont mappées en fin de heap puis fusionnées
+ * avec le dernier bloc s'il est libre.
+ * 
+ * Appelé SANS heap_lock : le mapping peut logger (et le log écrire
+ * sur disque via kmalloc).
+ * 
+ * @return true si le heap a grandi
+ */
+static bool heap_grow(size_t size)
+{
+    spinlock_lock(&heap_grow_lock);
+    
+    size_t bytes = PAGE_ALIGN_UP(size + KHEAP_BLOCK_OVERHEAD);
+    if (bytes < KHEAP_GROW_MIN) {
+        bytes = KHEAP_GROW_MIN;
+    }
+    
+    uint64_t virt = (uint64_t)heap_end_addr();
+    
+    /* Grande extension : compléter jusqu'à une frontière de 2 MiB pour
+     * que le reste puisse être mappé en grandes pages */
+    if (bytes >= PAGE_SIZE_2M) {
+        uint64_t pad = ((virt + PAGE_SIZE_2M - 1) & ~(PAGE_SIZE_2M - 1)) - virt;
+        bytes = pad + ((bytes + PAGE_SIZE_2M - 1) & ~(PAGE_SIZE_2M - 1));
+    }
+    if (virt + bytes > KHEAP_VIRT_END || !heap_map_pages(virt, bytes / PAGE_SIZE)) {
+        spinlock_unlock(&heap_grow_lock);
+        return false;
     }
     
-    /* Vérification de sanité : le pointeur next doit être dans le heap */
-    uint8_t* heap_end = (uint8_t*)heap_start + heap_total_size;
-    if ((uint8_t*)block->next < (uint8_t*)heap_start || 
-        (uint8_t*)block->next >= heap_end) {
-        /* Corruption détectée ! */
-        extern void console_puts(const char*);
-        extern void console_put_hex64(uint64_t);
-        console_puts("\n[KHEAP] CORRUPTION: block->next = 0x");
-        console_put_hex64((uint64_t)block->next);
-        console_puts(" is outside heap!\n");
-        block->next = NULL;  /* Couper la chaîne pour éviter le crash */
+    spinlock_lock(&heap_lock);
+    
+    KHeapBlock* block = (KHeapBlock*)virt;
+    heap_total_size += bytes;
+    block->magic = KHEAP_BLOCK_MAGIC;
+    block->is_free = false;
+    block_set_size(block, bytes - KHEAP_BLOCK_OVERHEAD);
+    
+    block = coalesce_block(block);
+    bin_insert(block);
+    
+    spinlock_unlock(&heap_lock);
+    spinlock_unlock(&heap_grow_lock);
+    
+    return true;
+}
+
+/**
+ * Rend au PMM les pages de fin du heap si le dernier bloc (libre)
+ * est assez grand. Appelé avec heap_lock tenu, depuis kfree().
+ * 
+ * @param block Dernier bloc physique du heap, libre et dans son bin
+ */
+static void heap_trim(KHeapBlock* block)
+{
+    /* Ordre des locks : heap_grow_lock avant heap_lock, d'où le trylock */
+    if (!spinlock_trylock(&heap_grow_lock)) {
         return;
     }
     
-    /* Si le bloc suivant est libre, on le fusionne */
-    if (block->next->is_free) {
-        /* 
-         * La nouvelle taille inclut :
-         * - La taille des données du bloc suivant
-         * - Le header du bloc suivant (qui disparaît)
-         */
-        block->size += sizeof(KHeapBlock) + block->next->size;
-        block->next = block->next->next;
+    uint64_t start = (uint64_t)heap_start;
+    uint64_t end = (uint64_t)heap_end_addr();
+    uint64_t keep_end = PAGE_ALIGN_UP((uint64_t)KHEAP_BLOCK_DATA(block) +
+                                      KHEAP_SHRINK_KEEP + sizeof(KHeapFooter));
+    if (keep_end < start + heap_min_size) {
+        keep_end = start + heap_min_size;
+    }
+    
+    /* Ne pas couper une grande page en deux : la garder entière */
+    if (vmm_get_page_size(keep_end) == PAGE_SIZE_2M) {
+        keep_end = (keep_end + PAGE_SIZE_2M - 1) & ~(PAGE_SIZE_2M - 1);
+    }
+    
+    if (keep_end < end) {
+        bin_remove(block);
+        block_set_size(block, keep_end - (uint64_t)block - KHEAP_BLOCK_OVERHEAD);
+        bin_insert(block);
         
-        /* Récursivement fusionner si le nouveau suivant est aussi libre */
-        coalesce_block(block);
+        heap_total_size = keep_end - start;
+        heap_unmap_pages(keep_end, (end - keep_end) / PAGE_SIZE);
     }
+    
+    spinlock_unlock(&heap_grow_lock);
+}
+
+/* ============================================ */
+/*              Slab Allocator                  */
+/* ============================================ */
+
+/**
+ * Retourne l'index de la plus petite classe pouvant contenir size.
+ * 16 -> 0, 32 -> 1, ..., 1024 -> 6.
+ */
+static inline size_t slab_class_index(size_t size)
+{
+    if (size <= KHEAP_SLAB_MIN_SIZE) {
+        return 0;
+    }
+    return (size_t)(64 - __builtin_clzll((uint64_t)(size - 1))) - 4;
+}
+
+/* Retire un slab de la liste partielle de son cache */
+static void slab_unlink(kheap_slab_cache_t* cache, KHeapSlab* slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        cache->partial = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+/* Ajoute un slab en tête de la liste partielle */
+static void slab_link(kheap_slab_cache_t* cache, KHeapSlab* slab)
+{
+    slab->prev = NULL;
+    slab->next = cache->partial;
+    if (cache->partial) {
+        cache->partial->prev = slab;
+    }
+    cache->partial = slab;
+}
+
+/**
+ * Crée un nouveau slab (une page PMM) pour une classe.
+ * Appelé avec cache->lock tenu.
+ */
+static KHeapSlab* slab_create(kheap_slab_cache_t* cache, size_t class_idx)
+{
+    KHeapSlab* slab = (KHeapSlab*)pmm_alloc_block();
+    if (slab == NULL) {
+        return NULL;
+    }
+
+    slab->magic = KHEAP_SLAB_MAGIC;
+    slab->class_idx = (uint16_t)class_idx;
+    slab->capacity = (uint16_t)((PMM_BLOCK_SIZE - KHEAP_SLAB_HEADER_SIZE) / cache->object_size);
+    slab->in_use = 0;
+    slab->next = NULL;
+    slab->prev = NULL;
+
+    /* Chaîner tous les objets dans la free list (ordre croissant) */
+    uint8_t* base = (uint8_t*)slab + KHEAP_SLAB_HEADER_SIZE;
+    slab->free_list = base;
+    for (uint16_t i = 0; i < slab->capacity; i++) {
+        void** obj = (void**)(base + (size_t)i * cache->object_size);
+        *obj = (i + 1 < slab->capacity) ? (void*)(base + (size_t)(i + 1) * cache->object_size) : NULL;
+    }
+
+    cache->slab_count++;
+    cache->empty_count++;
+    cache->objects_total += slab->capacity;
+    slab_link(cache, slab);
+
+    return slab;
+}
+
+/**
+ * Alloue un objet dans la classe donnée.
+ * @return Pointeur vers l'objet, ou NULL si le PMM est épuisé
+ */
+static void* slab_alloc(size_t class_idx)
+{
+    kheap_slab_cache_t* cache = &slab_caches[class_idx];
+
+    spinlock_lock(&cache->lock);
+
+    KHeapSlab* slab = cache->partial;
+    if (slab == NULL) {
+        slab = slab_create(cache, class_idx);
+        if (slab == NULL) {
+            spinlock_unlock(&cache->lock);
+            return NULL;
+        }
+    }
+
+    void** obj = (void**)slab->free_list;
+    slab->free_list = *obj;
+
+    if (slab->in_use == 0) {
+        cache->empty_count--;
+    }
+    slab->in_use++;
+    cache->objects_used++;
+
+    /* Slab plein : il sort de la liste partielle */
+    if (slab->in_use == slab->capacity) {
+        slab_unlink(cache, slab);
+    }
+
+    spinlock_unlock(&cache->lock);
+    return obj;
+}
+
+/**
+ * Retrouve le slab contenant ptr.
+ * @return Le slab, ou NULL si ptr n'est pas un objet slab valide
+ */
+static KHeapSlab* slab_from_ptr(void* ptr)
+{
+    uintptr_t addr = (uintptr_t)ptr;
+    KHeapSlab* slab = (KHeapSlab*)(addr & ~(uintptr_t)(PMM_BLOCK_SIZE - 1));
+    uintptr_t offset = addr - (uintptr_t)slab;
+
+    if (offset < KHEAP_SLAB_HEADER_SIZE) {
+        return NULL;
+    }
+    if (slab->magic != KHEAP_SLAB_MAGIC || slab->class_idx >= KHEAP_SLAB_CLASS_COUNT) {
+        return NULL;
+    }
+    if ((offset - KHEAP_SLAB_HEADER_SIZE) % slab_caches[slab->class_idx].object_size != 0) {
+        return NULL;
+    }
+    return slab;
+}
+
+/**
+ * Libère un objet slab. Les slabs devenus vides au-delà de
+ * KHEAP_SLAB_MAX_EMPTY sont rendus au PMM.
+ */
+static void slab_free(KHeapSlab* slab, void* ptr)
+{
+    kheap_slab_cache_t* cache = &slab_caches[slab->class_idx];
+
+    spinlock_lock(&cache->lock);
+
+    if (slab->in_use == 0) {
+        /* Double free */
+        spinlock_unlock(&cache->lock);
+        return;
+    }
+
+    /* Slab plein : il redevient partiel */
+    if (slab->in_use == slab->capacity) {
+        slab_link(cache, slab);
+    }
+
+    *(void**)ptr = slab->free_list;
+    slab->free_list = ptr;
+    slab->in_use--;
+    cache->objects_used--;
+
+    if (slab->in_use == 0) {
+        if (cache->empty_count >= KHEAP_SLAB_MAX_EMPTY) {
+            slab_unlink(cache, slab);
+            cache->slab_count--;
+            cache->objects_total -= slab->capacity;
+            slab->magic = 0;
+            pmm_free_block(slab);
+        } else {
+            cache->empty_count++;
+        }
+    }
+
+    spinlock_unlock(&cache->lock);
 }
 
 /* ============================================ */
 /*            Fonctions Publiques               */
 /* ============================================ */
 
-void kheap_init(void* start_addr, size_t size_bytes)
+int kheap_init(size_t initial_size)
 {
-    /* Initialiser le spinlock du heap */
+    /* Initialiser les spinlocks du heap */
     spinlock_init(&heap_lock);
+    spinlock_init(&heap_grow_lock);
+    
+    /* Initialiser les caches du slab allocator */
+    for (size_t i = 0; i < KHEAP_SLAB_CLASS_COUNT; i++) {
+        slab_caches[i].object_size = (size_t)KHEAP_SLAB_MIN_SIZE << i;
+        slab_caches[i].partial = NULL;
+        slab_caches[i].slab_count = 0;
+        slab_caches[i].empty_count = 0;
+        slab_caches[i].objects_total = 0;
+        slab_caches[i].objects_used = 0;
+        spinlock_init(&slab_caches[i].lock);
+    }
+    slab_ready = true;
     
-    if (start_addr == NULL || size_bytes < sizeof(KHeapBlock) + KHEAP_MIN_BLOCK_SIZE) {
-        return;
+    for (size_t i = 0; i < KHEAP_BIN_COUNT; i++) {
+        heap_bins[i] = NULL;
     }
+    heap_bin_bitmap = 0;
     
-    heap_start = (KHeapBlock*)start_addr;
-    heap_total_size = size_bytes;
+    initial_size = PAGE_ALIGN_UP(initial_size);
+    if (initial_size < KHEAP_GROW_MIN) {
+        initial_size = KHEAP_GROW_MIN;
+    }
+    
+    /* Mapper les pages initiales au début de la zone réservée */
+    if (!heap_map_pages(KHEAP_VIRT_BASE, initial_size / PAGE_SIZE)) {
+        return -1;
+    }
+    
+    heap_start = (KHeapBlock*)KHEAP_VIRT_BASE;
+    heap_total_size = initial_size;
+    heap_min_size = initial_size;
     
     /* Créer le premier bloc qui couvre tout le heap */
-    heap_start->size = size_bytes - sizeof(KHeapBlock);
-    heap_start->is_free = true;
-    heap_start->next = NULL;
+    heap_start->magic = KHEAP_BLOCK_MAGIC;
+    block_set_size(heap_start, initial_size - KHEAP_BLOCK_OVERHEAD);
+    bin_insert(heap_start);
+    
+    return 0;
 }
 
-void* kmalloc(size_t size)
+/* kmalloc sans enregistrement dans le profiler */
+static void* kmalloc_raw(size_t size)
 {
+    if (size == 0) {
+        return NULL;
+    }
+    
+    /* Petites tailles : slab allocator en O(1) */
+    if (slab_ready && size <= KHEAP_SLAB_MAX_SIZE) {
+        void* obj = slab_alloc(slab_class_index(size));
+        if (obj != NULL) {
+            return obj;
+        }
+        /* PMM épuisé : tenter quand même le heap à liste chaînée */
+    }
+    
     /* Vérification rapide avant de prendre le lock */
-    if (size == 0 || heap_start == NULL) {
+    if (heap_start == NULL) {
         return NULL;
     }
     
@@ -133,125 +642,135 @@ void* kmalloc(size_t size)
         size = KHEAP_MIN_BLOCK_SIZE;
     }
     
-    /* Prendre le lock avant d'accéder aux structures du heap */
-    spinlock_lock(&heap_lock);
-    
-    /* Parcourir la liste pour trouver un bloc libre assez grand (First Fit) */
-    KHeapBlock* current = heap_start;
-    
-    while (current != NULL) {
-        if (current->is_free && current->size >= size) {
-            /* Bloc trouvé ! */
-            
-            /* Essayer de le découper si trop grand */
-            split_block(current, size);
-            
-            /* Marquer comme utilisé */
-            current->is_free = false;
+    for (;;) {
+        /* Prendre le lock avant d'accéder aux structures du heap */
+        spinlock_lock(&heap_lock);
+        
+        KHeapBlock* block = bin_find(size);
+        if (block != NULL) {
+            /* Sortir le bloc de sa free list, puis le découper si trop grand */
+            bin_remove(block);
+            split_block(block, size);
             
-            /* Libérer le lock avant de retourner */
             spinlock_unlock(&heap_lock);
             
             /* Retourner l'adresse des données (après le header) */
-            return KHEAP_BLOCK_DATA(current);
+            return KHEAP_BLOCK_DATA(block);
         }
         
-        current = current->next;
+        /* Aucun bloc libre assez grand : étendre le heap puis réessayer */
+        spinlock_unlock(&heap_lock);
+        
+        if (!heap_grow(size)) {
+            return NULL;
+        }
     }
-    
-    /* Aucun bloc libre assez grand trouvé - libérer le lock */
-    spinlock_unlock(&heap_lock);
-    return NULL;
 }
 
-void kfree(void* ptr)
+/* kfree sans enregistrement dans le profiler */
+static void kfree_raw(void* ptr)
 {
-    /* Vérification rapide avant de prendre le lock */
-    if (ptr == NULL || heap_start == NULL) {
+    if (ptr == NULL) {
         return;
     }
     
     /* Retrouver le header du bloc */
     KHeapBlock* block = KHEAP_DATA_BLOCK(ptr);
     
+    /* Hors du heap à liste chaînée : objet slab ou pointeur invalide */
+    if (!block_in_heap(block)) {
+        KHeapSlab* slab = slab_ready ? slab_from_ptr(ptr) : NULL;
+        if (slab != NULL) {
+            slab_free(slab, ptr);
+        }
+        return;
+    }
+    
     /* Prendre le lock avant d'accéder aux structures du heap */
     spinlock_lock(&heap_lock);
     
-    /* Vérification basique : le bloc doit être dans le heap */
-    uint8_t* heap_end = (uint8_t*)heap_start + heap_total_size;
-    if ((uint8_t*)block < (uint8_t*)heap_start || (uint8_t*)block >= heap_end) {
+    /* Header invalide ou double free : ignorer */
+    if (block->magic != KHEAP_BLOCK_MAGIC || block->is_free) {
         spinlock_unlock(&heap_lock);
-        return; /* Pointeur invalide, hors du heap */
+        return;
     }
     
-    /* Marquer comme libre */
-    block->is_free = true;
-    
-    /* Tenter de fusionner avec le bloc suivant */
-    coalesce_block(block);
+    /* Fusionner avec les voisins libres (O(1)) puis remettre dans un bin */
+    block = coalesce_block(block);
+    bin_insert(block);
     
-    /* 
-     * Note: Pour fusionner avec le bloc précédent, il faudrait parcourir
-     * toute la liste depuis le début (car liste simplement chaînée).
-     * On le fait ici pour une meilleure défragmentation.
-     */
-    KHeapBlock* current = heap_start;
-    int max_iterations = 10000;  /* Protection contre boucle infinie */
-    while (current != NULL && max_iterations-- > 0) {
-        /* Vérification de sanité */
-        if ((uint8_t*)current < (uint8_t*)heap_start || 
-            (uint8_t*)current >= heap_end) {
-            break;  /* Corruption, arrêter */
-        }
-        if (current->is_free) {
-            coalesce_block(current);
-        }
-        current = current->next;
+    /* Grand bloc libre en fin de heap : rendre les pages au PMM */
+    if (block_next_phys(block) == NULL && block->size >= KHEAP_SHRINK_THRESHOLD) {
+        heap_trim(block);
     }
     
     spinlock_unlock(&heap_lock);
 }
 
-void* krealloc(void* ptr, size_t new_size)
+/* krealloc sans enregistrement dans le profiler */
+static void* krealloc_raw(void* ptr, size_t new_size)
 {
     /* Si ptr est NULL, équivalent à kmalloc */
     if (ptr == NULL) {
-        return kmalloc(new_size);
+        return kmalloc_raw(new_size);
     }
     
     /* Si new_size est 0, équivalent à kfree */
     if (new_size == 0) {
-        kfree(ptr);
+        kfree_raw(ptr);
         return NULL;
     }
     
     /* Retrouver le header du bloc actuel */
     KHeapBlock* block = KHEAP_DATA_BLOCK(ptr);
+    size_t old_size;
     
-    /* Vérification : le bloc doit être dans le heap */
-    uint8_t* heap_end = (uint8_t*)heap_start + heap_total_size;
-    if ((uint8_t*)block < (uint8_t*)heap_start || (uint8_t*)block >= heap_end) {
-        /* Pointeur hors du heap - ne peut pas être réalloué */
-        /* Allouer un nouveau bloc sans copier (on ne connaît pas la taille) */
-        return kmalloc(new_size);
-    }
+    new_size = align8(new_size);
     
-    /* Vérifier que le bloc n'est pas corrompu */
-    if (block->is_free) {
-        /* Le bloc est marqué libre - corruption ou double free */
-        return kmalloc(new_size);
+    /* Vérification : le bloc doit être dans le heap */
+    if (!block_in_heap(block)) {
+        KHeapSlab* slab = slab_ready ? slab_from_ptr(ptr) : NULL;
+        if (slab == NULL) {
+            /* Pointeur hors du heap - ne peut pas être réalloué */
+            /* Allouer un nouveau bloc sans copier (on ne connaît pas la taille) */
+            return kmalloc_raw(new_size);
+        }
+        old_size = slab_caches[slab->class_idx].object_size;
+    } else {
+        spinlock_lock(&heap_lock);
+        
+        /* Vérifier que le bloc n'est pas corrompu */
+        if (block->magic != KHEAP_BLOCK_MAGIC || block->is_free) {
+            /* Le bloc est marqué libre - corruption ou double free */
+            spinlock_unlock(&heap_lock);
+            return kmalloc_raw(new_size);
+        }
+        old_size = block->size;
+        
+        /* Fast path : absorber le bloc suivant s'il est libre et suffisant */
+        if (new_size > old_size) {
+            KHeapBlock* next = block_next_phys(block);
+            if (next != NULL && next->is_free &&
+                old_size + KHEAP_BLOCK_OVERHEAD + next->size >= new_size) {
+                bin_remove(next);
+                next->magic = 0;
+                block_set_size(block, old_size + KHEAP_BLOCK_OVERHEAD + next->size);
+                split_block(block, new_size);
+                spinlock_unlock(&heap_lock);
+                return ptr;
+            }
+        }
+        
+        spinlock_unlock(&heap_lock);
     }
     
-    size_t old_size = block->size;
-    
     /* Si la nouvelle taille est plus petite ou égale, on peut garder le même bloc */
-    new_size = (new_size + 7) & ~((size_t)7);  /* Aligner sur 8 octets */
     if (new_size <= old_size) {
         return ptr;
     }
     
     /* Allouer un nouveau bloc */
-    void* new_ptr = kmalloc(new_size);
+    void* new_ptr = kmalloc_raw(new_size);
     if (new_ptr == NULL) {
         return NULL; /* Échec d'allocation, l'ancien bloc reste valide */
     }
@@ -265,8 +784,56 @@ void* krealloc(void* ptr, size_t new_size)
     }
     
     /* Libérer l'ancien bloc */
-    kfree(ptr);
+    kfree_raw(ptr);
+    
+    return new_ptr;
+}
+
+/* ============================================ */
+/*      Points d'entrée (hooks du profiler)     */
+/* ============================================ */
+
+static inline void* kmalloc_traced(size_t size, void* caller)
+{
+    void* ptr = kmalloc_raw(size);
+    if (kheap_prof_active && ptr != NULL) {
+        kheap_prof_record_alloc(ptr, size, caller);
+    }
+    return ptr;
+}
+
+static inline void kfree_traced(void* ptr)
+{
+    if (kheap_prof_active) {
+        kheap_prof_record_free(ptr);
+    }
+    kfree_raw(ptr);
+}
+
+void* kmalloc(size_t size)
+{
+    return kmalloc_traced(size, __builtin_return_address(0));
+}
+
+void kfree(void* ptr)
+{
+    kfree_traced(ptr);
+}
+
+void* krealloc(void* ptr, size_t new_size)
+{
+    if (!kheap_prof_active) {
+        return krealloc_raw(ptr, new_size);
+    }
     
+    /* Oublier l'ancien bloc avant qu'il puisse être réutilisé */
+    kheap_prof_record_free(ptr);
+    void* new_ptr = krealloc_raw(ptr, new_size);
+    
+    /* En cas d'échec, l'ancien bloc reste alloué mais n'est plus suivi */
+    if (new_ptr != NULL) {
+        kheap_prof_record_alloc(new_ptr, new_size, __builtin_return_address(0));
+    }
     return new_ptr;
 }
 
@@ -280,13 +847,11 @@ size_t kheap_get_free_size(void)
     spinlock_lock(&heap_lock);
     
     size_t free_size = 0;
-    KHeapBlock* current = heap_start;
     
-    while (current != NULL) {
-        if (current->is_free) {
-            free_size += current->size;
+    for (size_t i = 0; i < KHEAP_BIN_COUNT; i++) {
+        for (KHeapBlock* b = heap_bins[i]; b != NULL; b = b->next_free) {
+            free_size += b->size;
         }
-        current = current->next;
     }
     
     spinlock_unlock(&heap_lock);
@@ -300,9 +865,10 @@ size_t kheap_get_block_count(void)
     size_t count = 0;
     KHeapBlock* current = heap_start;
     
+    /* Parcours physique du heap via les tailles des blocs */
     while (current != NULL) {
         count++;
-        current = current->next;
+        current = block_next_phys(current);
     }
     
     spinlock_unlock(&heap_lock);
@@ -314,19 +880,51 @@ size_t kheap_get_free_block_count(void)
     spinlock_lock(&heap_lock);
 
     size_t count = 0;
-    KHeapBlock* current = heap_start;
 
-    while (current != NULL) {
-        if (current->is_free) {
+    for (size_t i = 0; i < KHEAP_BIN_COUNT; i++) {
+        for (KHeapBlock* b = heap_bins[i]; b != NULL; b = b->next_free) {
             count++;
         }
-        current = current->next;
     }
 
     spinlock_unlock(&heap_lock);
     return count;
 }
 
+size_t kheap_get_slab_class_count(void)
+{
+    return KHEAP_SLAB_CLASS_COUNT;
+}
+
+int kheap_get_slab_stats(size_t class_idx, kheap_slab_stats_t* stats)
+{
+    if (class_idx >= KHEAP_SLAB_CLASS_COUNT || stats == NULL) {
+        return -1;
+    }
+
+    kheap_slab_cache_t* cache = &slab_caches[class_idx];
+
+    spinlock_lock(&cache->lock);
+    stats->object_size = cache->object_size;
+    stats->slab_count = cache->slab_count;
+    stats->objects_total = cache->objects_total;
+    stats->objects_used = cache->objects_used;
+    spinlock_unlock(&cache->lock);
+
+    return 0;
+}
+
+size_t kheap_get_slab_total_size(void)
+{
+    size_t pages = 0;
+
+    for (size_t i = 0; i < KHEAP_SLAB_CLASS_COUNT; i++) {
+        pages += slab_caches[i].slab_count;
+    }
+
+    return pages * PMM_BLOCK_SIZE;
+}
+
 /* ============================================ */
 /*            Fonctions Standard C               */
 /* ============================================ */
@@ -337,7 +935,7 @@ size_t kheap_get_free_block_count(void)
  */
 void* malloc(size_t size)
 {
-    return kmalloc(size);
+    return kmalloc_traced(size, __builtin_return_address(0));
 }
 
 /**
@@ -346,5 +944,5 @@ void* malloc(size_t size)
  */
 void free(void* ptr)
 {
-    kfree(ptr);
+    kfree_traced(ptr);
 }
@@ -9,33 +9,123 @@
 /**
  * Structure d'en-tête pour chaque bloc du heap.
  * Placée juste avant les données utilisateur.
+ *
+ * Chaque bloc est suivi d'un footer (boundary tag) qui recopie sa taille :
+ * le bloc physiquement précédent se retrouve ainsi en O(1), sans parcourir
+ * le heap. Les blocs libres sont chaînés dans des listes ségrégées par
+ * puissance de 2 (bins), ce qui rend kfree() et la fusion en temps constant.
  */
 typedef struct KHeapBlock {
-    size_t size;                /* Taille des données (sans le header) */
-    bool is_free;               /* true si le bloc est libre */
-    struct KHeapBlock* next;    /* Pointeur vers le bloc suivant */
+    size_t size;                    /* Taille des données (sans header ni footer) */
+    uint32_t magic;                 /* KHEAP_BLOCK_MAGIC */
+    bool is_free;                   /* true si le bloc est libre */
+    struct KHeapBlock* next_free;   /* Bloc libre suivant dans le même bin */
+    struct KHeapBlock* prev_free;   /* Bloc libre précédent dans le même bin */
 } KHeapBlock;
 
+/**
+ * Footer (boundary tag) placé juste après les données d'un bloc.
+ */
+typedef struct KHeapFooter {
+    size_t size;                    /* Copie de KHeapBlock.size */
+} KHeapFooter;
+
+/* Magic number d'un header de bloc valide */
+#define KHEAP_BLOCK_MAGIC       0x4B484250  /* 'KHBP' */
+
 /* Taille minimale d'un bloc de données (pour éviter des blocs trop petits) */
 #define KHEAP_MIN_BLOCK_SIZE    16
 
+/* Surcoût par bloc : header + footer */
+#define KHEAP_BLOCK_OVERHEAD    (sizeof(KHeapBlock) + sizeof(KHeapFooter))
+
+/* Granularité minimale d'extension du heap (évite un mapping par kmalloc) */
+#define KHEAP_GROW_MIN          (64 * 1024)
+
+/* Le heap rend ses pages de fin au PMM au-delà de ce seuil de mémoire libre */
+#define KHEAP_SHRINK_THRESHOLD  (256 * 1024)
+
+/* Mémoire libre gardée en fin de heap après un rendu de pages */
+#define KHEAP_SHRINK_KEEP       (64 * 1024)
+
+/* Nombre de bins de la free list ségrégée (bin i : tailles [2^i, 2^(i+1))) */
+#define KHEAP_BIN_COUNT         32
+
 /* Macro pour obtenir l'adresse des données depuis un header */
 #define KHEAP_BLOCK_DATA(block) ((void*)((uint8_t*)(block) + sizeof(KHeapBlock)))
 
 /* Macro pour obtenir le header depuis l'adresse des données */
 #define KHEAP_DATA_BLOCK(ptr)   ((KHeapBlock*)((uint8_t*)(ptr) - sizeof(KHeapBlock)))
 
+/* Macro pour obtenir le footer d'un bloc */
+#define KHEAP_BLOCK_FOOTER(block) \
+    ((KHeapFooter*)((uint8_t*)KHEAP_BLOCK_DATA(block) + (block)->size))
+
+/* ========================================
+ * Slab allocator (classes de taille)
+ * ========================================
+ *
+ * Les petites allocations (<= KHEAP_SLAB_MAX_SIZE) sont servies en O(1)
+ * par des slabs d'une page physique, une liste de slabs par classe
+ * (16, 32, 64, 128, 256, 512, 1024 octets). Le heap à liste chaînée
+ * ne sert plus que les tailles plus grandes.
+ */
+
+#define KHEAP_SLAB_MAGIC        0x534C4142  /* 'SLAB' */
+#define KHEAP_SLAB_MIN_SIZE     16
+#define KHEAP_SLAB_MAX_SIZE     1024
+#define KHEAP_SLAB_CLASS_COUNT  7
+
+/* Taille réservée en tête de chaque page slab (header + alignement) */
+#define KHEAP_SLAB_HEADER_SIZE  64
+
+/* Nombre de slabs vides gardés en cache par classe avant rendu au PMM */
+#define KHEAP_SLAB_MAX_EMPTY    1
+
 /**
- * Initialise le kernel heap avec une zone mémoire donnée.
+ * En-tête d'un slab, placé au début de sa page physique.
+ * Les objets suivent à partir de KHEAP_SLAB_HEADER_SIZE.
+ */
+typedef struct KHeapSlab {
+    uint32_t magic;             /* KHEAP_SLAB_MAGIC */
+    uint16_t class_idx;         /* Index de la classe de taille */
+    uint16_t capacity;          /* Nombre d'objets dans le slab */
+    uint16_t in_use;            /* Objets actuellement alloués */
+    void* free_list;            /* Liste des objets libres (chaînée in-place) */
+    struct KHeapSlab* next;     /* Slab suivant dans la liste partielle */
+    struct KHeapSlab* prev;     /* Slab précédent dans la liste partielle */
+} KHeapSlab;
+
+/**
+ * Statistiques d'une classe de taille du slab allocator.
+ */
+typedef struct {
+    size_t object_size;         /* Taille des objets de la classe */
+    size_t slab_count;          /* Pages slab allouées */
+    size_t objects_total;       /* Capacité totale (objets) */
+    size_t objects_used;        /* Objets alloués */
+} kheap_slab_stats_t;
+
+/**
+ * Initialise le kernel heap dans sa zone virtuelle réservée
+ * (KHEAP_VIRT_BASE, voir memlayout.h).
+ *
+ * Les pages initiales sont prises au PMM et mappées via vmm_map_page :
+ * le VMM doit donc être initialisé avant. Le heap grandit ensuite à la
+ * demande quand aucun bloc libre ne convient, et rend ses pages de fin
+ * au PMM quand elles redeviennent libres (sans descendre sous la taille
+ * initiale).
  * 
- * @param start_addr Adresse de début de la zone mémoire pour le heap
- * @param size_bytes Taille totale de la zone en octets
+ * @param initial_size Taille initiale du heap en octets (arrondie à la page)
+ * @return 0 si succès, -1 si échec
  */
-void kheap_init(void* start_addr, size_t size_bytes);
+int kheap_init(size_t initial_size);
 
 /**
  * Alloue un bloc de mémoire de la taille demandée.
- * Utilise l'algorithme First Fit.
+ * Les petites tailles passent par le slab allocator (O(1)),
+ * les autres par le heap à liste chaînée (First Fit).
+ * Enregistrée par le profiler quand il est actif (voir kheap_prof.h).
  * 
  * @param size Taille en octets à allouer
  * @return Pointeur vers la zone allouée, ou NULL si échec
@@ -44,7 +134,7 @@ void* kmalloc(size_t size);
 
 /**
  * Libère un bloc de mémoire précédemment alloué.
- * Tente de fusionner avec les blocs adjacents libres.
+ * Fusionne en O(1) avec les blocs voisins libres (boundary tags).
  * 
  * @param ptr Pointeur vers la zone à libérer (retourné par kmalloc)
  */
@@ -54,6 +144,7 @@ void kfree(void* ptr);
  * Réalloue un bloc de mémoire avec une nouvelle taille.
  * - Si ptr est NULL, équivalent à kmalloc(new_size)
  * - Si new_size est 0, équivalent à kfree(ptr) et retourne NULL
+ * - Si le bloc suivant est libre et suffisant, agrandit sur place
  * - Sinon, alloue un nouveau bloc, copie les données, libère l'ancien
  * 
  * @param ptr Pointeur vers la zone à réallouer (ou NULL)
@@ -63,7 +154,7 @@ void kfree(void* ptr);
 void* krealloc(void* ptr, size_t new_size);
 
 /**
- * Retourne la taille totale du heap en octets.
+ * Retourne la taille totale du heap en octets (mappée actuellement).
  */
 size_t kheap_get_total_size(void);
 
@@ -82,6 +173,25 @@ size_t kheap_get_block_count(void);
  */
 size_t kheap_get_free_block_count(void);
 
+/**
+ * Retourne le nombre de classes de taille du slab allocator.
+ */
+size_t kheap_get_slab_class_count(void);
+
+/**
+ * Retourne les statistiques d'une classe de taille.
+ *
+ * @param class_idx Index de la classe (0 .. KHEAP_SLAB_CLASS_COUNT-1)
+ * @param stats     Structure de sortie
+ * @return 0 si succès, -1 si index invalide
+ */
+int kheap_get_slab_stats(size_t class_idx, kheap_slab_stats_t* stats);
+
+/**
+ * Retourne la mémoire totale (en octets) occupée par les pages slab.
+ */
+size_t kheap_get_slab_total_size(void);
+
 /**
  * Wrapper standard malloc qui utilise le heap kernel.
  * Identique à kmalloc mais avec le nom standard.
@@ -0,0 +1,307 @@
+/* src/mm/kheap_prof.c - Profilage des allocations du kernel heap */
+#include "kheap_prof.h"
+#include "../kernel/thread.h"
+#include "../kernel/timer.h"
+
+/* Allocation suivie (ptr == 0 : slot vide) */
+typedef struct {
+    uintptr_t ptr;
+    uintptr_t caller;
+    uint32_t size;
+    uint16_t site;              /* Index dans prof_sites, ou KHEAP_PROF_SITE_COUNT */
+    uint64_t time_ms;
+} kheap_prof_record_t;
+
+volatile bool kheap_prof_active = false;
+
+static kheap_prof_record_t prof_records[KHEAP_PROF_TABLE_SIZE];
+static kheap_prof_site_t prof_sites[KHEAP_PROF_SITE_COUNT];
+static uint64_t prof_histogram[KHEAP_PROF_HIST_BUCKETS];
+static kheap_prof_summary_t prof_summary;
+static spinlock_t prof_lock;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+/* Hachage multiplicatif (Fibonacci) d'une adresse */
+static inline uint32_t prof_hash(uintptr_t value, uint32_t mask)
+{
+    return (uint32_t)(((uint64_t)(value >> 4) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+static inline uint32_t hist_bucket(size_t size)
+{
+    uint32_t bucket = 0;
+    while (size > 1 && bucket < KHEAP_PROF_HIST_BUCKETS - 1) {
+        size >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Trouve (ou crée) le site d'un appelant (prof_lock tenu).
+ * @return Index du site, ou KHEAP_PROF_SITE_COUNT si la table est pleine
+ */
+static uint16_t site_lookup(uintptr_t caller)
+{
+    uint32_t mask = KHEAP_PROF_SITE_COUNT - 1;
+    uint32_t idx = prof_hash(caller, mask);
+
+    for (uint32_t n = 0; n < KHEAP_PROF_SITE_COUNT; n++) {
+        kheap_prof_site_t* site = &prof_sites[idx];
+        if (site->caller == caller) {
+            return (uint16_t)idx;
+        }
+        if (site->caller == 0) {
+            site->caller = caller;
+            return (uint16_t)idx;
+        }
+        idx = (idx + 1) & mask;
+    }
+    return KHEAP_PROF_SITE_COUNT;
+}
+
+/**
+ * Vide le slot i et recompacte la chaîne de sondage qui le suit
+ * (suppression sans tombstone, prof_lock tenu).
+ */
+static void record_remove_slot(uint32_t i)
+{
+    uint32_t mask = KHEAP_PROF_TABLE_SIZE - 1;
+
+    for (;;) {
+        prof_records[i].ptr = 0;
+        uint32_t j = i;
+
+        for (;;) {
+            j = (j + 1) & mask;
+            if (prof_records[j].ptr == 0) {
+                return;
+            }
+            uint32_t home = prof_hash(prof_records[j].ptr, mask);
+            /* L'entrée reste si son slot d'origine est dans (i, j] (circulaire) */
+            bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays) {
+                break;
+            }
+        }
+
+        prof_records[i] = prof_records[j];
+        i = j;
+    }
+}
+
+/* ========================================
+ * Hooks
+ * ======================================== */
+
+void kheap_prof_record_alloc(void* ptr, size_t size, void* caller)
+{
+    uint64_t now = timer_get_uptime_ms();
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+
+    prof_summary.total_allocs++;
+    prof_histogram[hist_bucket(size)]++;
+
+    uint16_t site_idx = site_lookup((uintptr_t)caller);
+    if (site_idx < KHEAP_PROF_SITE_COUNT) {
+        prof_sites[site_idx].total_count++;
+    }
+
+    /* Table pleine aux 7/8 : ne plus suivre (les sondages s'allongent) */
+    if (prof_summary.live_count >= KHEAP_PROF_TABLE_SIZE - KHEAP_PROF_TABLE_SIZE / 8) {
+        prof_summary.dropped++;
+        spinlock_irqrestore(&prof_lock, irq_flags);
+        return;
+    }
+
+    uint32_t mask = KHEAP_PROF_TABLE_SIZE - 1;
+    uint32_t idx = prof_hash((uintptr_t)ptr, mask);
+    while (prof_records[idx].ptr != 0 && prof_records[idx].ptr != (uintptr_t)ptr) {
+        idx = (idx + 1) & mask;
+    }
+
+    kheap_prof_record_t* rec = &prof_records[idx];
+    if (rec->ptr == (uintptr_t)ptr) {
+        /* Adresse déjà suivie (kfree manqué) : remplacer l'entrée */
+        if (rec->site < KHEAP_PROF_SITE_COUNT) {
+            prof_sites[rec->site].live_bytes -= rec->size;
+            prof_sites[rec->site].live_count--;
+        }
+        prof_summary.live_bytes -= rec->size;
+        prof_summary.live_count--;
+    }
+
+    rec->ptr = (uintptr_t)ptr;
+    rec->caller = (uintptr_t)caller;
+    rec->size = (uint32_t)size;
+    rec->site = site_idx;
+    rec->time_ms = now;
+
+    if (site_idx < KHEAP_PROF_SITE_COUNT) {
+        prof_sites[site_idx].live_bytes += size;
+        prof_sites[site_idx].live_count++;
+    }
+    prof_summary.live_bytes += size;
+    prof_summary.live_count++;
+
+    spinlock_irqrestore(&prof_lock, irq_flags);
+}
+
+void kheap_prof_record_free(void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+
+    uint32_t mask = KHEAP_PROF_TABLE_SIZE - 1;
+    uint32_t idx = prof_hash((uintptr_t)ptr, mask);
+    while (prof_records[idx].ptr != 0) {
+        if (prof_records[idx].ptr == (uintptr_t)ptr) {
+            kheap_prof_record_t* rec = &prof_records[idx];
+            if (rec->site < KHEAP_PROF_SITE_COUNT) {
+                prof_sites[rec->site].live_bytes -= rec->size;
+                prof_sites[rec->site].live_count--;
+            }
+            prof_summary.live_bytes -= rec->size;
+            prof_summary.live_count--;
+            record_remove_slot(idx);
+            break;
+        }
+        idx = (idx + 1) & mask;
+    }
+
+    spinlock_irqrestore(&prof_lock, irq_flags);
+}
+
+/* ========================================
+ * Contrôle et requêtes
+ * ======================================== */
+
+void kheap_prof_enable(void)
+{
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+
+    for (uint32_t i = 0; i < KHEAP_PROF_TABLE_SIZE; i++) {
+        prof_records[i].ptr = 0;
+    }
+    for (uint32_t i = 0; i < KHEAP_PROF_SITE_COUNT; i++) {
+        prof_sites[i].caller = 0;
+        prof_sites[i].live_bytes = 0;
+        prof_sites[i].live_count = 0;
+        prof_sites[i].total_count = 0;
+    }
+    for (uint32_t i = 0; i < KHEAP_PROF_HIST_BUCKETS; i++) {
+        prof_histogram[i] = 0;
+    }
+    prof_summary.live_count = 0;
+    prof_summary.live_bytes = 0;
+    prof_summary.total_allocs = 0;
+    prof_summary.dropped = 0;
+
+    kheap_prof_active = true;
+
+    spinlock_irqrestore(&prof_lock, irq_flags);
+}
+
+void kheap_prof_disable(void)
+{
+    kheap_prof_active = false;
+}
+
+size_t kheap_prof_top_sites(kheap_prof_site_t* out, size_t max)
+{
+    if (out == NULL || max == 0) {
+        return 0;
+    }
+
+    size_t count = 0;
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+
+    /* Tri par insertion dans out (max est petit) */
+    for (uint32_t i = 0; i < KHEAP_PROF_SITE_COUNT; i++) {
+        kheap_prof_site_t* site = &prof_sites[i];
+        if (site->caller == 0 || site->live_bytes == 0) {
+            continue;
+        }
+        if (count == max && site->live_bytes <= out[max - 1].live_bytes) {
+            continue;
+        }
+
+        size_t pos = (count < max) ? count++ : max - 1;
+        while (pos > 0 && out[pos - 1].live_bytes < site->live_bytes) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos] = *site;
+    }
+
+    spinlock_irqrestore(&prof_lock, irq_flags);
+    return count;
+}
+
+size_t kheap_prof_leak_candidates(kheap_prof_alloc_t* out, size_t max, uint64_t min_age_ms)
+{
+    if (out == NULL || max == 0) {
+        return 0;
+    }
+
+    uint64_t now = timer_get_uptime_ms();
+    size_t count = 0;
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+
+    for (uint32_t i = 0; i < KHEAP_PROF_TABLE_SIZE; i++) {
+        kheap_prof_record_t* rec = &prof_records[i];
+        if (rec->ptr == 0) {
+            continue;
+        }
+        uint64_t age = now - rec->time_ms;
+        if (age < min_age_ms) {
+            continue;
+        }
+        if (count == max && age <= out[max - 1].age_ms) {
+            continue;
+        }
+
+        size_t pos = (count < max) ? count++ : max - 1;
+        while (pos > 0 && out[pos - 1].age_ms < age) {
+            out[pos] = out[pos - 1];
+            pos--;
+        }
+        out[pos].ptr = rec->ptr;
+        out[pos].caller = rec->caller;
+        out[pos].size = rec->size;
+        out[pos].age_ms = age;
+    }
+
+    spinlock_irqrestore(&prof_lock, irq_flags);
+    return count;
+}
+
+void kheap_prof_get_histogram(uint64_t* buckets)
+{
+    if (buckets == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+    for (uint32_t i = 0; i < KHEAP_PROF_HIST_BUCKETS; i++) {
+        buckets[i] = prof_histogram[i];
+    }
+    spinlock_irqrestore(&prof_lock, irq_flags);
+}
+
+void kheap_prof_get_summary(kheap_prof_summary_t* summary)
+{
+    if (summary == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&prof_lock);
+    *summary = prof_summary;
+    spinlock_irqrestore(&prof_lock, irq_flags);
+}
@@ -0,0 +1,117 @@
+/* src/mm/kheap_prof.h - Profilage des allocations du kernel heap */
+#ifndef KHEAP_PROF_H
+#define KHEAP_PROF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Quand le profilage est actif, kmalloc/kfree/krealloc enregistrent chaque
+ * allocation (adresse de retour de l'appelant, taille, date) dans une table
+ * de hachage de taille fixe, et agrègent les octets vivants par site
+ * d'appel. Désactivé, le coût est un test de booléen par appel ; activé,
+ * une insertion/suppression en O(1) sous un spinlock dédié.
+ *
+ * Les allocations faites avant l'activation ne sont pas suivies : leur
+ * kfree est simplement ignoré par le profiler.
+ */
+
+/* ========================================
+ * Configuration
+ * ======================================== */
+
+/* Allocations vivantes suivies au maximum (puissance de 2) */
+#define KHEAP_PROF_TABLE_SIZE   4096
+
+/* Sites d'appel distincts suivis au maximum (puissance de 2) */
+#define KHEAP_PROF_SITE_COUNT   256
+
+/* Histogramme : bucket i = tailles [2^i, 2^(i+1)), le dernier inclut le reste */
+#define KHEAP_PROF_HIST_BUCKETS 16
+
+/* ========================================
+ * Types
+ * ======================================== */
+
+/**
+ * Statistiques d'un site d'appel.
+ */
+typedef struct {
+    uintptr_t caller;           /* Adresse de retour dans l'appelant */
+    size_t live_bytes;          /* Octets encore alloués */
+    uint32_t live_count;        /* Allocations encore vivantes */
+    uint32_t total_count;       /* Allocations depuis l'activation */
+} kheap_prof_site_t;
+
+/**
+ * Allocation vivante (candidate à une fuite).
+ */
+typedef struct {
+    uintptr_t ptr;
+    uintptr_t caller;
+    size_t size;
+    uint64_t age_ms;            /* Temps écoulé depuis l'allocation */
+} kheap_prof_alloc_t;
+
+/**
+ * Résumé global.
+ */
+typedef struct {
+    size_t live_count;          /* Allocations suivies encore vivantes */
+    size_t live_bytes;
+    uint64_t total_allocs;      /* Allocations vues depuis l'activation */
+    uint64_t dropped;           /* Allocations non suivies (table pleine) */
+} kheap_prof_summary_t;
+
+/* Lu par kmalloc/kfree : ne pas modifier directement */
+extern volatile bool kheap_prof_active;
+
+/* ========================================
+ * Hooks (appelés par kheap.c)
+ * ======================================== */
+
+void kheap_prof_record_alloc(void* ptr, size_t size, void* caller);
+void kheap_prof_record_free(void* ptr);
+
+/* ========================================
+ * Contrôle et requêtes
+ * ======================================== */
+
+/**
+ * Active le profilage (remet les tables à zéro).
+ */
+void kheap_prof_enable(void);
+
+/**
+ * Désactive le profilage (les tables restent consultables).
+ */
+void kheap_prof_disable(void);
+
+/**
+ * Remplit out avec les sites d'appel qui retiennent le plus d'octets,
+ * triés par live_bytes décroissant.
+ *
+ * @return Nombre d'entrées écrites (<= max)
+ */
+size_t kheap_prof_top_sites(kheap_prof_site_t* out, size_t max);
+
+/**
+ * Remplit out avec les allocations vivantes les plus anciennes, âgées
+ * d'au moins min_age_ms (triées de la plus ancienne à la plus récente).
+ *
+ * @return Nombre d'entrées écrites (<= max)
+ */
+size_t kheap_prof_leak_candidates(kheap_prof_alloc_t* out, size_t max, uint64_t min_age_ms);
+
+/**
+ * Copie l'histogramme des tailles demandées (KHEAP_PROF_HIST_BUCKETS entrées).
+ */
+void kheap_prof_get_histogram(uint64_t* buckets);
+
+/**
+ * Retourne le résumé global.
+ */
+void kheap_prof_get_summary(kheap_prof_summary_t* summary);
+
+#endif /* KHEAP_PROF_H */
@@ -0,0 +1,330 @@
+/* src/mm/kmem_cache.c - Caches d'objets typés (slabs avec constructeur) */
+#include "kmem_cache.h"
+#include "pmm.h"
+#include "kheap.h"
+#include "../kernel/klog.h"
+#include "../kernel/thread.h"
+#include "../include/string.h"
+
+/**
+ * En-tête d'un slab, placé au début de ses pages (2^order, alignées sur
+ * leur taille par le buddy) : le slab d'un objet se retrouve par masquage.
+ */
+typedef struct kmem_slab {
+    kmem_cache_t* cache;        /* Cache propriétaire */
+    void* free_list;            /* Objets libres (lien à link_offset) */
+    uint32_t capacity;          /* Nombre d'objets dans le slab */
+    uint32_t in_use;            /* Objets actuellement alloués */
+    struct kmem_slab* next;     /* Slab suivant dans la liste partielle */
+    struct kmem_slab* prev;     /* Slab précédent dans la liste partielle */
+} kmem_slab_t;
+
+struct kmem_cache {
+    char name[KMEM_CACHE_NAME_MAX];
+    size_t object_size;         /* Pas entre deux objets (alignement inclus) */
+    size_t link_offset;         /* Position du lien de free list dans un objet */
+    size_t first_offset;        /* Offset du premier objet dans un slab */
+    size_t slab_size;           /* PMM_BLOCK_SIZE << order */
+    uint32_t order;
+    uint32_t capacity;          /* Objets par slab */
+    kmem_ctor_t ctor;
+    kmem_slab_t* partial;       /* Slabs ayant au moins un objet libre */
+    size_t slab_count;
+    size_t empty_count;         /* Slabs entièrement libres gardés en cache */
+    size_t objects_total;
+    size_t objects_used;
+    spinlock_t lock;
+    struct kmem_cache* next;    /* Liste globale des caches */
+};
+
+/* Liste des caches (pour meminfo) */
+static kmem_cache_t* cache_list = NULL;
+static size_t cache_count = 0;
+static spinlock_t cache_list_lock;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+static inline size_t align_up(size_t value, size_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+static inline void** obj_link(kmem_cache_t* cache, void* obj)
+{
+    return (void**)((uint8_t*)obj + cache->link_offset);
+}
+
+/* Retire un slab de la liste partielle */
+static void slab_unlink(kmem_cache_t* cache, kmem_slab_t* slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        cache->partial = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+/* Ajoute un slab en tête de la liste partielle */
+static void slab_link(kmem_cache_t* cache, kmem_slab_t* slab)
+{
+    slab->prev = NULL;
+    slab->next = cache->partial;
+    if (cache->partial) {
+        cache->partial->prev = slab;
+    }
+    cache->partial = slab;
+}
+
+/**
+ * Crée un slab, construit ses objets et le chaîne (cache->lock tenu).
+ */
+static kmem_slab_t* slab_create(kmem_cache_t* cache)
+{
+    kmem_slab_t* slab = (kmem_slab_t*)pmm_alloc_blocks(1ULL << cache->order);
+    if (slab == NULL) {
+        return NULL;
+    }
+
+    slab->cache = cache;
+    slab->capacity = cache->capacity;
+    slab->in_use = 0;
+    slab->free_list = NULL;
+
+    /* Chaîner en ordre décroissant pour servir les adresses basses d'abord */
+    uint8_t* base = (uint8_t*)slab + cache->first_offset;
+    for (uint32_t i = cache->capacity; i > 0; i--) {
+        void* obj = base + (size_t)(i - 1) * cache->object_size;
+        if (cache->ctor) {
+            cache->ctor(obj);
+        }
+        *obj_link(cache, obj) = slab->free_list;
+        slab->free_list = obj;
+    }
+
+    cache->slab_count++;
+    cache->empty_count++;
+    cache->objects_total += slab->capacity;
+    slab_link(cache, slab);
+
+    return slab;
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_t ctor)
+{
+    if (align == 0) {
+        align = sizeof(void*);
+    }
+    if (size == 0 || (align & (align - 1)) != 0 || align > PMM_BLOCK_SIZE) {
+        return NULL;
+    }
+
+    kmem_cache_t* cache = (kmem_cache_t*)kmalloc(sizeof(kmem_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    memset(cache, 0, sizeof(kmem_cache_t));
+
+    if (name != NULL) {
+        strncpy(cache->name, name, KMEM_CACHE_NAME_MAX - 1);
+    }
+    cache->ctor = ctor;
+
+    /* Avec constructeur, le lien de free list ne doit pas écraser l'état
+     * construit : il est placé derrière l'objet. */
+    if (ctor != NULL) {
+        cache->link_offset = align_up(size, sizeof(void*));
+        size = cache->link_offset + sizeof(void*);
+    } else if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    cache->object_size = align_up(size, align);
+    cache->first_offset = align_up(sizeof(kmem_slab_t), align);
+
+    /* Plus petit slab contenant KMEM_CACHE_MIN_OBJECTS objets */
+    for (uint32_t order = 0; order <= KMEM_CACHE_MAX_ORDER; order++) {
+        size_t slab_size = (size_t)PMM_BLOCK_SIZE << order;
+        size_t capacity = (slab_size - cache->first_offset) / cache->object_size;
+        if (capacity > 0) {
+            cache->order = order;
+            cache->slab_size = slab_size;
+            cache->capacity = (uint32_t)capacity;
+        }
+        if (capacity >= KMEM_CACHE_MIN_OBJECTS) {
+            break;
+        }
+    }
+    if (cache->capacity == 0) {
+        KLOG_ERROR("KMEM", "kmem_cache_create: object too large");
+        kfree(cache);
+        return NULL;
+    }
+
+    spinlock_init(&cache->lock);
+
+    uint64_t irq_flags = spinlock_irqsave(&cache_list_lock);
+    cache->next = cache_list;
+    cache_list = cache;
+    cache_count++;
+    spinlock_irqrestore(&cache_list_lock, irq_flags);
+
+    return cache;
+}
+
+void* kmem_cache_alloc(kmem_cache_t* cache)
+{
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&cache->lock);
+
+    kmem_slab_t* slab = cache->partial;
+    if (slab == NULL) {
+        slab = slab_create(cache);
+        if (slab == NULL) {
+            spinlock_irqrestore(&cache->lock, irq_flags);
+            KLOG_ERROR("KMEM", "kmem_cache_alloc: out of memory");
+            return NULL;
+        }
+    }
+
+    void* obj = slab->free_list;
+    slab->free_list = *obj_link(cache, obj);
+
+    if (slab->in_use == 0) {
+        cache->empty_count--;
+    }
+    slab->in_use++;
+    cache->objects_used++;
+
+    /* Slab plein : il sort de la liste partielle */
+    if (slab->in_use == slab->capacity) {
+        slab_unlink(cache, slab);
+    }
+
+    spinlock_irqrestore(&cache->lock, irq_flags);
+    return obj;
+}
+
+void kmem_cache_free(kmem_cache_t* cache, void* obj)
+{
+    if (cache == NULL || obj == NULL) {
+        return;
+    }
+
+    kmem_slab_t* slab = (kmem_slab_t*)((uintptr_t)obj & ~(uintptr_t)(cache->slab_size - 1));
+    if (slab->cache != cache) {
+        KLOG_ERROR("KMEM", "kmem_cache_free: object does not belong to cache");
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&cache->lock);
+
+    if (slab->in_use == 0) {
+        /* Double free */
+        spinlock_irqrestore(&cache->lock, irq_flags);
+        return;
+    }
+
+    /* Slab plein : il redevient partiel */
+    if (slab->in_use == slab->capacity) {
+        slab_link(cache, slab);
+    }
+
+    *obj_link(cache, obj) = slab->free_list;
+    slab->free_list = obj;
+    slab->in_use--;
+    cache->objects_used--;
+
+    if (slab->in_use == 0) {
+        if (cache->empty_count >= KMEM_CACHE_MAX_EMPTY) {
+            slab_unlink(cache, slab);
+            cache->slab_count--;
+            cache->objects_total -= slab->capacity;
+            slab->cache = NULL;
+            pmm_free_blocks(slab, 1ULL << cache->order);
+        } else {
+            cache->empty_count++;
+        }
+    }
+
+    spinlock_irqrestore(&cache->lock, irq_flags);
+}
+
+void kmem_cache_destroy(kmem_cache_t* cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    if (cache->objects_used != 0) {
+        KLOG_WARN("KMEM", "kmem_cache_destroy: objects still in use");
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&cache_list_lock);
+    kmem_cache_t** link = &cache_list;
+    while (*link != NULL && *link != cache) {
+        link = &(*link)->next;
+    }
+    if (*link == cache) {
+        *link = cache->next;
+        cache_count--;
+    }
+    spinlock_irqrestore(&cache_list_lock, irq_flags);
+
+    /* Plus aucun objet en usage : tous les slabs sont dans la liste partielle */
+    kmem_slab_t* slab = cache->partial;
+    while (slab != NULL) {
+        kmem_slab_t* next = slab->next;
+        slab->cache = NULL;
+        pmm_free_blocks(slab, 1ULL << cache->order);
+        slab = next;
+    }
+
+    kfree(cache);
+}
+
+size_t kmem_cache_count(void)
+{
+    return cache_count;
+}
+
+int kmem_cache_get_stats(size_t index, kmem_cache_stats_t* stats)
+{
+    if (stats == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&cache_list_lock);
+
+    kmem_cache_t* cache = cache_list;
+    for (size_t i = 0; cache != NULL && i < index; i++) {
+        cache = cache->next;
+    }
+    if (cache == NULL) {
+        spinlock_irqrestore(&cache_list_lock, irq_flags);
+        return -1;
+    }
+
+    memcpy(stats->name, cache->name, KMEM_CACHE_NAME_MAX);
+    stats->object_size = cache->object_size;
+    stats->slab_size = cache->slab_size;
+    stats->slab_count = cache->slab_count;
+    stats->objects_total = cache->objects_total;
+    stats->objects_used = cache->objects_used;
+
+    spinlock_irqrestore(&cache_list_lock, irq_flags);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/* src/mm/kmem_cache.h - Caches d'objets typés (slabs avec constructeur) */
+#ifndef KMEM_CACHE_H
+#define KMEM_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ========================================
+ * Types
+ * ======================================== */
+
+/*
+ * Un kmem_cache sert des objets d'un seul type (thread_t, tcp_socket_t...)
+ * depuis des slabs dédiés de 2^n pages physiques. Contrairement aux classes
+ * de taille de kmalloc, un cache :
+ *   - ne mélange pas ses objets avec ceux des autres types, donc le churn
+ *     d'un type ne fragmente pas le heap ;
+ *   - peut avoir un constructeur, appelé une seule fois par objet quand son
+ *     slab est créé. kmem_cache_free attend un objet remis dans son état
+ *     construit (wait queues vides, etc.) : kmem_cache_alloc n'a alors rien
+ *     à réinitialiser.
+ */
+typedef struct kmem_cache kmem_cache_t;
+
+/* Constructeur d'objet (appelé à la création du slab) */
+typedef void (*kmem_ctor_t)(void* obj);
+
+/* Longueur maximale du nom d'un cache (terminateur inclus) */
+#define KMEM_CACHE_NAME_MAX     16
+
+/* Un slab contient au moins ce nombre d'objets (sauf objets énormes) */
+#define KMEM_CACHE_MIN_OBJECTS  8
+
+/* Ordre maximal d'un slab (2^order pages) */
+#define KMEM_CACHE_MAX_ORDER    4
+
+/* Nombre de slabs vides gardés par cache avant rendu au PMM */
+#define KMEM_CACHE_MAX_EMPTY    1
+
+/**
+ * Statistiques d'un cache (commande meminfo).
+ */
+typedef struct {
+    char name[KMEM_CACHE_NAME_MAX];
+    size_t object_size;         /* Taille d'un objet (alignement inclus) */
+    size_t slab_size;           /* Taille d'un slab en octets */
+    size_t slab_count;          /* Slabs alloués */
+    size_t objects_total;       /* Capacité totale (objets) */
+    size_t objects_used;        /* Objets alloués */
+} kmem_cache_stats_t;
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+/**
+ * Crée un cache d'objets.
+ *
+ * @param name   Nom (affiché par meminfo)
+ * @param size   Taille d'un objet en octets
+ * @param align  Alignement (puissance de 2, 0 = 8 octets)
+ * @param ctor   Constructeur optionnel (NULL = objets non initialisés)
+ * @return Le cache, ou NULL si paramètres invalides ou plus de mémoire
+ */
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_t ctor);
+
+/**
+ * Alloue un objet du cache (utilisable en contexte d'interruption).
+ *
+ * @return L'objet (dans son état construit), ou NULL si plus de mémoire
+ */
+void* kmem_cache_alloc(kmem_cache_t* cache);
+
+/**
+ * Rend un objet à son cache. Si le cache a un constructeur, l'objet doit
+ * avoir été remis dans son état construit par l'appelant.
+ */
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+
+/**
+ * Détruit un cache et rend tous ses slabs (aucun objet ne doit être en usage).
+ */
+void kmem_cache_destroy(kmem_cache_t* cache);
+
+/**
+ * Retourne le nombre de caches existants.
+ */
+size_t kmem_cache_count(void);
+
+/**
+ * Retourne les statistiques du index-ième cache.
+ *
+ * @return 0 si succès, -1 si index invalide
+ */
+int kmem_cache_get_stats(size_t index, kmem_cache_stats_t* stats);
+
+#endif /* KMEM_CACHE_H */
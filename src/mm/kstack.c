@@ -0,0 +1,252 @@
+/* src/mm/kstack.c - Stacks kernel avec guard page et pool de recyclage */
+#include "kstack.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "kheap.h"
+#include "../kernel/klog.h"
+#include "../kernel/thread.h"
+#include "../include/memlayout.h"
+
+/* Taille maximale d'une stack servie par la zone (slot moins la guard page) */
+#define KSTACK_MAX_SIZE         (KSTACK_SLOT_SIZE - PAGE_SIZE)
+
+/* Stack libre gardée mappée */
+typedef struct {
+    uint32_t slot;
+    uint32_t size;              /* Octets mappés en haut du slot */
+} kstack_pool_entry_t;
+
+/* Slots occupés (stack allouée ou dans le pool) */
+static uint64_t slot_bitmap[KSTACK_SLOT_COUNT / 64];
+
+static kstack_pool_entry_t pool[KSTACK_POOL_MAX];
+static uint32_t pool_count = 0;
+
+static spinlock_t kstack_lock;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+static inline uint64_t slot_top(uint32_t slot)
+{
+    return KSTACK_VIRT_BASE + (uint64_t)(slot + 1) * KSTACK_SLOT_SIZE;
+}
+
+static inline bool in_zone(uint64_t addr)
+{
+    return addr >= KSTACK_VIRT_BASE && addr < KSTACK_VIRT_END;
+}
+
+/**
+ * Réserve un slot non mappé (kstack_lock tenu).
+ * @return Index du slot, ou -1 si la zone est pleine
+ */
+static int32_t slot_reserve(void)
+{
+    for (uint32_t w = 0; w < KSTACK_SLOT_COUNT / 64; w++) {
+        if (slot_bitmap[w] != ~0ULL) {
+            uint32_t bit = (uint32_t)__builtin_ctzll(~slot_bitmap[w]);
+            slot_bitmap[w] |= 1ULL << bit;
+            return (int32_t)(w * 64 + bit);
+        }
+    }
+    return -1;
+}
+
+static void slot_release(uint32_t slot)
+{
+    uint64_t irq_flags = spinlock_irqsave(&kstack_lock);
+    slot_bitmap[slot / 64] &= ~(1ULL << (slot % 64));
+    spinlock_irqrestore(&kstack_lock, irq_flags);
+}
+
+/* Démappe et rend les pages [from, to) d'un slot */
+static void unmap_pages(uint64_t from, uint64_t to)
+{
+    for (uint64_t addr = from; addr < to; addr += PAGE_SIZE) {
+        uint64_t phys = vmm_get_physical(addr);
+        if (phys != 0) {
+            vmm_unmap_page(addr);
+            pmm_free_block(pmm_phys_to_virt(phys));
+        }
+    }
+}
+
+/**
+ * Mappe des frames fraîches sur [from, to).
+ * @return true si tout est mappé (sinon rien ne reste mappé)
+ */
+static bool map_pages(uint64_t from, uint64_t to)
+{
+    for (uint64_t addr = from; addr < to; addr += PAGE_SIZE) {
+        void* frame = pmm_alloc_block();
+        if (frame == NULL) {
+            unmap_pages(from, addr);
+            return false;
+        }
+
+        uint64_t phys = pmm_virt_to_phys(frame);
+        vmm_map_page(phys, addr, PAGE_PRESENT | PAGE_RW | PAGE_NX);
+
+        /* vmm_map_page échoue silencieusement si une table manque */
+        if (vmm_get_physical(addr) != phys) {
+            pmm_free_block(frame);
+            unmap_pages(from, addr);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Ajuste la partie mappée d'un slot de old_size à new_size octets.
+ */
+static bool slot_resize(uint32_t slot, size_t old_size, size_t new_size)
+{
+    uint64_t top = slot_top(slot);
+
+    if (new_size > old_size) {
+        return map_pages(top - new_size, top - old_size);
+    }
+    unmap_pages(top - old_size, top - new_size);
+    return true;
+}
+
+static void paint(void* base, size_t size)
+{
+    uint64_t* p = (uint64_t*)base;
+    for (size_t i = 0; i < size / sizeof(uint64_t); i++) {
+        p[i] = KSTACK_PAINT;
+    }
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+int kstack_init(void)
+{
+    spinlock_init(&kstack_lock);
+
+    void* stacks[KSTACK_POOL_PREALLOC];
+    for (int i = 0; i < KSTACK_POOL_PREALLOC; i++) {
+        stacks[i] = kstack_alloc(KSTACK_PREALLOC_SIZE);
+        if (stacks[i] == NULL) {
+            KLOG_ERROR("KSTACK", "Failed to map initial kernel stacks");
+            return -1;
+        }
+    }
+    for (int i = 0; i < KSTACK_POOL_PREALLOC; i++) {
+        kstack_free(stacks[i]);
+    }
+
+    KLOG_INFO_DEC("KSTACK", "Kernel stack slots: ", KSTACK_SLOT_COUNT);
+    return 0;
+}
+
+void* kstack_alloc(size_t size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+    size = PAGE_ALIGN_UP(size);
+
+    /* Trop grande pour un slot : heap, sans guard page */
+    if (size > KSTACK_MAX_SIZE) {
+        void* stack = kmalloc(size);
+        if (stack != NULL) {
+            paint(stack, size);
+        }
+        return stack;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&kstack_lock);
+
+    /* Préférer une stack du pool de même taille, sinon la plus récente */
+    int32_t slot = -1;
+    size_t mapped = 0;
+    if (pool_count > 0) {
+        uint32_t pick = pool_count - 1;
+        for (uint32_t i = 0; i < pool_count; i++) {
+            if (pool[i].size == size) {
+                pick = i;
+                break;
+            }
+        }
+        slot = (int32_t)pool[pick].slot;
+        mapped = pool[pick].size;
+        pool[pick] = pool[--pool_count];
+    } else {
+        slot = slot_reserve();
+    }
+
+    spinlock_irqrestore(&kstack_lock, irq_flags);
+
+    if (slot < 0) {
+        KLOG_ERROR("KSTACK", "Kernel stack zone exhausted");
+        return NULL;
+    }
+
+    /* Mapper (ou démapper) hors du lock : vmm_map_page peut allouer */
+    if (mapped != size && !slot_resize((uint32_t)slot, mapped, size)) {
+        unmap_pages(slot_top((uint32_t)slot) - mapped, slot_top((uint32_t)slot));
+        slot_release((uint32_t)slot);
+        KLOG_ERROR("KSTACK", "Out of memory for kernel stack");
+        return NULL;
+    }
+
+    void* base = (void*)(slot_top((uint32_t)slot) - size);
+    paint(base, size);
+    return base;
+}
+
+void kstack_free(void* base)
+{
+    if (base == NULL) {
+        return;
+    }
+
+    uint64_t addr = (uint64_t)base;
+    if (!in_zone(addr)) {
+        kfree(base);
+        return;
+    }
+
+    uint32_t slot = (uint32_t)((addr - KSTACK_VIRT_BASE) / KSTACK_SLOT_SIZE);
+    size_t size = slot_top(slot) - addr;
+
+    uint64_t irq_flags = spinlock_irqsave(&kstack_lock);
+    if (pool_count < KSTACK_POOL_MAX) {
+        pool[pool_count].slot = slot;
+        pool[pool_count].size = (uint32_t)size;
+        pool_count++;
+        spinlock_irqrestore(&kstack_lock, irq_flags);
+        return;
+    }
+    spinlock_irqrestore(&kstack_lock, irq_flags);
+
+    /* Pool plein : rendre les pages puis le slot */
+    unmap_pages(addr, slot_top(slot));
+    slot_release(slot);
+}
+
+size_t kstack_high_water(const void* base, size_t size)
+{
+    if (base == NULL) {
+        return 0;
+    }
+
+    const uint64_t* p = (const uint64_t*)base;
+    size_t words = size / sizeof(uint64_t);
+    size_t untouched = 0;
+    while (untouched < words && p[untouched] == KSTACK_PAINT) {
+        untouched++;
+    }
+    return size - untouched * sizeof(uint64_t);
+}
+
+bool kstack_is_guard(uint64_t addr)
+{
+    return in_zone(addr) && !vmm_is_mapped(addr);
+}
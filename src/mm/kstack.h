@@ -0,0 +1,69 @@
+/* src/mm/kstack.h - Stacks kernel avec guard page et pool de recyclage */
+#ifndef KSTACK_H
+#define KSTACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Les stacks kernel (threads, kernel stacks des processus) ne viennent plus
+ * du heap : chacune occupe le haut d'un slot de la zone KSTACK (memlayout.h)
+ * et le bas du slot reste non mappé. Un débordement touche donc la guard
+ * page (page fault, puis double fault faute de stack) au lieu de corrompre
+ * silencieusement un voisin.
+ *
+ * Les stacks libérées sont gardées mappées dans un petit pool et resservies
+ * telles quelles : le churn de threads (workers, reaper) ne touche ni au
+ * heap ni aux tables de pages.
+ *
+ * Toutes les pages sont mappées à l'allocation : sans IST pour le page
+ * fault, une stack kernel ne peut pas être agrandie à la demande (le CPU
+ * empile la trame d'exception sur la stack fautive).
+ */
+
+/* Stacks libres gardées mappées */
+#define KSTACK_POOL_MAX         16
+
+/* Stacks mappées au boot (crée l'entrée PML4 avant le premier processus) */
+#define KSTACK_POOL_PREALLOC    4
+#define KSTACK_PREALLOC_SIZE    (16 * 1024)
+
+/* Motif écrit dans une stack neuve, pour mesurer sa profondeur maximale */
+#define KSTACK_PAINT            0x4B415453534B4154ULL
+
+/**
+ * Initialise la zone et pré-remplit le pool.
+ * Appelé au boot après kheap_init, avant la création de tout processus.
+ *
+ * @return 0 si succès, -1 si échec
+ */
+int kstack_init(void);
+
+/**
+ * Alloue une stack kernel de size octets (arrondie à la page), remplie
+ * avec KSTACK_PAINT. Au-delà d'un slot moins la guard page, la stack vient
+ * de kmalloc (sans guard page).
+ *
+ * @return Adresse la plus basse de la stack (le sommet est base + size),
+ *         ou NULL si plus de mémoire
+ */
+void* kstack_alloc(size_t size);
+
+/**
+ * Libère une stack obtenue par kstack_alloc.
+ */
+void kstack_free(void* base);
+
+/**
+ * Retourne la profondeur maximale atteinte par une stack (en octets),
+ * mesurée en cherchant le premier mot qui n'a plus le motif KSTACK_PAINT.
+ */
+size_t kstack_high_water(const void* base, size_t size);
+
+/**
+ * Indique si addr tombe dans la guard page d'un slot (débordement de stack).
+ */
+bool kstack_is_guard(uint64_t addr);
+
+#endif /* KSTACK_H */
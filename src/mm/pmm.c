@@ -1,6 +1,8 @@
 /* src/pmm.c - Physical Memory Manager for x86-64 with Limine */
 #include "pmm.h"
 #include "../kernel/klog.h"
+#include "../kernel/thread.h"
+#include "../kernel/sync.h"
 
 /* Symboles définis dans le linker script */
 extern char _kernel_start[];
@@ -13,16 +15,20 @@ extern char _kernel_phys_end[];
  *   - bit = 1 : bloc utilisé/réservé
  *   - bit = 0 : bloc libre
  * 
+ * Le bitmap est stocké en mots de 64 bits : les recherches de séquences
+ * avancent d'un mot à la fois (__builtin_ctzll) et les plages sont
+ * marquées par masques plutôt que bit par bit.
+ * 
  * Pour 4 GiB de RAM : 4 GiB / 4 KiB = 1M blocs = 128 KiB de bitmap
  * Pour 64 GiB de RAM : 64 GiB / 4 KiB = 16M blocs = 2 MiB de bitmap
  * On supporte jusqu'à 4 GiB pour commencer (bitmap de 128 KiB)
  */
 #define PMM_MAX_MEMORY      (4ULL * 1024 * 1024 * 1024)  /* 4 GiB max */
 #define PMM_MAX_BLOCKS      (PMM_MAX_MEMORY / PMM_BLOCK_SIZE)
-#define PMM_BITMAP_SIZE     (PMM_MAX_BLOCKS / PMM_BLOCKS_PER_BYTE)
+#define PMM_BITMAP_WORDS    (PMM_MAX_BLOCKS / 64)
 
 /* Le bitmap statique */
-static uint8_t pmm_bitmap[PMM_BITMAP_SIZE];
+static uint64_t pmm_bitmap[PMM_BITMAP_WORDS];
 
 /* Statistiques */
 static uint64_t pmm_total_blocks = 0;
@@ -36,42 +42,96 @@ static uint64_t pmm_hhdm_offset = 0;
 /*          Fonctions Bitmap internes           */
 /* ============================================ */
 
-/* Marque un bloc comme utilisé */
-static inline void bitmap_set(uint64_t block)
+/* Masque des bits [first, first + count) d'un mot (count de 1 à 64) */
+static inline uint64_t bitmap_word_mask(uint64_t first, uint64_t count)
+{
+    uint64_t mask = (count >= 64) ? ~0ULL : ((1ULL << count) - 1);
+    return mask << first;
+}
+
+/* Nombre de bits à 1 d'un mot (sans libgcc : pas d'appel à __popcountdi2) */
+static inline uint64_t bitmap_popcount(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+/*
+ * Applique une plage de blocs mot par mot.
+ * set = 1 : marque utilisés, set = 0 : marque libres.
+ * 
+ * @return Nombre de blocs dont l'état a effectivement changé
+ */
+static uint64_t bitmap_apply_range(uint64_t start, uint64_t count, int set)
 {
-    if (block < PMM_MAX_BLOCKS) {
-        pmm_bitmap[block / 8] |= (1 << (block % 8));
+    uint64_t changed = 0;
+    
+    while (count > 0) {
+        uint64_t word = start / 64;
+        uint64_t bit = start % 64;
+        uint64_t n = 64 - bit;
+        if (n > count) {
+            n = count;
+        }
+        
+        uint64_t mask = bitmap_word_mask(bit, n);
+        if (set) {
+            changed += bitmap_popcount(mask & ~pmm_bitmap[word]);
+            pmm_bitmap[word] |= mask;
+        } else {
+            changed += bitmap_popcount(mask & pmm_bitmap[word]);
+            pmm_bitmap[word] &= ~mask;
+        }
+        
+        start += n;
+        count -= n;
     }
+    return changed;
 }
 
-/* Marque un bloc comme libre */
-static inline void bitmap_clear(uint64_t block)
+/*
+ * Trouve le premier bloc de [from, end) dont le bit vaut set.
+ * Les mots entièrement dans l'autre état sont sautés d'un coup.
+ * 
+ * @return Index du bloc, ou end si aucun
+ */
+static uint64_t bitmap_find(uint64_t from, uint64_t end, int set)
 {
-    if (block < PMM_MAX_BLOCKS) {
-        pmm_bitmap[block / 8] &= ~(1 << (block % 8));
+    while (from < end) {
+        uint64_t word = pmm_bitmap[from / 64];
+        if (!set) {
+            word = ~word;
+        }
+        word &= ~0ULL << (from % 64);
+        
+        if (word != 0) {
+            uint64_t block = (from & ~63ULL) + (uint64_t)__builtin_ctzll(word);
+            return (block < end) ? block : end;
+        }
+        from = (from & ~63ULL) + 64;
     }
+    return end;
 }
 
-/* Teste si un bloc est utilisé */
-static inline int bitmap_test(uint64_t block)
+/* Borne une plage de blocs à la taille du bitmap */
+static inline uint64_t bitmap_clamp_end(uint64_t start, uint64_t count)
 {
-    if (block >= PMM_MAX_BLOCKS) {
-        return 1; /* Hors limites = considéré comme utilisé */
+    if (start >= PMM_MAX_BLOCKS) {
+        return start;
     }
-    return (pmm_bitmap[block / 8] >> (block % 8)) & 1;
+    return (count > PMM_MAX_BLOCKS - start) ? PMM_MAX_BLOCKS : start + count;
 }
 
 /* Marque une région entière comme utilisée */
 static void pmm_mark_region_used(uint64_t base_addr, uint64_t length)
 {
     uint64_t start_block = PMM_ADDR_TO_BLOCK(base_addr);
-    uint64_t num_blocks = PMM_ALIGN_UP(length) / PMM_BLOCK_SIZE;
+    uint64_t end_block = bitmap_clamp_end(start_block, PMM_ALIGN_UP(length) / PMM_BLOCK_SIZE);
     
-    for (uint64_t i = 0; i < num_blocks; i++) {
-        if (start_block + i < PMM_MAX_BLOCKS && !bitmap_test(start_block + i)) {
-            bitmap_set(start_block + i);
-            pmm_used_blocks++;
-        }
+    if (end_block > start_block) {
+        pmm_used_blocks += bitmap_apply_range(start_block, end_block - start_block, 1);
     }
 }
 
@@ -79,65 +139,218 @@ static void pmm_mark_region_used(uint64_t base_addr, uint64_t length)
 static void pmm_mark_region_free(uint64_t base_addr, uint64_t length)
 {
     uint64_t start_block = PMM_ADDR_TO_BLOCK(base_addr);
-    uint64_t num_blocks = length / PMM_BLOCK_SIZE;
+    uint64_t end_block = bitmap_clamp_end(start_block, length / PMM_BLOCK_SIZE);
     
-    for (uint64_t i = 0; i < num_blocks; i++) {
-        if (start_block + i < PMM_MAX_BLOCKS && bitmap_test(start_block + i)) {
-            bitmap_clear(start_block + i);
-            pmm_used_blocks--;
+    if (end_block > start_block) {
+        pmm_used_blocks -= bitmap_apply_range(start_block, end_block - start_block, 0);
+    }
+}
+
+/* ============================================ */
+/*              Buddy Allocator                 */
+/* ============================================ */
+
+/*
+ * Les blocs libres sont regroupés en blocs "buddy" de 2^order pages,
+ * alignés sur leur taille. Chaque ordre a sa free list doublement
+ * chaînée, dont les noeuds sont stockés dans les pages libres elles-mêmes
+ * (accès via HHDM).
+ *
+ * pmm_head_bitmap marque la première page de chaque bloc libre : on peut
+ * ainsi tester en O(1) si le buddy d'un bloc est libre sans lire une page
+ * qui ne porte pas de noeud. Le bitmap principal reste la référence
+ * "page utilisée/libre" (détection des doubles libérations).
+ */
+typedef struct PmmFreeNode {
+    struct PmmFreeNode* next;
+    struct PmmFreeNode* prev;
+    uint32_t order;
+} PmmFreeNode;
+
+static PmmFreeNode* pmm_free_lists[PMM_BUDDY_ORDER_COUNT];
+static uint64_t pmm_free_counts[PMM_BUDDY_ORDER_COUNT];
+static uint64_t pmm_head_bitmap[PMM_BITMAP_WORDS];
+
+/*
+ * Références supplémentaires par frame (partage copy-on-write).
+ * 0 = un seul propriétaire, le cas courant. Un compteur saturé fait
+ * échouer pmm_ref_block : l'appelant copie alors la page.
+ */
+#define PMM_MAX_EXTRA_REFS  255
+static uint8_t pmm_extra_refs[PMM_MAX_BLOCKS];
+
+/*
+ * Pool de frames déjà mises à zéro (pmm_alloc_zeroed). Les frames sont
+ * allouées (comptées dans pmm_used_blocks) et chaînées par leur premier
+ * mot, remis à zéro quand la frame sort du pool.
+ */
+static uint64_t* pmm_zero_pool = NULL;
+static uint64_t pmm_zero_count = 0;
+
+/* Le thread pagezero attend sur pmm_zero_sem ; pmm_zero_sleeping évite un
+ * sem_post à chaque retrait ou libération quand il travaille déjà */
+static semaphore_t pmm_zero_sem;
+static volatile bool pmm_zero_sleeping = false;
+
+/* Callbacks de manque de mémoire (pmm_register_pressure_hook) */
+typedef struct {
+    uint64_t threshold;
+    pmm_pressure_hook_t hook;
+} PmmPressureHook;
+
+static PmmPressureHook pmm_pressure_hooks[PMM_PRESSURE_HOOKS_MAX];
+static uint32_t pmm_pressure_hook_count = 0;
+
+/* Protège le bitmap, les free lists, le pool zéro et les compteurs */
+static spinlock_t pmm_lock;
+
+static inline PmmFreeNode* buddy_node(uint64_t block)
+{
+    return (PmmFreeNode*)(PMM_BLOCK_TO_ADDR(block) + pmm_hhdm_offset);
+}
+
+static inline uint64_t buddy_block(PmmFreeNode* node)
+{
+    return PMM_ADDR_TO_BLOCK((uint64_t)node - pmm_hhdm_offset);
+}
+
+/* Ajoute un bloc libre de 2^order pages en tête de sa free list */
+static void buddy_push(uint64_t block, uint32_t order)
+{
+    PmmFreeNode* node = buddy_node(block);
+    node->order = order;
+    node->prev = NULL;
+    node->next = pmm_free_lists[order];
+    if (node->next != NULL) {
+        node->next->prev = node;
+    }
+    pmm_free_lists[order] = node;
+    pmm_free_counts[order]++;
+    pmm_head_bitmap[block / 64] |= 1ULL << (block % 64);
+}
+
+/* Retire un bloc libre de sa free list */
+static void buddy_unlink(uint64_t block, uint32_t order)
+{
+    PmmFreeNode* node = buddy_node(block);
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        pmm_free_lists[order] = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    pmm_free_counts[order]--;
+    pmm_head_bitmap[block / 64] &= ~(1ULL << (block % 64));
+}
+
+/* Le bloc est-il la tête d'un bloc libre d'ordre order ? */
+static inline int buddy_is_free_head(uint64_t block, uint32_t order)
+{
+    if (block >= pmm_total_blocks) {
+        return 0;
+    }
+    if (!((pmm_head_bitmap[block / 64] >> (block % 64)) & 1)) {
+        return 0;
+    }
+    return buddy_node(block)->order == order;
+}
+
+/* Rend un bloc de 2^order pages en fusionnant avec ses buddies libres */
+static void buddy_release(uint64_t block, uint32_t order)
+{
+    while (order < PMM_BUDDY_MAX_ORDER) {
+        uint64_t buddy = block ^ (1ULL << order);
+        if (!buddy_is_free_head(buddy, order)) {
+            break;
         }
+        buddy_unlink(buddy, order);
+        block &= ~(1ULL << order);
+        order++;
     }
+    buddy_push(block, order);
 }
 
-/* Trouve le premier bloc libre dans le bitmap */
-static int64_t pmm_find_first_free(void)
+/* Rend une plage quelconque de pages, découpée en blocs alignés */
+static void buddy_release_range(uint64_t start, uint64_t count)
 {
-    uint64_t bitmap_bytes = pmm_total_blocks / 8;
-    if (bitmap_bytes > PMM_BITMAP_SIZE) bitmap_bytes = PMM_BITMAP_SIZE;
-    
-    for (uint64_t i = 0; i < bitmap_bytes; i++) {
-        if (pmm_bitmap[i] != 0xFF) {
-            /* Au moins un bit est à 0 dans cet octet */
-            for (int j = 0; j < 8; j++) {
-                if (!(pmm_bitmap[i] & (1 << j))) {
-                    uint64_t block = i * 8 + j;
-                    if (block < pmm_total_blocks) {
-                        return (int64_t)block;
-                    }
-                }
-            }
+    while (count > 0) {
+        uint32_t order = 0;
+        while (order < PMM_BUDDY_MAX_ORDER &&
+               !(start & (1ULL << order)) &&
+               (2ULL << order) <= count) {
+            order++;
         }
+        buddy_release(start, order);
+        start += 1ULL << order;
+        count -= 1ULL << order;
     }
-    return -1; /* Aucun bloc libre trouvé */
 }
 
-/* Trouve une séquence de blocs libres contigus */
-static int64_t pmm_find_first_free_sequence(uint64_t count)
+/* Prend un bloc de 2^order pages, en découpant un bloc plus grand si besoin */
+static int64_t buddy_take(uint32_t order)
 {
-    if (count == 0) return -1;
-    if (count == 1) return pmm_find_first_free();
-    
-    uint64_t consecutive = 0;
-    uint64_t start_block = 0;
+    uint32_t o = order;
+    while (o <= PMM_BUDDY_MAX_ORDER && pmm_free_lists[o] == NULL) {
+        o++;
+    }
+    if (o > PMM_BUDDY_MAX_ORDER) {
+        return -1;
+    }
+
+    uint64_t block = buddy_block(pmm_free_lists[o]);
+    buddy_unlink(block, o);
+
+    /* Remettre les moitiés hautes inutilisées dans les ordres inférieurs */
+    while (o > order) {
+        o--;
+        buddy_push(block + (1ULL << o), o);
+    }
+    return (int64_t)block;
+}
+
+/* Plus petit ordre dont le bloc contient count pages */
+static inline uint32_t buddy_order_for(uint64_t count)
+{
+    uint32_t order = 0;
+    while ((1ULL << order) < count) {
+        order++;
+    }
+    return order;
+}
+
+/* Construit les free lists à partir des pages libres du bitmap */
+static void buddy_build_from_bitmap(void)
+{
+    uint64_t block = 0;
     
-    for (uint64_t block = 0; block < pmm_total_blocks; block++) {
-        if (!bitmap_test(block)) {
-            /* Bloc libre trouvé */
-            if (consecutive == 0) {
-                start_block = block;
-            }
-            consecutive++;
-            
-            if (consecutive >= count) {
-                return (int64_t)start_block;
-            }
-        } else {
-            /* Bloc occupé, reset du compteur */
-            consecutive = 0;
-        }
+    while ((block = bitmap_find(block, pmm_total_blocks, 0)) < pmm_total_blocks) {
+        uint64_t run_end = bitmap_find(block, pmm_total_blocks, 1);
+        buddy_release_range(block, run_end - block);
+        block = run_end;
+    }
+}
+
+/*
+ * Rend les séquences de blocs effectivement utilisés (pmm_lock tenu) :
+ * un bloc déjà libre (double libération) ou hors limites est ignoré.
+ */
+static void pmm_free_range_locked(uint64_t start_block, uint64_t count)
+{
+    uint64_t end_block = start_block + count;
+    if (end_block > pmm_total_blocks || end_block < start_block) {
+        end_block = pmm_total_blocks;
     }
     
-    return -1; /* Pas assez de blocs contigus */
+    uint64_t block = start_block;
+    while ((block = bitmap_find(block, end_block, 1)) < end_block) {
+        uint64_t run_end = bitmap_find(block, end_block, 0);
+        bitmap_apply_range(block, run_end - block, 0);
+        pmm_used_blocks -= run_end - block;
+        buddy_release_range(block, run_end - block);
+        block = run_end;
+    }
 }
 
 /* ============================================ */
@@ -174,8 +387,8 @@ void init_pmm_limine(struct limine_memmap_response *memmap, uint64_t hhdm_offset
     pmm_used_blocks = pmm_total_blocks; /* Par défaut, tout est marqué utilisé */
     
     /* Initialiser le bitmap : tous les blocs sont marqués comme utilisés (1) */
-    for (uint64_t i = 0; i < PMM_BITMAP_SIZE; i++) {
-        pmm_bitmap[i] = 0xFF;
+    for (uint64_t i = 0; i < PMM_BITMAP_WORDS; i++) {
+        pmm_bitmap[i] = ~0ULL;
     }
 
     /* Parser la memory map Limine et libérer les régions utilisables */
@@ -219,26 +432,194 @@ void init_pmm_limine(struct limine_memmap_response *memmap, uint64_t hhdm_offset
      */
     pmm_mark_region_used(0, 0x100000);
     
+    /* Répartir les pages libres dans les free lists du buddy allocator */
+    spinlock_init(&pmm_lock);
+    for (uint32_t order = 0; order < PMM_BUDDY_ORDER_COUNT; order++) {
+        pmm_free_lists[order] = NULL;
+        pmm_free_counts[order] = 0;
+    }
+    buddy_build_from_bitmap();
+    
     KLOG_INFO_DEC("PMM", "Total blocks: ", (uint32_t)pmm_total_blocks);
     KLOG_INFO_DEC("PMM", "Used blocks: ", (uint32_t)pmm_used_blocks);
 }
 
+/**
+ * Appelle les callbacks dont le seuil est passé (pmm_lock relâché : ils
+ * peuvent réveiller un thread ou armer un timer).
+ */
+static void pmm_pressure_notify(uint64_t free_blocks)
+{
+    for (uint32_t i = 0; i < pmm_pressure_hook_count; i++) {
+        if (free_blocks < pmm_pressure_hooks[i].threshold) {
+            pmm_pressure_hooks[i].hook();
+        }
+    }
+}
+
+int pmm_register_pressure_hook(uint64_t threshold, pmm_pressure_hook_t hook)
+{
+    if (hook == NULL || pmm_pressure_hook_count >= PMM_PRESSURE_HOOKS_MAX) {
+        return -1;
+    }
+    
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    pmm_pressure_hooks[pmm_pressure_hook_count].threshold = threshold;
+    pmm_pressure_hooks[pmm_pressure_hook_count].hook = hook;
+    pmm_pressure_hook_count++;
+    spinlock_irqrestore(&pmm_lock, flags);
+    return 0;
+}
+
+/**
+ * Le pool zéro est-il à recharger (sous son seuil bas, avec assez de
+ * mémoire libre pour le faire) ?
+ */
+static inline bool zero_pool_wants_refill(void)
+{
+    return pmm_zero_count < PMM_ZERO_POOL_LOW &&
+           pmm_total_blocks - pmm_used_blocks > PMM_ZERO_POOL_MIN_FREE;
+}
+
+/**
+ * Réveille le thread pagezero s'il dort et que le pool est à recharger.
+ */
+static void zero_pool_kick(void)
+{
+    if (pmm_zero_sleeping && zero_pool_wants_refill()) {
+        pmm_zero_sleeping = false;
+        sem_post(&pmm_zero_sem);
+    }
+}
+
+/**
+ * Retire une frame du pool zéro.
+ * @return Frame entièrement à zéro, ou NULL si le pool est vide
+ */
+static void* zero_pool_pop(void)
+{
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    
+    uint64_t* frame = pmm_zero_pool;
+    if (frame != NULL) {
+        pmm_zero_pool = (uint64_t*)frame[0];
+        pmm_zero_count--;
+    }
+    
+    spinlock_irqrestore(&pmm_lock, flags);
+    
+    if (frame != NULL) {
+        frame[0] = 0;
+        zero_pool_kick();
+    }
+    return frame;
+}
+
 void* pmm_alloc_block(void)
 {
-    if (pmm_used_blocks >= pmm_total_blocks) {
-        return NULL; /* Plus de mémoire disponible */
+    void* block = pmm_alloc_blocks(1);
+    
+    /* Mémoire épuisée : puiser dans le pool zéro plutôt qu'échouer */
+    if (block == NULL) {
+        block = zero_pool_pop();
     }
+    return block;
+}
 
-    int64_t block = pmm_find_first_free();
-    if (block < 0) {
-        return NULL; /* Aucun bloc libre trouvé */
+void* pmm_alloc_zeroed(void)
+{
+    void* block = zero_pool_pop();
+    if (block != NULL) {
+        return block;
+    }
+    
+    block = pmm_alloc_blocks(1);
+    if (block == NULL) {
+        return NULL;
     }
+    
+    uint64_t* p = (uint64_t*)block;
+    for (uint64_t i = 0; i < PMM_BLOCK_SIZE / sizeof(uint64_t); i++) {
+        p[i] = 0;
+    }
+    return block;
+}
 
-    bitmap_set((uint64_t)block);
-    pmm_used_blocks++;
+uint64_t pmm_zero_pool_refill(uint64_t max)
+{
+    uint64_t added = 0;
+    
+    while (added < max && pmm_zero_count < PMM_ZERO_POOL_TARGET &&
+           pmm_get_free_blocks() > PMM_ZERO_POOL_MIN_FREE) {
+        uint64_t* frame = (uint64_t*)pmm_alloc_blocks(1);
+        if (frame == NULL) {
+            break;
+        }
+        
+        /* Mise à zéro hors du lock */
+        for (uint64_t i = 0; i < PMM_BLOCK_SIZE / sizeof(uint64_t); i++) {
+            frame[i] = 0;
+        }
+        
+        uint64_t flags = spinlock_irqsave(&pmm_lock);
+        frame[0] = (uint64_t)pmm_zero_pool;
+        pmm_zero_pool = frame;
+        pmm_zero_count++;
+        spinlock_irqrestore(&pmm_lock, flags);
+        
+        added++;
+    }
+    
+    return added;
+}
 
-    /* Retourne l'adresse virtuelle via HHDM */
-    return (void*)(PMM_BLOCK_TO_ADDR(block) + pmm_hhdm_offset);
+uint64_t pmm_get_zeroed_count(void)
+{
+    return pmm_zero_count;
+}
+
+/**
+ * Thread de fond : garde le pool zéro rempli pendant que le CPU est
+ * libre. Il tourne en priorité IDLE, donc uniquement quand aucun autre
+ * thread n'est prêt, cède le CPU entre deux lots et dort sur
+ * pmm_zero_sem une fois le pool plein.
+ */
+static void pmm_zero_thread_func(void* arg)
+{
+    (void)arg;
+    
+    for (;;) {
+        while (pmm_zero_pool_refill(PMM_ZERO_BATCH) > 0) {
+            thread_yield();
+        }
+        
+        /* Revérifier après avoir levé le drapeau : un retrait entre la
+         * fin du remplissage et ici n'a pas pu nous réveiller */
+        pmm_zero_sleeping = true;
+        if (zero_pool_wants_refill()) {
+            pmm_zero_sleeping = false;
+            continue;
+        }
+        sem_wait(&pmm_zero_sem);
+    }
+}
+
+void pmm_zero_thread_init(void)
+{
+    semaphore_init(&pmm_zero_sem, 0, 1);
+    
+    thread_t* thread = thread_create("pagezero", pmm_zero_thread_func, NULL,
+                                     THREAD_DEFAULT_STACK_SIZE,
+                                     THREAD_PRIORITY_IDLE);
+    if (thread == NULL) {
+        KLOG_ERROR("PMM", "Failed to create page zeroing thread");
+        return;
+    }
+    
+    /* Nice maximal : ne jamais passer devant un autre thread */
+    thread_set_nice(thread, 19);
+    
+    KLOG_INFO("PMM", "Page zeroing thread started");
 }
 
 void* pmm_alloc_blocks(uint64_t count)
@@ -247,39 +628,92 @@ void* pmm_alloc_blocks(uint64_t count)
         return NULL;
     }
     
-    if (count == 1) {
-        return pmm_alloc_block();
+    uint32_t order = buddy_order_for(count);
+    if (order > PMM_BUDDY_MAX_ORDER) {
+        return NULL; /* Plus grand que le plus grand bloc buddy */
     }
     
-    int64_t start_block = pmm_find_first_free_sequence(count);
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    
+    int64_t start_block = buddy_take(order);
     if (start_block < 0) {
+        spinlock_irqrestore(&pmm_lock, flags);
         return NULL; /* Pas assez de blocs contigus */
     }
     
-    /* Marquer tous les blocs comme utilisés */
-    for (uint64_t i = 0; i < count; i++) {
-        bitmap_set((uint64_t)start_block + i);
-        pmm_used_blocks++;
+    /* Marquer les blocs demandés comme utilisés */
+    bitmap_apply_range((uint64_t)start_block, count, 1);
+    pmm_used_blocks += count;
+    
+    /* Rendre la fin du bloc 2^order si count n'est pas une puissance de 2 */
+    if ((1ULL << order) > count) {
+        buddy_release_range((uint64_t)start_block + count, (1ULL << order) - count);
     }
     
+    uint64_t free_blocks = pmm_total_blocks - pmm_used_blocks;
+    spinlock_irqrestore(&pmm_lock, flags);
+    
+    pmm_pressure_notify(free_blocks);
+    
     /* Retourne l'adresse virtuelle via HHDM */
     return (void*)(PMM_BLOCK_TO_ADDR(start_block) + pmm_hhdm_offset);
 }
 
 void pmm_free_block(void* p)
 {
-    /* Convertir l'adresse virtuelle en adresse physique */
-    uint64_t addr = (uint64_t)p - pmm_hhdm_offset;
-    uint64_t block = PMM_ADDR_TO_BLOCK(addr);
+    if (p == NULL) {
+        return;
+    }
+    
+    uint64_t block = PMM_ADDR_TO_BLOCK((uint64_t)p - pmm_hhdm_offset);
+    
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    if (block < pmm_total_blocks && pmm_extra_refs[block] > 0) {
+        /* Frame partagée : retirer seulement une référence */
+        pmm_extra_refs[block]--;
+    } else {
+        pmm_free_range_locked(block, 1);
+    }
+    spinlock_irqrestore(&pmm_lock, flags);
+    
+    /* Mémoire revenue au-dessus du plancher : le pool peut se recharger */
+    zero_pool_kick();
+}
 
-    if (block >= pmm_total_blocks) {
-        return; /* Adresse invalide */
+int pmm_ref_block(void* p)
+{
+    uint64_t block = PMM_ADDR_TO_BLOCK((uint64_t)p - pmm_hhdm_offset);
+    if (p == NULL || block >= pmm_total_blocks) {
+        return -1;
     }
+    
+    int result = -1;
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    if (bitmap_find(block, block + 1, 1) == block &&
+        pmm_extra_refs[block] < PMM_MAX_EXTRA_REFS) {
+        pmm_extra_refs[block]++;
+        result = 0;
+    }
+    spinlock_irqrestore(&pmm_lock, flags);
+    
+    return result;
+}
 
-    if (bitmap_test(block)) {
-        bitmap_clear(block);
-        pmm_used_blocks--;
+uint32_t pmm_get_block_refs(void* p)
+{
+    uint64_t block = PMM_ADDR_TO_BLOCK((uint64_t)p - pmm_hhdm_offset);
+    if (p == NULL || block >= pmm_total_blocks) {
+        return 0;
+    }
+    
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    uint32_t refs = 0;
+    if (bitmap_find(block, block + 1, 1) == block) {
+        refs = 1 + pmm_extra_refs[block];
     }
+    spinlock_irqrestore(&pmm_lock, flags);
+    
+    return refs;
 }
 
 void pmm_free_blocks(void* p, uint64_t count)
@@ -292,13 +726,9 @@ void pmm_free_blocks(void* p, uint64_t count)
     uint64_t addr = (uint64_t)p - pmm_hhdm_offset;
     uint64_t start_block = PMM_ADDR_TO_BLOCK(addr);
     
-    for (uint64_t i = 0; i < count; i++) {
-        uint64_t block = start_block + i;
-        if (block < pmm_total_blocks && bitmap_test(block)) {
-            bitmap_clear(block);
-            pmm_used_blocks--;
-        }
-    }
+    uint64_t flags = spinlock_irqsave(&pmm_lock);
+    pmm_free_range_locked(start_block, count);
+    spinlock_irqrestore(&pmm_lock, flags);
 }
 
 uint64_t pmm_get_total_blocks(void)
@@ -321,6 +751,14 @@ uint64_t pmm_get_free_memory(void)
     return pmm_get_free_blocks() * PMM_BLOCK_SIZE;
 }
 
+uint64_t pmm_get_free_count_by_order(uint32_t order)
+{
+    if (order > PMM_BUDDY_MAX_ORDER) {
+        return 0;
+    }
+    return pmm_free_counts[order];
+}
+
 void* pmm_phys_to_virt(uint64_t phys)
 {
     return (void*)(phys + pmm_hhdm_offset);
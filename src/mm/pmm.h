@@ -10,6 +10,19 @@
 #define PMM_BLOCK_SIZE      4096ULL
 #define PMM_BLOCKS_PER_BYTE 8
 
+/* Ordre maximal du buddy allocator : blocs de 2^10 pages = 4 MiB */
+#define PMM_BUDDY_MAX_ORDER     10
+#define PMM_BUDDY_ORDER_COUNT   (PMM_BUDDY_MAX_ORDER + 1)
+
+/* Pool de frames pré-zéroées (pmm_alloc_zeroed) */
+#define PMM_ZERO_POOL_TARGET    256     /* Frames gardées prêtes (1 MiB) */
+#define PMM_ZERO_POOL_LOW       128     /* Réveil du thread sous ce seuil */
+#define PMM_ZERO_POOL_MIN_FREE  4096    /* Ne pas remplir sous 16 MiB libres */
+#define PMM_ZERO_BATCH          16      /* Frames zéroées entre deux yields */
+
+/* Callbacks de manque de mémoire (pmm_register_pressure_hook) */
+#define PMM_PRESSURE_HOOKS_MAX  4
+
 /* Aligne une adresse vers le haut au prochain bloc */
 #define PMM_ALIGN_UP(addr)   (((addr) + PMM_BLOCK_SIZE - 1) & ~(PMM_BLOCK_SIZE - 1))
 /* Aligne une adresse vers le bas au bloc précédent */
@@ -36,21 +49,90 @@ void init_pmm_limine(struct limine_memmap_response *memmap, uint64_t hhdm_offset
  */
 void* pmm_alloc_block(void);
 
+/**
+ * Alloue un bloc de 4 KiB déjà rempli de zéros.
+ * 
+ * Le bloc vient du pool entretenu par le thread "pagezero" pendant que le
+ * CPU est libre ; si le pool est vide, il est alloué et mis à zéro sur
+ * place. Libération par pmm_free_block.
+ * 
+ * @return Adresse du bloc (via HHDM), ou NULL si plus de mémoire
+ */
+void* pmm_alloc_zeroed(void);
+
+/**
+ * Ajoute au plus max frames zéroées au pool (jusqu'à PMM_ZERO_POOL_TARGET,
+ * et seulement si plus de PMM_ZERO_POOL_MIN_FREE blocs sont libres).
+ * 
+ * @return Nombre de frames ajoutées
+ */
+uint64_t pmm_zero_pool_refill(uint64_t max);
+
+/**
+ * Retourne le nombre de frames disponibles dans le pool zéro.
+ */
+uint64_t pmm_get_zeroed_count(void);
+
+/**
+ * Démarre le thread de fond qui remplit le pool zéro. Il dort tant que le
+ * pool reste au-dessus de PMM_ZERO_POOL_LOW (ou que la mémoire libre est
+ * sous PMM_ZERO_POOL_MIN_FREE) : les retraits du pool et les libérations
+ * de frames le réveillent.
+ * Appelé une fois le scheduler démarré.
+ */
+void pmm_zero_thread_init(void);
+
 /**
  * Alloue plusieurs blocs contigus de mémoire physique.
  * 
+ * Le buddy allocator sert un bloc de 2^order pages (order = log2 de count
+ * arrondi au-dessus) en O(log n), puis rend immédiatement les pages
+ * au-delà de count. count est limité à 2^PMM_BUDDY_MAX_ORDER pages.
+ * 
  * @param count Nombre de blocs de 4 KiB à allouer
  * @return Adresse physique du premier bloc, ou NULL si pas assez de mémoire contiguë
  */
 void* pmm_alloc_blocks(uint64_t count);
 
+/**
+ * Callback appelé après une allocation qui laisse la mémoire libre sous
+ * son seuil. Contexte quelconque (IRQ compris), sans verrou du PMM : il
+ * doit seulement réveiller un thread ou armer un timer, sans allouer.
+ */
+typedef void (*pmm_pressure_hook_t)(void);
+
+/**
+ * Enregistre un callback de manque de mémoire : il est appelé à chaque
+ * allocation tant que les blocs libres restent sous threshold (il filtre
+ * lui-même les appels répétés). Permet de réveiller un reclaim à la
+ * demande plutôt que de surveiller la mémoire par polling.
+ * 
+ * @return 0 si succès, -1 si hook NULL ou plus de place
+ */
+int pmm_register_pressure_hook(uint64_t threshold, pmm_pressure_hook_t hook);
+
 /**
  * Libère un bloc de mémoire physique précédemment alloué.
+ * Si le bloc est partagé (pmm_ref_block), seule une référence est retirée.
  * 
  * @param p Adresse physique du bloc à libérer (doit être alignée sur 4 KiB)
  */
 void pmm_free_block(void* p);
 
+/**
+ * Ajoute une référence à un bloc alloué (partage copy-on-write).
+ * Chaque référence est rendue par un pmm_free_block.
+ * 
+ * @param p Adresse du bloc (via HHDM)
+ * @return 0 si succès, -1 si bloc libre/invalide ou compteur saturé
+ */
+int pmm_ref_block(void* p);
+
+/**
+ * Retourne le nombre de propriétaires d'un bloc (0 si libre).
+ */
+uint32_t pmm_get_block_refs(void* p);
+
 /**
  * Libère plusieurs blocs contigus de mémoire physique.
  * 
@@ -79,6 +161,13 @@ uint64_t pmm_get_free_blocks(void);
  */
 uint64_t pmm_get_free_memory(void);
 
+/**
+ * Retourne le nombre de blocs libres de 2^order pages dans le buddy allocator.
+ * 
+ * @param order Ordre (0 à PMM_BUDDY_MAX_ORDER)
+ */
+uint64_t pmm_get_free_count_by_order(uint32_t order);
+
 /**
  * Convertit une adresse physique en adresse virtuelle (via HHDM).
  */
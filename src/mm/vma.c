@@ -0,0 +1,495 @@
+/* src/mm/vma.c - Virtual Memory Areas (mappings paresseux) */
+#include "vma.h"
+#include "pmm.h"
+#include "kheap.h"
+#include "zram.h"
+#include "../drivers/virtio/virtio_balloon.h"
+#include "../kernel/klog.h"
+#include "../kernel/thread.h"
+#include "../include/string.h"
+
+/* Protège les listes de VMAs (le page fault handler les lit aussi) */
+static spinlock_t vma_lock;
+
+/* Espaces d'adressage user parcourus par vma_reclaim (vma_lock tenu) */
+static page_directory_t* reclaim_list = NULL;
+static page_directory_t* reclaim_hand = NULL;  /* Prochain espace examiné */
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+/**
+ * Trouve la VMA contenant addr (vma_lock tenu).
+ */
+static vma_t* vma_find_locked(page_directory_t* dir, uint64_t addr)
+{
+    for (vma_t* vma = dir->vmas; vma != NULL; vma = vma->next) {
+        if (addr < vma->start) {
+            break;  /* Liste triée : inutile d'aller plus loin */
+        }
+        if (addr < vma->end) {
+            return vma;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Alloue une frame, la met à zéro (ou y décompresse la page swappée
+ * dans zram) et la mappe (vma_lock tenu).
+ */
+static int vma_populate_locked(page_directory_t* dir, vma_t* vma, uint64_t addr)
+{
+    uint64_t page = PAGE_ALIGN_DOWN(addr);
+
+    if (vmm_get_phys_addr(dir, page) != 0) {
+        return 0;  /* Déjà présente */
+    }
+
+    uint64_t pte = vmm_get_pte_in_dir(dir, page);
+    bool swapped = (pte & PAGE_SWAPPED) != 0;
+
+    void* frame = swapped ? pmm_alloc_block() : pmm_alloc_zeroed();
+    if (frame == NULL) {
+        KLOG_ERROR("VMA", "Out of physical memory on demand fault");
+        return -1;
+    }
+    if (swapped && zram_load(ZRAM_PTE_SLOT(pte), frame) != 0) {
+        pmm_free_block(frame);
+        return -1;
+    }
+
+    uint64_t phys = pmm_virt_to_phys(frame);
+    vmm_map_page_in_dir(dir, phys, page, vma->flags | PAGE_PRESENT);
+
+    /* vmm_map_page échoue silencieusement si une table manque */
+    if (vmm_get_phys_addr(dir, page) != phys) {
+        pmm_free_block(frame);
+        return -1;
+    }
+
+    /* La PTE ne référence plus le slot */
+    if (swapped) {
+        zram_free(ZRAM_PTE_SLOT(pte));
+    }
+
+    return 0;
+}
+
+/**
+ * Rend la frame, ou le slot zram, d'une page de VMA.
+ * clear : effacer aussi la PTE (sinon les tables vont être libérées).
+ */
+static void page_release(page_directory_t* dir, uint64_t addr, bool clear)
+{
+    uint64_t phys = vmm_get_phys_addr(dir, addr);
+    if (phys != 0) {
+        if (clear) {
+            vmm_unmap_page_in_dir(dir, addr);
+        }
+        pmm_free_block(pmm_phys_to_virt(phys));
+        return;
+    }
+
+    uint64_t pte = vmm_get_pte_in_dir(dir, addr);
+    if (pte & PAGE_SWAPPED) {
+        if (clear) {
+            vmm_set_pte_in_dir(dir, addr, 0);
+        }
+        zram_free(ZRAM_PTE_SLOT(pte));
+    }
+}
+
+/**
+ * Examine une page pour le reclaim (vma_lock tenu) : une page accédée
+ * depuis le dernier passage perd son bit Accessed (seconde chance), une
+ * page froide non partagée est compressée dans zram.
+ *
+ * @return true si la frame a été rendue au PMM
+ */
+static bool reclaim_page(page_directory_t* dir, uint64_t addr)
+{
+    uint64_t pte = vmm_get_pte_in_dir(dir, addr);
+    if (!(pte & PAGE_PRESENT)) {
+        return false;
+    }
+
+    if (pte & PAGE_ACCESSED) {
+        vmm_set_pte_in_dir(dir, addr, pte & ~PAGE_ACCESSED);
+        return false;
+    }
+
+    /* Frame partagée (copy-on-write) ou épinglée par une écriture du
+     * kernel (vmm_copy_to_dir) : la laisser */
+    void* frame = pmm_phys_to_virt(pte & PAGE_FRAME_MASK);
+    if (pmm_get_block_refs(frame) != 1) {
+        return false;
+    }
+
+    uint32_t slot;
+    if (zram_store(frame, &slot) != 0) {
+        return false;
+    }
+
+    vmm_set_pte_in_dir(dir, addr, ZRAM_PTE(slot));
+    pmm_free_block(frame);
+    return true;
+}
+
+/**
+ * Avance l'horloge dans un espace d'adressage (vma_lock tenu).
+ * @return true si la fin de l'espace est atteinte
+ */
+static bool reclaim_directory(page_directory_t* dir, size_t target,
+                              size_t* budget, size_t* reclaimed)
+{
+    for (vma_t* vma = dir->vmas; vma != NULL; vma = vma->next) {
+        /* Seulement la mémoire anonyme user */
+        if (vma->end <= dir->reclaim_cursor || !(vma->flags & PAGE_USER)) {
+            continue;
+        }
+
+        uint64_t addr = (vma->start > dir->reclaim_cursor) ? vma->start : dir->reclaim_cursor;
+        for (; addr < vma->end; addr += PAGE_SIZE) {
+            if (*budget == 0 || *reclaimed >= target) {
+                dir->reclaim_cursor = addr;
+                return false;
+            }
+            (*budget)--;
+            if (reclaim_page(dir, addr)) {
+                (*reclaimed)++;
+            }
+        }
+    }
+
+    dir->reclaim_cursor = 0;
+    return true;
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+int vma_reserve(page_directory_t* dir, uint64_t start, uint64_t size, uint64_t flags)
+{
+    if (dir == NULL || size == 0) {
+        return -1;
+    }
+
+    uint64_t end = PAGE_ALIGN_UP(start + size);
+    start = PAGE_ALIGN_DOWN(start);
+
+    /* Allouer hors du lock : kmalloc peut étendre le heap */
+    vma_t* vma = (vma_t*)kmalloc(sizeof(vma_t));
+    if (vma == NULL) {
+        return -1;
+    }
+    vma->start = start;
+    vma->end = end;
+    vma->flags = flags & ~PAGE_PRESENT;
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    /* Trouver la position d'insertion et refuser les chevauchements */
+    vma_t* prev = NULL;
+    vma_t** link = &dir->vmas;
+    while (*link != NULL && (*link)->end <= start) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    if (*link != NULL && (*link)->start < end) {
+        spinlock_irqrestore(&vma_lock, irq_flags);
+        kfree(vma);
+        return -1;
+    }
+
+    /* Prolonger la VMA précédente si elle est contiguë (croissance de brk) */
+    if (prev != NULL && prev->end == start && prev->flags == vma->flags) {
+        prev->end = end;
+        spinlock_irqrestore(&vma_lock, irq_flags);
+        kfree(vma);
+        return 0;
+    }
+
+    vma->next = *link;
+    *link = vma;
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+    return 0;
+}
+
+int vma_unmap(page_directory_t* dir, uint64_t start, uint64_t size)
+{
+    if (dir == NULL || size == 0) {
+        return -1;
+    }
+
+    uint64_t end = PAGE_ALIGN_UP(start + size);
+    start = PAGE_ALIGN_DOWN(start);
+
+    /* Une VMA coupée en deux a besoin d'un nœud de plus : l'allouer hors du lock */
+    vma_t* spare = (vma_t*)kmalloc(sizeof(vma_t));
+    if (spare == NULL) {
+        return -1;
+    }
+    vma_t* removed = NULL;
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    vma_t** link = &dir->vmas;
+    while (*link != NULL && (*link)->start < end) {
+        vma_t* vma = *link;
+        if (vma->end <= start) {
+            link = &vma->next;
+            continue;
+        }
+
+        /* Rendre les frames peuplées (ou compressées) de l'intersection */
+        uint64_t from = (start > vma->start) ? start : vma->start;
+        uint64_t to = (end < vma->end) ? end : vma->end;
+        for (uint64_t addr = from; addr < to; addr += PAGE_SIZE) {
+            page_release(dir, addr, true);
+        }
+
+        if (start <= vma->start && end >= vma->end) {
+            /* Entièrement couverte : la retirer (libérée hors du lock) */
+            *link = vma->next;
+            vma->next = removed;
+            removed = vma;
+        } else if (start > vma->start && end < vma->end) {
+            /* Trou au milieu : couper en deux */
+            spare->start = end;
+            spare->end = vma->end;
+            spare->flags = vma->flags;
+            spare->next = vma->next;
+            vma->end = start;
+            vma->next = spare;
+            spare = NULL;
+            break;
+        } else if (start <= vma->start) {
+            vma->start = end;
+            link = &vma->next;
+        } else {
+            vma->end = start;
+            link = &vma->next;
+        }
+    }
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+
+    while (removed != NULL) {
+        vma_t* next = removed->next;
+        kfree(removed);
+        removed = next;
+    }
+    if (spare != NULL) {
+        kfree(spare);
+    }
+
+    return 0;
+}
+
+uint64_t vma_find_free(page_directory_t* dir, uint64_t base, uint64_t limit, uint64_t size)
+{
+    if (dir == NULL || size == 0) {
+        return 0;
+    }
+
+    size = PAGE_ALIGN_UP(size);
+    uint64_t candidate = PAGE_ALIGN_UP(base);
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    /* Liste triée : sauter derrière chaque VMA qui chevauche le candidat */
+    for (vma_t* vma = dir->vmas; vma != NULL; vma = vma->next) {
+        if (vma->end <= candidate) {
+            continue;
+        }
+        if (vma->start >= candidate + size) {
+            break;
+        }
+        candidate = vma->end;
+    }
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+
+    if (candidate + size < candidate || candidate + size > limit) {
+        return 0;
+    }
+    return candidate;
+}
+
+vma_t* vma_find(page_directory_t* dir, uint64_t addr)
+{
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+    vma_t* vma = vma_find_locked(dir, addr);
+    spinlock_irqrestore(&vma_lock, irq_flags);
+
+    return vma;
+}
+
+int vma_populate(page_directory_t* dir, uint64_t addr)
+{
+    if (dir == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    int result = -1;
+    vma_t* vma = vma_find_locked(dir, addr);
+    if (vma != NULL) {
+        result = vma_populate_locked(dir, vma, addr);
+    }
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+    return result;
+}
+
+int vma_handle_fault(page_directory_t* dir, uint64_t fault_addr, uint64_t error_code)
+{
+    if (dir == NULL) {
+        return -1;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+        int result = -1;
+        bool allowed = false;
+        vma_t* vma = vma_find_locked(dir, fault_addr);
+        if (vma != NULL) {
+            bool write = (error_code & 0x2) != 0;
+            bool user = (error_code & 0x4) != 0;
+
+            /* Accès incompatible avec la VMA : fault réel */
+            allowed = (!write || (vma->flags & PAGE_RW)) && (!user || (vma->flags & PAGE_USER));
+            if (allowed) {
+                result = vma_populate_locked(dir, vma, fault_addr);
+            }
+        }
+
+        spinlock_irqrestore(&vma_lock, irq_flags);
+
+        if (result == 0 || !allowed) {
+            return result;
+        }
+
+        /* Plus de frame libre : reprendre des pages au balloon, sinon
+         * compresser des pages froides, et réessayer */
+        if (virtio_balloon_deflate(ZRAM_RECLAIM_BATCH) == 0) {
+            vma_reclaim(ZRAM_RECLAIM_BATCH, ZRAM_SCAN_BUDGET);
+        }
+    }
+
+    return -1;
+}
+
+int vma_copy_all(page_directory_t* dst, page_directory_t* src)
+{
+    if (dst == NULL || src == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    int result = 0;
+    vma_t** link = &dst->vmas;
+    for (vma_t* vma = src->vmas; vma != NULL; vma = vma->next) {
+        vma_t* copy = (vma_t*)kmalloc(sizeof(vma_t));
+        if (copy == NULL) {
+            result = -1;
+            break;
+        }
+        copy->start = vma->start;
+        copy->end = vma->end;
+        copy->flags = vma->flags;
+        copy->next = NULL;
+        *link = copy;
+        link = &copy->next;
+    }
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+    return result;
+}
+
+void vma_release_all(page_directory_t* dir)
+{
+    if (dir == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+    vma_t* vma = dir->vmas;
+    dir->vmas = NULL;
+
+    /* Retirer l'espace du scanner de reclaim */
+    page_directory_t** link = &reclaim_list;
+    while (*link != NULL && *link != dir) {
+        link = &(*link)->reclaim_next;
+    }
+    if (*link == dir) {
+        *link = dir->reclaim_next;
+    }
+    if (reclaim_hand == dir) {
+        reclaim_hand = dir->reclaim_next;
+    }
+    dir->reclaim_next = NULL;
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+
+    while (vma != NULL) {
+        for (uint64_t addr = vma->start; addr < vma->end; addr += PAGE_SIZE) {
+            page_release(dir, addr, false);
+        }
+
+        vma_t* next = vma->next;
+        kfree(vma);
+        vma = next;
+    }
+}
+
+void vma_register_directory(page_directory_t* dir)
+{
+    if (dir == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+    dir->reclaim_next = reclaim_list;
+    dir->reclaim_cursor = 0;
+    reclaim_list = dir;
+    spinlock_irqrestore(&vma_lock, irq_flags);
+}
+
+size_t vma_reclaim(size_t target, size_t budget)
+{
+    size_t reclaimed = 0;
+
+    uint64_t irq_flags = spinlock_irqsave(&vma_lock);
+
+    while (reclaimed < target && budget > 0 && reclaim_list != NULL) {
+        if (reclaim_hand == NULL) {
+            reclaim_hand = reclaim_list;
+        }
+
+        page_directory_t* dir = reclaim_hand;
+        if (!reclaim_directory(dir, target, &budget, &reclaimed)) {
+            break;  /* Budget épuisé ou objectif atteint : reprendre ici */
+        }
+
+        /* Espace suivant ; chaque visite consomme du budget */
+        reclaim_hand = dir->reclaim_next;
+        if (budget > 0) {
+            budget--;
+        }
+    }
+
+    spinlock_irqrestore(&vma_lock, irq_flags);
+    return reclaimed;
+}
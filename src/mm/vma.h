@@ -0,0 +1,122 @@
+/* src/mm/vma.h - Virtual Memory Areas (mappings paresseux) */
+#ifndef VMA_H
+#define VMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vmm.h"
+
+/* ========================================
+ * Types
+ * ======================================== */
+
+/*
+ * Une VMA décrit une plage d'adresses réservée dans un espace d'adressage
+ * mais pas forcément adossée à des frames physiques. Les pages sont
+ * allouées et mises à zéro au premier accès (page fault), ou quand le
+ * kernel écrit dedans via vmm_copy_to_dir / vmm_memset_in_dir.
+ *
+ * Les VMAs d'un page_directory_t forment une liste simplement chaînée
+ * triée par adresse, sans chevauchement.
+ */
+typedef struct vma {
+    uint64_t start;         /* Première adresse (alignée sur une page) */
+    uint64_t end;           /* Fin exclusive (alignée sur une page) */
+    uint64_t flags;         /* Flags de page appliqués au mapping (PAGE_RW, PAGE_USER...) */
+    struct vma* next;       /* VMA suivante (adresse croissante) */
+} vma_t;
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+/**
+ * Réserve une plage d'adresses anonyme, allouée à la demande.
+ *
+ * @param dir    Espace d'adressage cible
+ * @param start  Adresse de début (sera alignée vers le bas)
+ * @param size   Taille en octets (la fin sera alignée vers le haut)
+ * @param flags  Flags de page à utiliser lors du mapping
+ * @return 0 si succès, -1 si chevauchement ou plus de mémoire
+ */
+int vma_reserve(page_directory_t* dir, uint64_t start, uint64_t size, uint64_t flags);
+
+/**
+ * Retire une plage d'adresses des VMAs de dir : les VMAs sont raccourcies
+ * ou coupées en deux, et les pages déjà peuplées sont démappées et rendues.
+ *
+ * @param dir    Espace d'adressage cible
+ * @param start  Adresse de début (sera alignée vers le bas)
+ * @param size   Taille en octets (la fin sera alignée vers le haut)
+ * @return 0 si succès, -1 si plus de mémoire
+ */
+int vma_unmap(page_directory_t* dir, uint64_t start, uint64_t size);
+
+/**
+ * Cherche la première plage libre de size octets dans [base, limit).
+ *
+ * @return Adresse de début de la plage, ou 0 si aucune ne convient
+ */
+uint64_t vma_find_free(page_directory_t* dir, uint64_t base, uint64_t limit, uint64_t size);
+
+/**
+ * Trouve la VMA contenant une adresse.
+ *
+ * @return La VMA, ou NULL si l'adresse n'est pas réservée
+ */
+vma_t* vma_find(page_directory_t* dir, uint64_t addr);
+
+/**
+ * Alloue, met à zéro et mappe la page contenant addr si elle appartient
+ * à une VMA et n'est pas encore présente. Une page swappée dans zram est
+ * décompressée au lieu d'être mise à zéro.
+ *
+ * @return 0 si la page est présente au retour, -1 sinon
+ */
+int vma_populate(page_directory_t* dir, uint64_t addr);
+
+/**
+ * Traite un page fault sur une page non présente.
+ * Vérifie que l'accès est compatible avec la VMA (écriture, mode user)
+ * avant de peupler la page.
+ *
+ * @param dir         Espace d'adressage actif au moment du fault
+ * @param fault_addr  Adresse fautive (CR2)
+ * @param error_code  Code d'erreur pushé par le CPU
+ * @return 0 si le fault est résolu, -1 s'il doit être traité comme fatal
+ */
+int vma_handle_fault(page_directory_t* dir, uint64_t fault_addr, uint64_t error_code);
+
+/**
+ * Copie la liste des VMAs de src vers dst (dst doit être vide).
+ * Utilisé par vmm_clone_directory.
+ *
+ * @return 0 si succès, -1 si plus de mémoire
+ */
+int vma_copy_all(page_directory_t* dst, page_directory_t* src);
+
+/**
+ * Libère les frames peuplées (et les slots zram) de toutes les VMAs ainsi
+ * que les VMAs elles-mêmes, et retire dir du scanner de reclaim.
+ * Appelé par vmm_free_directory avant la libération des tables.
+ */
+void vma_release_all(page_directory_t* dir);
+
+/**
+ * Inscrit un espace d'adressage user auprès du scanner de reclaim.
+ * Appelé par vmm_create_directory.
+ */
+void vma_register_directory(page_directory_t* dir);
+
+/**
+ * Compresse dans zram des pages user froides (algorithme de l'horloge
+ * sur le bit Accessed), en reprenant là où la passe précédente s'est
+ * arrêtée.
+ *
+ * @param target  Nombre de pages à libérer
+ * @param budget  Nombre maximal de PTE examinées
+ * @return Nombre de frames rendues au PMM
+ */
+size_t vma_reclaim(size_t target, size_t budget);
+
+#endif /* VMA_H */
@@ -1,9 +1,13 @@
 /* src/mm/vmm.c - Virtual Memory Manager for x86-64 */
 #include "vmm.h"
 #include "pmm.h"
+#include "vma.h"
+#include "zram.h"
 #include "../kernel/console.h"
 #include "../kernel/klog.h"
+#include "../kernel/process.h"
 #include "../arch/x86_64/cpu.h"
+#include "../include/string.h"
 
 /* ========================================
  * Variables globales
@@ -18,6 +22,21 @@ static page_directory_t kernel_directory;
 /* Current page directory */
 static page_directory_t *current_directory = NULL;
 
+/* Pages de 1 GiB supportées (CPUID 0x80000001, EDX bit 26) */
+static bool has_1g_pages = false;
+
+/* PCID : 0 est réservé au kernel_directory, 1..4095 sont distribués aux
+ * autres espaces. Quand ils sont épuisés, on ouvre une nouvelle génération
+ * et chaque espace en reprend un au prochain chargement. */
+#define PCID_COUNT          4096
+static bool pcid_enabled = false;
+static uint64_t pcid_generation = 1;
+static uint32_t pcid_next = 1;
+
+/* Incrémenté quand un mapping partagé par tous les espaces (moitié haute,
+ * PML4[0] MMIO) est retiré : invlpg n'invalide que le PCID courant. */
+static uint64_t shared_tlb_generation = 1;
+
 /* ========================================
  * Fonctions internes
  * ======================================== */
@@ -44,18 +63,8 @@ static inline uint64_t virt_to_phys(void* virt)
  */
 static page_entry_t* alloc_table(void)
 {
-    void* table = pmm_alloc_block();
-    if (table == NULL) {
-        return NULL;
-    }
-    
-    /* Mettre à zéro */
-    uint64_t *p = (uint64_t*)table;
-    for (int i = 0; i < 512; i++) {
-        p[i] = 0;
-    }
-    
-    return (page_entry_t*)table;
+    /* Table vide : pmm_alloc_zeroed puise dans le pool pré-zéroé */
+    return (page_entry_t*)pmm_alloc_zeroed();
 }
 
 /**
@@ -115,6 +124,329 @@ static page_entry_t* get_table(page_entry_t* table, uint64_t index)
     return (page_entry_t*)phys_to_virt(phys);
 }
 
+/**
+ * Trouve l'entrée feuille qui mappe virt : PTE, ou entrée de PD/PDPT
+ * pour une grande page. Ne crée rien.
+ * 
+ * @param page_size  Reçoit la taille de la page mappée par l'entrée
+ * @return L'entrée (présente), ou NULL si virt n'est pas mappée
+ */
+static page_entry_t* get_leaf_entry(page_entry_t* pml4, uint64_t virt, uint64_t* page_size)
+{
+    page_entry_t* pdpt = get_table(pml4, PML4_INDEX(virt));
+    if (pdpt == NULL) return NULL;
+    
+    page_entry_t* entry = &pdpt[PDPT_INDEX(virt)];
+    if ((*entry & PAGE_PRESENT) && (*entry & PAGE_HUGE)) {
+        *page_size = PAGE_SIZE_1G;
+        return entry;
+    }
+    
+    page_entry_t* pd = get_table(pdpt, PDPT_INDEX(virt));
+    if (pd == NULL) return NULL;
+    
+    entry = &pd[PD_INDEX(virt)];
+    if ((*entry & PAGE_PRESENT) && (*entry & PAGE_HUGE)) {
+        *page_size = PAGE_SIZE_2M;
+        return entry;
+    }
+    
+    page_entry_t* pt = get_table(pd, PD_INDEX(virt));
+    if (pt == NULL) return NULL;
+    
+    entry = &pt[PT_INDEX(virt)];
+    if (!(*entry & PAGE_PRESENT)) return NULL;
+    
+    *page_size = PAGE_SIZE;
+    return entry;
+}
+
+/**
+ * Adresse physique correspondant à virt d'après son entrée feuille.
+ */
+static inline uint64_t leaf_to_phys(page_entry_t entry, uint64_t page_size, uint64_t virt)
+{
+    return (entry & PAGE_FRAME_MASK & ~(page_size - 1)) + (virt & (page_size - 1));
+}
+
+/**
+ * Retourne l'entrée de PT d'une page 4 KiB (sans créer de table).
+ * NULL si la page n'est pas mappée ou fait partie d'une grande page.
+ */
+static page_entry_t* get_pte(page_entry_t* pml4, uint64_t virt)
+{
+    uint64_t page_size;
+    page_entry_t* entry = get_leaf_entry(pml4, virt, &page_size);
+    return (entry != NULL && page_size == PAGE_SIZE) ? entry : NULL;
+}
+
+/**
+ * Retourne l'entrée de PT d'une page 4 KiB, même non présente.
+ * NULL si une table intermédiaire manque ou si virt est dans une grande page.
+ */
+static page_entry_t* get_pte_slot(page_entry_t* pml4, uint64_t virt)
+{
+    page_entry_t* pdpt = get_table(pml4, PML4_INDEX(virt));
+    if (pdpt == NULL || (pdpt[PDPT_INDEX(virt)] & PAGE_HUGE)) return NULL;
+    
+    page_entry_t* pd = get_table(pdpt, PDPT_INDEX(virt));
+    if (pd == NULL || (pd[PD_INDEX(virt)] & PAGE_HUGE)) return NULL;
+    
+    page_entry_t* pt = get_table(pd, PD_INDEX(virt));
+    if (pt == NULL) return NULL;
+    
+    return &pt[PT_INDEX(virt)];
+}
+
+/**
+ * Éclate une grande page en une table de pages plus petites qui couvre
+ * la même plage avec les mêmes attributs : 1 GiB -> PD de pages 2 MiB,
+ * 2 MiB -> PT de pages 4 KiB.
+ * 
+ * @param table    PDPT (is_pdpt) ou PD contenant la grande page
+ * @return La nouvelle table, ou NULL si plus de mémoire
+ */
+static page_entry_t* split_huge_entry(page_entry_t* table, uint64_t index, bool is_pdpt)
+{
+    page_entry_t entry = table[index];
+    uint64_t huge_size = is_pdpt ? PAGE_SIZE_1G : PAGE_SIZE_2M;
+    uint64_t step = is_pdpt ? PAGE_SIZE_2M : PAGE_SIZE;
+    
+    page_entry_t* child = alloc_table();
+    if (child == NULL) {
+        return NULL;
+    }
+    
+    /* Dans une PTE, le bit 7 est PAT et non PAGE_HUGE */
+    uint64_t base = entry & PAGE_FRAME_MASK & ~(huge_size - 1);
+    uint64_t attrs = entry & ~PAGE_FRAME_MASK;
+    if (!is_pdpt) {
+        attrs &= ~PAGE_HUGE;
+    }
+    
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        child[i] = (base + (uint64_t)i * step) | attrs;
+    }
+    
+    /* Entrée intermédiaire permissive : les restrictions sont dans les feuilles */
+    table[index] = virt_to_phys(child) | (entry & (PAGE_PRESENT | PAGE_RW | PAGE_USER));
+    
+    return child;
+}
+
+/**
+ * Libère la table pointée par une entrée de PD (un PT) ou de PDPT
+ * (un PD et ses PT), avant de la remplacer par une grande page.
+ */
+static void free_subtree(page_entry_t entry, bool is_pdpt)
+{
+    if (!(entry & PAGE_PRESENT) || (entry & PAGE_HUGE)) {
+        return;
+    }
+    
+    page_entry_t* table = (page_entry_t*)phys_to_virt(entry & PAGE_FRAME_MASK);
+    if (is_pdpt) {
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+            free_subtree(table[i], false);
+        }
+    }
+    free_table(table);
+}
+
+/**
+ * Indique si virt, dans dir, est servi par des tables partagées avec le kernel.
+ */
+static bool is_shared_mapping(page_directory_t* dir, uint64_t virt)
+{
+    uint64_t pml4_idx = PML4_INDEX(virt);
+    
+    return dir == &kernel_directory || pml4_idx >= 256 ||
+           (pml4_idx == 0 && dir->pml4[0] == kernel_directory.pml4[0]);
+}
+
+/**
+ * Propage aux autres PCID l'invalidation d'un mapping de dir.
+ * Un mapping partagé oblige tous les espaces à vider leur PCID au prochain
+ * chargement ; un espace inactif perd simplement le sien.
+ */
+static void tlb_invalidate_others(page_directory_t* dir, bool shared)
+{
+    if (!pcid_enabled) {
+        return;  /* Sans PCID, chaque chargement de CR3 vide déjà le TLB */
+    }
+    
+    if (shared) {
+        shared_tlb_generation++;
+    } else if ((read_cr3() & PAGE_FRAME_MASK) != dir->pml4_phys) {
+        dir->pcid_generation = 0;
+    }
+}
+
+/**
+ * Invalide une page de dir après modification ou retrait de son entrée.
+ */
+static void tlb_invalidate_page(page_directory_t* dir, uint64_t virt)
+{
+    invlpg(virt);
+    tlb_invalidate_others(dir, is_shared_mapping(dir, virt));
+}
+
+/**
+ * Invalide toutes les traductions de dir (tables remplacées, clone COW).
+ */
+static void tlb_flush_directory(page_directory_t* dir)
+{
+    if ((read_cr3() & PAGE_FRAME_MASK) == dir->pml4_phys) {
+        write_cr3(read_cr3());  /* Bit 63 à 0 : vide le PCID courant */
+    }
+    tlb_invalidate_others(dir, dir == &kernel_directory);
+}
+
+/**
+ * Mappe une grande page (2 MiB, ou 1 GiB si is_1g) dans current_directory.
+ * Une table existante à cet endroit est libérée.
+ */
+static int map_huge_page(uint64_t phys, uint64_t virt, uint64_t flags, bool is_1g)
+{
+    page_entry_t* pdpt = get_or_create_table(current_directory->pml4, PML4_INDEX(virt), flags);
+    if (pdpt == NULL) {
+        return -1;
+    }
+    
+    page_entry_t* entry = &pdpt[PDPT_INDEX(virt)];
+    bool is_pdpt = is_1g;
+    if (!is_1g) {
+        if ((*entry & PAGE_PRESENT) && (*entry & PAGE_HUGE) &&
+            split_huge_entry(pdpt, PDPT_INDEX(virt), true) == NULL) {
+            return -1;
+        }
+        page_entry_t* pd = get_or_create_table(pdpt, PDPT_INDEX(virt), flags);
+        if (pd == NULL) {
+            return -1;
+        }
+        entry = &pd[PD_INDEX(virt)];
+    }
+    
+    page_entry_t old = *entry;
+    *entry = phys | (flags & (0xFFF | PAGE_NX)) | PAGE_PRESENT | PAGE_HUGE;
+    
+    if ((old & PAGE_PRESENT) && !(old & PAGE_HUGE)) {
+        /* Remplace une table : vider tout le TLB plutôt que page par page */
+        free_subtree(old, is_pdpt);
+        tlb_flush_directory(current_directory);
+    } else if (old & PAGE_PRESENT) {
+        tlb_invalidate_page(current_directory, virt);
+    }
+    
+    return 0;
+}
+
+/**
+ * Casse le partage d'une page copy-on-write après une écriture.
+ * Si la frame n'a plus qu'un propriétaire, elle redevient simplement
+ * inscriptible ; sinon elle est copiée dans une frame neuve.
+ * 
+ * @return 0 si le fault est résolu, -1 si la page n'est pas COW
+ */
+static int handle_cow_fault(page_directory_t* dir, uint64_t fault_addr)
+{
+    if (dir == NULL) {
+        return -1;
+    }
+    
+    page_entry_t* pte = get_pte(dir->pml4, fault_addr);
+    if (pte == NULL || !(*pte & PAGE_PRESENT) || !(*pte & PAGE_COW)) {
+        return -1;
+    }
+    
+    void* frame = phys_to_virt(*pte & PAGE_FRAME_MASK);
+    if (pmm_get_block_refs(frame) > 1) {
+        void* copy = pmm_alloc_block();
+        if (copy == NULL) {
+            KLOG_ERROR("VMM", "Out of physical memory on copy-on-write");
+            return -1;
+        }
+        memcpy(copy, frame, PAGE_SIZE);
+        *pte = virt_to_phys(copy) | (*pte & ~PAGE_FRAME_MASK);
+        
+        /* Rend notre référence sur la frame partagée */
+        pmm_free_block(frame);
+    }
+    
+    *pte = (*pte | PAGE_RW) & ~PAGE_COW;
+    tlb_invalidate_page(dir, PAGE_ALIGN_DOWN(fault_addr));
+    
+    return 0;
+}
+
+/**
+ * Épingle une page de dir pour une écriture du kernel via le HHDM, qui
+ * ignore la protection de la PTE : peuplée si elle manque dans une VMA,
+ * rendue privée si elle est copy-on-write, puis référencée pour que le
+ * reclaim (qui laisse les frames partagées) ne la rende pas au PMM
+ * pendant l'écriture. Référence à rendre par pmm_free_block.
+ * 
+ * @param fresh Mis à true si la page vient d'être allouée à zéro
+ * @return Adresse physique, 0 si non mappée, hors PMM ou mémoire épuisée
+ */
+static uint64_t pin_writable_in_dir(page_directory_t* dir, uint64_t page_virt, bool* fresh)
+{
+    for (;;) {
+        uint64_t phys = vmm_get_phys_addr(dir, page_virt);
+        
+        if (phys == 0) {
+            /* Une page swappée revient avec son contenu, pas à zéro */
+            *fresh = !(vmm_get_pte_in_dir(dir, page_virt) & PAGE_SWAPPED);
+            if (vma_populate(dir, page_virt) != 0) {
+                return 0;
+            }
+            phys = vmm_get_phys_addr(dir, page_virt);
+        }
+        
+        /* Écrire dans la frame partagée modifierait aussi l'autre espace */
+        if (phys != 0 && (vmm_get_pte_in_dir(dir, page_virt) & PAGE_COW)) {
+            if (handle_cow_fault(dir, page_virt) != 0) {
+                return 0;
+            }
+            phys = vmm_get_phys_addr(dir, page_virt);
+        }
+        if (phys == 0) {
+            return 0;
+        }
+        
+        void* frame = phys_to_virt(phys);
+        bool pinned = (pmm_ref_block(frame) == 0);
+        if (vmm_get_phys_addr(dir, page_virt) == phys) {
+            /* Frame hors PMM ou compteur saturé : pas d'écriture */
+            return pinned ? phys : 0;
+        }
+        
+        /* Page compressée entre la recherche et l'épinglage : recommencer */
+        if (pinned) {
+            pmm_free_block(frame);
+        }
+    }
+}
+
+/**
+ * Retourne l'espace d'adressage actif au moment d'un page fault :
+ * celui du processus propriétaire du thread courant, si c'est bien
+ * lui qui est chargé dans CR3.
+ */
+static page_directory_t* fault_directory(void)
+{
+    thread_t* current = thread_current();
+    if (current == NULL || current->owner == NULL || current->owner->pml4 == NULL) {
+        return NULL;
+    }
+    
+    page_directory_t* dir = (page_directory_t*)current->owner->pml4;
+    if ((read_cr3() & PAGE_FRAME_MASK) != dir->pml4_phys) {
+        return NULL;
+    }
+    return dir;
+}
+
 /* ========================================
  * Fonctions publiques
  * ======================================== */
@@ -137,7 +469,21 @@ void vmm_init(void)
     
     current_directory = &kernel_directory;
     
+    /* Support des pages de 1 GiB pour vmm_map_range */
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000001) {
+        cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+        has_1g_pages = (edx & (1U << 26)) != 0;
+    }
+    
+    /* PCID activé par cpu_init : le kernel garde le PCID 0 (celui de CR3 au boot) */
+    pcid_enabled = cpu_pcid_enabled();
+    kernel_directory.pcid = 0;
+    kernel_directory.shared_tlb_generation = shared_tlb_generation;
+    
     KLOG_INFO_HEX("VMM", "Kernel PML4 phys: ", (uint32_t)kernel_directory.pml4_phys);
+    KLOG_INFO("VMM", has_1g_pages ? "1 GiB pages supported" : "1 GiB pages not supported");
     KLOG_INFO("VMM", "VMM initialized (using Limine paging)");
 }
 
@@ -150,6 +496,33 @@ uint64_t vmm_get_kernel_cr3(void)
     return kernel_directory.pml4_phys;
 }
 
+uint64_t vmm_get_switch_cr3(page_directory_t* dir)
+{
+    if (!pcid_enabled) {
+        return dir->pml4_phys;
+    }
+    
+    bool flush = false;
+    
+    if (dir != &kernel_directory && dir->pcid_generation != pcid_generation) {
+        if (pcid_next >= PCID_COUNT) {
+            pcid_generation++;
+            pcid_next = 1;
+        }
+        dir->pcid = (uint16_t)pcid_next++;
+        dir->pcid_generation = pcid_generation;
+        flush = true;  /* Le PCID a pu servir à un autre espace */
+    }
+    
+    if (dir->shared_tlb_generation != shared_tlb_generation) {
+        dir->shared_tlb_generation = shared_tlb_generation;
+        flush = true;
+    }
+    
+    uint64_t cr3 = dir->pml4_phys | dir->pcid;
+    return flush ? cr3 : (cr3 | CR3_NOFLUSH);
+}
+
 void vmm_map_page(uint64_t phys, uint64_t virt, uint64_t flags)
 {
     /* Aligner les adresses */
@@ -171,12 +544,25 @@ void vmm_map_page(uint64_t phys, uint64_t virt, uint64_t flags)
         return;
     }
     
+    /* Page 4 KiB dans une grande page existante : l'éclater d'abord */
+    if ((pdpt[pdpt_idx] & PAGE_PRESENT) && (pdpt[pdpt_idx] & PAGE_HUGE) &&
+        split_huge_entry(pdpt, pdpt_idx, true) == NULL) {
+        KLOG_ERROR("VMM", "Failed to split 1 GiB page");
+        return;
+    }
+    
     page_entry_t* pd = get_or_create_table(pdpt, pdpt_idx, flags);
     if (pd == NULL) {
         KLOG_ERROR("VMM", "Failed to allocate PD");
         return;
     }
     
+    if ((pd[pd_idx] & PAGE_PRESENT) && (pd[pd_idx] & PAGE_HUGE) &&
+        split_huge_entry(pd, pd_idx, false) == NULL) {
+        KLOG_ERROR("VMM", "Failed to split 2 MiB page");
+        return;
+    }
+    
     page_entry_t* pt = get_or_create_table(pd, pd_idx, flags);
     if (pt == NULL) {
         /* Log une seule fois pour éviter le spam */
@@ -195,10 +581,43 @@ void vmm_map_page(uint64_t phys, uint64_t virt, uint64_t flags)
     /* Mapper la page
      * Note: On garde les flags complets (incluant NX bit 63) pour permettre
      * la protection d'exécution sur les régions MMIO et données. */
+    page_entry_t old = pt[pt_idx];
     pt[pt_idx] = phys | (flags & (0xFFF | PAGE_NX)) | PAGE_PRESENT;
     
-    /* Invalider le TLB */
-    invlpg(virt);
+    /* Invalider le TLB (une entrée non présente n'y est jamais mise en cache) */
+    if (old & PAGE_PRESENT) {
+        tlb_invalidate_page(current_directory, virt);
+    }
+}
+
+int vmm_map_range(uint64_t phys, uint64_t virt, uint64_t size, uint64_t flags)
+{
+    uint64_t end = PAGE_ALIGN_UP(virt + size);
+    phys = PAGE_ALIGN_DOWN(phys);
+    virt = PAGE_ALIGN_DOWN(virt);
+    
+    while (virt < end) {
+        uint64_t remaining = end - virt;
+        uint64_t step;
+        
+        if (has_1g_pages && ((phys | virt) & (PAGE_SIZE_1G - 1)) == 0 &&
+            remaining >= PAGE_SIZE_1G) {
+            if (map_huge_page(phys, virt, flags, true) != 0) return -1;
+            step = PAGE_SIZE_1G;
+        } else if (((phys | virt) & (PAGE_SIZE_2M - 1)) == 0 && remaining >= PAGE_SIZE_2M) {
+            if (map_huge_page(phys, virt, flags, false) != 0) return -1;
+            step = PAGE_SIZE_2M;
+        } else {
+            vmm_map_page(phys, virt, flags);
+            if (vmm_get_physical(virt) != phys) return -1;
+            step = PAGE_SIZE;
+        }
+        
+        phys += step;
+        virt += step;
+    }
+    
+    return 0;
 }
 
 void vmm_unmap_page(uint64_t virt)
@@ -217,9 +636,20 @@ void vmm_unmap_page(uint64_t virt)
     page_entry_t* pdpt = get_table(pml4, pml4_idx);
     if (pdpt == NULL) return;
     
+    /* Page dans une grande page : l'éclater pour ne retirer que 4 KiB */
+    if ((pdpt[pdpt_idx] & PAGE_PRESENT) && (pdpt[pdpt_idx] & PAGE_HUGE) &&
+        split_huge_entry(pdpt, pdpt_idx, true) == NULL) {
+        return;
+    }
+    
     page_entry_t* pd = get_table(pdpt, pdpt_idx);
     if (pd == NULL) return;
     
+    if ((pd[pd_idx] & PAGE_PRESENT) && (pd[pd_idx] & PAGE_HUGE) &&
+        split_huge_entry(pd, pd_idx, false) == NULL) {
+        return;
+    }
+    
     page_entry_t* pt = get_table(pd, pd_idx);
     if (pt == NULL) return;
     
@@ -227,7 +657,32 @@ void vmm_unmap_page(uint64_t virt)
     pt[pt_idx] = 0;
     
     /* Invalider le TLB */
-    invlpg(virt);
+    tlb_invalidate_page(current_directory, virt);
+}
+
+void vmm_unmap_range(uint64_t virt, uint64_t size)
+{
+    uint64_t end = PAGE_ALIGN_UP(virt + size);
+    virt = PAGE_ALIGN_DOWN(virt);
+    
+    while (virt < end) {
+        uint64_t page_size;
+        page_entry_t* entry = get_leaf_entry(current_directory->pml4, virt, &page_size);
+        
+        /* Grande page entièrement couverte : retirer l'entrée d'un coup */
+        if (entry != NULL && page_size > PAGE_SIZE &&
+            (virt & (page_size - 1)) == 0 && end - virt >= page_size) {
+            *entry = 0;
+            tlb_invalidate_page(current_directory, virt);
+            virt += page_size;
+            continue;
+        }
+        
+        if (entry != NULL) {
+            vmm_unmap_page(virt);
+        }
+        virt += PAGE_SIZE;
+    }
 }
 
 int vmm_switch_directory(page_directory_t* dir)
@@ -237,7 +692,7 @@ int vmm_switch_directory(page_directory_t* dir)
     }
     
     current_directory = dir;
-    write_cr3(dir->pml4_phys);
+    write_cr3(vmm_get_switch_cr3(dir));
     
     return 0;
 }
@@ -249,36 +704,22 @@ page_directory_t* vmm_get_directory(void)
 
 uint64_t vmm_get_physical(uint64_t virt)
 {
-    virt = PAGE_ALIGN_DOWN(virt);
-    
-    /* Extraire les index */
-    uint64_t pml4_idx = PML4_INDEX(virt);
-    uint64_t pdpt_idx = PDPT_INDEX(virt);
-    uint64_t pd_idx = PD_INDEX(virt);
-    uint64_t pt_idx = PT_INDEX(virt);
-    
-    /* Traverser les tables */
-    page_entry_t* pml4 = current_directory->pml4;
-    
-    page_entry_t* pdpt = get_table(pml4, pml4_idx);
-    if (pdpt == NULL) return 0;
-    
-    page_entry_t* pd = get_table(pdpt, pdpt_idx);
-    if (pd == NULL) return 0;
-    
-    /* Vérifier si c'est une huge page (2MB) */
-    if (pd[pd_idx] & PAGE_HUGE) {
-        return (pd[pd_idx] & PAGE_FRAME_MASK) + (virt & 0x1FFFFF);
+    uint64_t page_size;
+    page_entry_t* entry = get_leaf_entry(current_directory->pml4, virt, &page_size);
+    if (entry == NULL) {
+        return 0;
     }
     
-    page_entry_t* pt = get_table(pd, pd_idx);
-    if (pt == NULL) return 0;
-    
-    if (!(pt[pt_idx] & PAGE_PRESENT)) {
+    return leaf_to_phys(*entry, page_size, virt);
+}
+
+uint64_t vmm_get_page_size(uint64_t virt)
+{
+    uint64_t page_size;
+    if (get_leaf_entry(current_directory->pml4, virt, &page_size) == NULL) {
         return 0;
     }
-    
-    return (pt[pt_idx] & PAGE_FRAME_MASK) + PAGE_OFFSET(virt);
+    return page_size;
 }
 
 bool vmm_is_mapped(uint64_t virt)
@@ -308,11 +749,12 @@ void vmm_set_user_accessible(uint64_t start, uint64_t size)
             if (pdpt && (pdpt[pdpt_idx] & PAGE_PRESENT)) {
                 pdpt[pdpt_idx] |= PAGE_USER;
                 
-                page_entry_t* pd = get_table(pdpt, pdpt_idx);
+                /* Grande page : l'entrée est la feuille, pas une table */
+                page_entry_t* pd = (pdpt[pdpt_idx] & PAGE_HUGE) ? NULL : get_table(pdpt, pdpt_idx);
                 if (pd && (pd[pd_idx] & PAGE_PRESENT)) {
                     pd[pd_idx] |= PAGE_USER;
                     
-                    page_entry_t* pt = get_table(pd, pd_idx);
+                    page_entry_t* pt = (pd[pd_idx] & PAGE_HUGE) ? NULL : get_table(pd, pd_idx);
                     if (pt && (pt[pt_idx] & PAGE_PRESENT)) {
                         pt[pt_idx] |= PAGE_USER;
                     }
@@ -320,12 +762,24 @@ void vmm_set_user_accessible(uint64_t start, uint64_t size)
             }
         }
         
-        invlpg(addr);
+        tlb_invalidate_page(current_directory, addr);
     }
 }
 
 void vmm_page_fault_handler(uint64_t error_code, uint64_t fault_addr)
 {
+    /* Page non présente : peut-être une VMA pas encore peuplée */
+    if (!(error_code & 0x1)) {
+        if (vma_handle_fault(fault_directory(), fault_addr, error_code) == 0) {
+            return;
+        }
+    } else if (error_code & 0x2) {
+        /* Écriture sur une page présente : peut-être une page copy-on-write */
+        if (handle_cow_fault(fault_directory(), fault_addr) == 0) {
+            return;
+        }
+    }
+    
     /* Get current RSP for debugging */
     uint64_t current_rsp;
     __asm__ volatile("mov %%rsp, %0" : "=r"(current_rsp));
@@ -379,6 +833,12 @@ page_directory_t* vmm_create_directory(void)
     
     dir->pml4 = pml4;
     dir->pml4_phys = virt_to_phys(pml4);
+    dir->vmas = NULL;
+    dir->pcid = 0;
+    dir->pcid_generation = 0;
+    dir->shared_tlb_generation = 0;
+    dir->reclaim_next = NULL;
+    dir->reclaim_cursor = 0;
     
     /* Copier les entrées kernel (higher half: indices 256-511) */
     for (int i = 256; i < 512; i++) {
@@ -392,6 +852,9 @@ page_directory_t* vmm_create_directory(void)
         pml4[0] = kernel_directory.pml4[0];
     }
     
+    /* Rendre l'espace visible du scanner de reclaim (zram) */
+    vma_register_directory(dir);
+    
     KLOG_INFO_HEX("VMM", "Created new PML4 at: ", (uint32_t)dir->pml4_phys);
     
     return dir;
@@ -403,17 +866,24 @@ void vmm_free_directory(page_directory_t* dir)
         return;
     }
     
+    /* Libérer les frames des VMAs (pages user allouées à la demande) */
+    vma_release_all(dir);
+    
     /* Libérer les tables user (indices 0-255) */
     page_entry_t* pml4 = dir->pml4;
     
     for (int i = 0; i < 256; i++) {
         if (!(pml4[i] & PAGE_PRESENT)) continue;
         
+        /* Entrée partagée avec le kernel (MMIO) : ne pas libérer ses tables */
+        if (pml4[i] == kernel_directory.pml4[i]) continue;
+        
         page_entry_t* pdpt = get_table(pml4, i);
         if (pdpt == NULL) continue;
         
         for (int j = 0; j < 512; j++) {
             if (!(pdpt[j] & PAGE_PRESENT)) continue;
+            if (pdpt[j] & PAGE_HUGE) continue; /* Skip 1 GiB pages */
             
             page_entry_t* pd = get_table(pdpt, j);
             if (pd == NULL) continue;
@@ -423,9 +893,16 @@ void vmm_free_directory(page_directory_t* dir)
                 if (pd[k] & PAGE_HUGE) continue; /* Skip huge pages */
                 
                 page_entry_t* pt = get_table(pd, k);
-                if (pt != NULL) {
-                    free_table(pt);
+                if (pt == NULL) continue;
+                
+                /* Références prises par clone_pte hors des VMAs */
+                for (int l = 0; l < 512; l++) {
+                    if ((pt[l] & (PAGE_PRESENT | PAGE_SHARED_REF)) ==
+                        (PAGE_PRESENT | PAGE_SHARED_REF)) {
+                        pmm_free_block(phys_to_virt(pt[l] & PAGE_FRAME_MASK));
+                    }
                 }
+                free_table(pt);
             }
             free_table(pd);
         }
@@ -444,29 +921,13 @@ uint64_t vmm_get_phys_addr(page_directory_t* dir, uint64_t virt_addr)
     
     virt_addr = PAGE_ALIGN_DOWN(virt_addr);
     
-    uint64_t pml4_idx = PML4_INDEX(virt_addr);
-    uint64_t pdpt_idx = PDPT_INDEX(virt_addr);
-    uint64_t pd_idx = PD_INDEX(virt_addr);
-    uint64_t pt_idx = PT_INDEX(virt_addr);
-    
-    page_entry_t* pdpt = get_table(dir->pml4, pml4_idx);
-    if (pdpt == NULL) return 0;
-    
-    page_entry_t* pd = get_table(pdpt, pdpt_idx);
-    if (pd == NULL) return 0;
-    
-    if (pd[pd_idx] & PAGE_HUGE) {
-        return (pd[pd_idx] & PAGE_FRAME_MASK) + (virt_addr & 0x1FFFFF);
-    }
-    
-    page_entry_t* pt = get_table(pd, pd_idx);
-    if (pt == NULL) return 0;
-    
-    if (!(pt[pt_idx] & PAGE_PRESENT)) {
+    uint64_t page_size;
+    page_entry_t* entry = get_leaf_entry(dir->pml4, virt_addr, &page_size);
+    if (entry == NULL) {
         return 0;
     }
     
-    return pt[pt_idx] & PAGE_FRAME_MASK;
+    return leaf_to_phys(*entry, page_size, virt_addr);
 }
 
 int vmm_map_page_in_dir(page_directory_t* dir, uint64_t phys, uint64_t virt, uint64_t flags)
@@ -491,6 +952,145 @@ int vmm_map_page_in_dir(page_directory_t* dir, uint64_t phys, uint64_t virt, uin
     return 0;
 }
 
+uint64_t vmm_get_pte_in_dir(page_directory_t* dir, uint64_t virt)
+{
+    if (dir == NULL) {
+        return 0;
+    }
+    
+    page_entry_t* pte = get_pte_slot(dir->pml4, PAGE_ALIGN_DOWN(virt));
+    return (pte != NULL) ? *pte : 0;
+}
+
+int vmm_set_pte_in_dir(page_directory_t* dir, uint64_t virt, uint64_t entry)
+{
+    if (dir == NULL) {
+        return -1;
+    }
+    
+    virt = PAGE_ALIGN_DOWN(virt);
+    page_entry_t* pte = get_pte_slot(dir->pml4, virt);
+    if (pte == NULL) {
+        return -1;
+    }
+    
+    *pte = entry;
+    tlb_invalidate_page(dir, virt);
+    return 0;
+}
+
+void vmm_unmap_page_in_dir(page_directory_t* dir, uint64_t virt)
+{
+    if (dir == NULL) {
+        return;
+    }
+    
+    page_directory_t* saved = current_directory;
+    current_directory = dir;
+    
+    vmm_unmap_page(virt);
+    
+    current_directory = saved;
+}
+
+/**
+ * Partage une page user entre src et dst lors d'un clone.
+ * Les pages des VMAs (mémoire anonyme) passent en copy-on-write ;
+ * les autres mappings sont recopiés tels quels (PAGE_SHARED_REF si dst
+ * tient une référence sur la frame).
+ */
+static int clone_pte(page_directory_t* src, page_entry_t* src_pte, page_entry_t* dst_pte, uint64_t virt)
+{
+    page_entry_t entry = *src_pte;
+    void* frame = phys_to_virt(entry & PAGE_FRAME_MASK);
+    
+    if (vma_find(src, virt) == NULL) {
+        /* Frame du PMM (segment partagé) : dst en garde une référence,
+         * rendue par vmm_free_directory, pour survivre au détachement
+         * du segment côté src */
+        if (pmm_get_block_refs(frame) > 0) {
+            if (pmm_ref_block(frame) != 0) {
+                return -1;
+            }
+            entry |= PAGE_SHARED_REF;
+        }
+        *dst_pte = entry;
+        return 0;
+    }
+    
+    if (pmm_ref_block(frame) != 0) {
+        /* Compteur saturé : copier la page tout de suite */
+        void* copy = pmm_alloc_block();
+        if (copy == NULL) {
+            return -1;
+        }
+        memcpy(copy, frame, PAGE_SIZE);
+        *dst_pte = virt_to_phys(copy) | (entry & ~PAGE_FRAME_MASK);
+        return 0;
+    }
+    
+    /* Page inscriptible : lecture seule des deux côtés jusqu'à la première écriture */
+    if (entry & (PAGE_RW | PAGE_COW)) {
+        entry = (entry & ~PAGE_RW) | PAGE_COW;
+        *src_pte = entry;
+    }
+    *dst_pte = entry;
+    return 0;
+}
+
+/**
+ * Duplique récursivement une table user (level 3 = PDPT, 2 = PD, 1 = PT).
+ * En cas d'échec, dst_table reste cohérente (partiellement remplie) et
+ * peut être libérée avec vmm_free_directory.
+ */
+static int clone_table(page_directory_t* src, page_entry_t* src_table,
+                       page_entry_t* dst_table, int level, uint64_t base)
+{
+    uint64_t shift = 12 + 9 * (uint64_t)(level - 1);
+    
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        page_entry_t entry = src_table[i];
+        
+        /* Page compressée : les deux espaces partagent le slot zram */
+        if (level == 1 && (entry & PAGE_SWAPPED) && !(entry & PAGE_PRESENT)) {
+            if (zram_dup(ZRAM_PTE_SLOT(entry)) != 0) {
+                return -1;
+            }
+            dst_table[i] = entry;
+            continue;
+        }
+        
+        if (!(entry & PAGE_PRESENT)) continue;
+        
+        uint64_t virt = base + ((uint64_t)i << shift);
+        
+        if (level == 1) {
+            if (clone_pte(src, &src_table[i], &dst_table[i], virt) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        
+        /* Huge page : partagée telle quelle */
+        if (entry & PAGE_HUGE) {
+            dst_table[i] = entry;
+            continue;
+        }
+        
+        page_entry_t* child = alloc_table();
+        if (child == NULL) {
+            return -1;
+        }
+        dst_table[i] = virt_to_phys(child) | (entry & ~PAGE_FRAME_MASK);
+        
+        if (clone_table(src, get_table(src_table, i), child, level - 1, virt) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
 page_directory_t* vmm_clone_directory(page_directory_t* src)
 {
     if (src == NULL) {
@@ -502,10 +1102,33 @@ page_directory_t* vmm_clone_directory(page_directory_t* src)
         return NULL;
     }
     
-    /* Copier les mappings user (indices 0-255) */
-    /* Pour l'instant, copie simple des entrées (pas COW) */
-    for (int i = 0; i < 256; i++) {
-        dst->pml4[i] = src->pml4[i];
+    /* Les VMAs d'abord : vmm_free_directory s'en sert pour rendre les frames */
+    int result = vma_copy_all(dst, src);
+    
+    /* Dupliquer les tables user (indices 0-255), pas les pages */
+    for (int i = 0; i < 256 && result == 0; i++) {
+        if (!(src->pml4[i] & PAGE_PRESENT)) continue;
+        
+        /* Entrée kernel (MMIO) déjà copiée par vmm_create_directory */
+        if (src->pml4[i] == kernel_directory.pml4[i]) continue;
+        
+        page_entry_t* pdpt = alloc_table();
+        if (pdpt == NULL) {
+            result = -1;
+            break;
+        }
+        dst->pml4[i] = virt_to_phys(pdpt) | (src->pml4[i] & ~PAGE_FRAME_MASK);
+        
+        result = clone_table(src, get_table(src->pml4, i), pdpt, 3, (uint64_t)i << 39);
+    }
+    
+    /* Des PTE source sont passées en lecture seule */
+    tlb_flush_directory(src);
+    
+    if (result != 0) {
+        KLOG_ERROR("VMM", "vmm_clone_directory: out of memory");
+        vmm_free_directory(dst);
+        return NULL;
     }
     
     return dst;
@@ -529,7 +1152,8 @@ int vmm_copy_to_dir(page_directory_t* dir, uint64_t dst_virt, const void* src, u
     while (remaining > 0) {
         uint64_t page_virt = PAGE_ALIGN_DOWN(current_virt);
         uint64_t offset = current_virt - page_virt;
-        uint64_t phys = vmm_get_phys_addr(dir, page_virt);
+        bool fresh = false;
+        uint64_t phys = pin_writable_in_dir(dir, page_virt, &fresh);
         
         if (phys == 0) {
             return -1;
@@ -542,6 +1166,7 @@ int vmm_copy_to_dir(page_directory_t* dir, uint64_t dst_virt, const void* src, u
         for (uint64_t i = 0; i < to_copy; i++) {
             dst_ptr[i] = src_ptr[i];
         }
+        pmm_free_block(phys_to_virt(phys));
         
         src_ptr += to_copy;
         current_virt += to_copy;
@@ -566,7 +1191,8 @@ int vmm_memset_in_dir(page_directory_t* dir, uint64_t dst_virt, uint8_t value, u
     while (remaining > 0) {
         uint64_t page_virt = PAGE_ALIGN_DOWN(current_virt);
         uint64_t offset = current_virt - page_virt;
-        uint64_t phys = vmm_get_phys_addr(dir, page_virt);
+        bool fresh = false;
+        uint64_t phys = pin_writable_in_dir(dir, page_virt, &fresh);
         
         KLOG_DEBUG_HEX("VMM", "  page_virt=", (uint32_t)page_virt);
         KLOG_DEBUG_HEX("VMM", "  phys=", (uint32_t)phys);
@@ -583,10 +1209,14 @@ int vmm_memset_in_dir(page_directory_t* dir, uint64_t dst_virt, uint8_t value, u
         KLOG_DEBUG_HEX("VMM", "  virt_ptr (high)=", (uint32_t)((uint64_t)virt_ptr >> 32));
         KLOG_DEBUG_HEX("VMM", "  virt_ptr (low)=", (uint32_t)(uint64_t)virt_ptr);
         
-        uint8_t* dst_ptr = (uint8_t*)virt_ptr + offset;
-        for (uint64_t i = 0; i < to_write; i++) {
-            dst_ptr[i] = value;
+        /* Page tout juste peuplée : elle est déjà à zéro */
+        if (!(fresh && value == 0)) {
+            uint8_t* dst_ptr = (uint8_t*)virt_ptr + offset;
+            for (uint64_t i = 0; i < to_write; i++) {
+                dst_ptr[i] = value;
+            }
         }
+        pmm_free_block(virt_ptr);
         
         current_virt += to_write;
         remaining -= to_write;
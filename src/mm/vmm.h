@@ -24,6 +24,10 @@
 /* Taille d'une page : 4 KiB */
 #define PAGE_SIZE           4096ULL
 
+/* Grandes pages : 2 MiB (entrée de PD) et 1 GiB (entrée de PDPT) */
+#define PAGE_SIZE_2M        (2ULL * 1024 * 1024)
+#define PAGE_SIZE_1G        (1024ULL * 1024 * 1024)
+
 /* Nombre d'entrées par table (512 en 64-bit) */
 #define ENTRIES_PER_TABLE   512
 
@@ -37,6 +41,9 @@
 #define PAGE_DIRTY          (1ULL << 6)   /* Page modifiée (mis par CPU) */
 #define PAGE_HUGE           (1ULL << 7)   /* Page 2MB (PD) ou 1GB (PDPT) */
 #define PAGE_GLOBAL         (1ULL << 8)   /* Page globale */
+#define PAGE_COW            (1ULL << 9)   /* Bit OS : page partagée copy-on-write */
+#define PAGE_SWAPPED        (1ULL << 10)  /* Bit OS : page non présente, compressée dans zram */
+#define PAGE_SHARED_REF     (1ULL << 11)  /* Bit OS : mapping hors VMA hérité d'un clone, tient une référence sur la frame */
 #define PAGE_NX             (1ULL << 63)  /* No-Execute */
 
 /* Masque pour l'adresse physique (bits 12-51) */
@@ -72,10 +79,18 @@
 /* Une entrée de table de pages (64 bits) */
 typedef uint64_t page_entry_t;
 
+struct vma;
+
 /* Structure représentant un espace d'adressage */
-typedef struct {
+typedef struct page_directory {
     uint64_t pml4_phys;     /* Adresse physique du PML4 */
     page_entry_t *pml4;     /* Adresse virtuelle du PML4 (via HHDM) */
+    struct vma *vmas;       /* Plages allouées à la demande (voir vma.h) */
+    uint16_t pcid;          /* PCID courant (valide si pcid_generation est à jour) */
+    uint64_t pcid_generation;       /* Génération d'attribution du PCID (0 = aucun) */
+    uint64_t shared_tlb_generation; /* Mappings partagés vus au dernier chargement */
+    struct page_directory *reclaim_next;    /* Espaces user parcourus par vma_reclaim */
+    uint64_t reclaim_cursor;        /* Prochaine adresse examinée par vma_reclaim */
 } page_directory_t;
 
 /* ========================================
@@ -97,13 +112,43 @@ void vmm_init(void);
  */
 void vmm_map_page(uint64_t phys, uint64_t virt, uint64_t flags);
 
+/**
+ * Mappe une plage physiquement contiguë.
+ * Utilise des pages de 1 GiB (si le CPU les supporte) puis de 2 MiB
+ * partout où phys et virt sont alignés de la même façon, et des pages
+ * de 4 KiB pour le reste.
+ * 
+ * @param phys   Adresse physique de début
+ * @param virt   Adresse virtuelle de début
+ * @param size   Taille en octets (arrondie à la page)
+ * @param flags  Flags des pages (PAGE_HUGE est ajouté automatiquement)
+ * @return 0 si succès, -1 si une table n'a pas pu être allouée
+ */
+int vmm_map_range(uint64_t phys, uint64_t virt, uint64_t size, uint64_t flags);
+
 /**
  * Unmap une page virtuelle.
+ * Si elle fait partie d'une grande page, celle-ci est d'abord éclatée.
  * 
  * @param virt  Adresse virtuelle à unmapper
  */
 void vmm_unmap_page(uint64_t virt);
 
+/**
+ * Unmap une plage, en retirant d'un coup les grandes pages qu'elle
+ * couvre entièrement.
+ * 
+ * @param virt  Adresse virtuelle de début
+ * @param size  Taille en octets
+ */
+void vmm_unmap_range(uint64_t virt, uint64_t size);
+
+/**
+ * Retourne la taille de la page qui mappe virt
+ * (PAGE_SIZE, PAGE_SIZE_2M ou PAGE_SIZE_1G), ou 0 si non mappée.
+ */
+uint64_t vmm_get_page_size(uint64_t virt);
+
 /**
  * Change le PML4 actif (switch de contexte).
  * 
@@ -132,6 +177,9 @@ bool vmm_is_mapped(uint64_t virt);
 
 /**
  * Handler de Page Fault (appelé depuis le handler d'exception).
+ * Un fault sur une page non présente d'une VMA du processus courant
+ * est résolu en allouant la page, une écriture sur une page PAGE_COW
+ * en la copiant ; tout autre fault arrête le système.
  * 
  * @param error_code  Code d'erreur pushé par le CPU
  * @param fault_addr  Adresse fautive (CR2)
@@ -166,6 +214,18 @@ page_directory_t* vmm_create_directory(void);
  */
 uint64_t vmm_get_kernel_cr3(void);
 
+/**
+ * Calcule la valeur de CR3 à charger pour basculer vers dir.
+ * Avec PCID, attribue au besoin un PCID à l'espace et positionne le bit
+ * "no flush" quand ses entrées TLB sont encore valides ; sinon retourne
+ * simplement l'adresse physique du PML4.
+ * Doit être appelé interruptions masquées, juste avant le chargement.
+ * 
+ * @param dir  Espace d'adressage cible
+ * @return Valeur à écrire dans CR3
+ */
+uint64_t vmm_get_switch_cr3(page_directory_t* dir);
+
 /**
  * Libère un Page Directory et toutes ses tables.
  * 
@@ -193,6 +253,30 @@ uint64_t vmm_get_phys_addr(page_directory_t* dir, uint64_t virt_addr);
  */
 int vmm_map_page_in_dir(page_directory_t* dir, uint64_t phys, uint64_t virt, uint64_t flags);
 
+/**
+ * Démappe une page dans un PML4 spécifique (la frame n'est pas libérée).
+ * 
+ * @param dir   Page Directory cible
+ * @param virt  Adresse virtuelle à démapper
+ */
+void vmm_unmap_page_in_dir(page_directory_t* dir, uint64_t virt);
+
+/**
+ * Lit l'entrée de PT d'une page 4 KiB, présente ou non (une entrée
+ * PAGE_SWAPPED n'est pas présente mais n'est pas vide).
+ * 
+ * @return L'entrée, ou 0 si aucune PT ne couvre virt (ou grande page)
+ */
+uint64_t vmm_get_pte_in_dir(page_directory_t* dir, uint64_t virt);
+
+/**
+ * Remplace l'entrée de PT d'une page 4 KiB et invalide le TLB.
+ * La PT doit déjà exister.
+ * 
+ * @return 0 si succès, -1 si aucune PT ne couvre virt
+ */
+int vmm_set_pte_in_dir(page_directory_t* dir, uint64_t virt, uint64_t entry);
+
 /**
  * Retourne le Page Directory du kernel.
  */
@@ -201,6 +285,11 @@ page_directory_t* vmm_get_kernel_directory(void);
 /**
  * Clone un espace d'adressage (pour fork).
  * 
+ * Les tables user sont dupliquées mais pas les pages : les frames des
+ * VMAs sont partagées (référencées dans le PMM) et marquées lecture
+ * seule + PAGE_COW des deux côtés. La première écriture de l'un des
+ * deux espaces copie la page (voir vmm_page_fault_handler).
+ * 
  * @param src  Page Directory source
  * @return Nouveau Page Directory, ou NULL si échec
  */
@@ -213,11 +302,15 @@ bool vmm_is_mapped_in_dir(page_directory_t* dir, uint64_t virt);
 
 /**
  * Copie des données vers un autre espace d'adressage.
+ * Les pages non présentes d'une VMA sont allouées au passage, les pages
+ * copy-on-write copiées avant l'écriture.
  */
 int vmm_copy_to_dir(page_directory_t* dir, uint64_t dst_virt, const void* src, uint64_t size);
 
 /**
  * Met à zéro une plage de mémoire dans un autre espace d'adressage.
+ * Les pages non présentes d'une VMA sont allouées au passage, les pages
+ * copy-on-write copiées avant l'écriture.
  */
 int vmm_memset_in_dir(page_directory_t* dir, uint64_t dst_virt, uint8_t value, uint64_t size);
 
@@ -0,0 +1,303 @@
+/* src/mm/zram.c - Swap compressé en mémoire */
+#include "zram.h"
+#include "pmm.h"
+#include "vma.h"
+#include "kmem_cache.h"
+#include "../kernel/klog.h"
+#include "../kernel/workqueue.h"
+#include "../include/lz.h"
+#include "../include/string.h"
+
+/* Page compressée (refs == 0 : slot libre) */
+typedef struct {
+    void* data;                 /* Données compressées, NULL si page uniforme */
+    uint64_t fill;              /* Motif répété d'une page uniforme */
+    uint16_t length;            /* Taille compressée en octets */
+    uint8_t cls;                /* Classe de taille de data */
+    uint8_t refs;               /* PTE qui référencent le slot */
+    uint32_t next_free;         /* Slot libre suivant (0 = fin) */
+} zram_slot_t;
+
+static zram_slot_t slots[ZRAM_MAX_SLOTS];
+static uint32_t free_head = 0;
+static uint32_t next_unused = 1;    /* Slots jamais utilisés : [next_unused, MAX) */
+
+static kmem_cache_t* classes[ZRAM_CLASS_COUNT];
+static zram_stats_t stats;
+
+/* Tampon et table de hachage du compresseur (zram_lock tenu) */
+static uint8_t compress_buffer[ZRAM_MAX_COMPRESSED];
+static uint16_t compress_table[LZ_HASH_SIZE];
+
+static spinlock_t zram_lock;
+
+/* Scanner armé par le PMM sous ZRAM_LOW_WATERMARK (kswapd_kick) */
+static delayed_work_t kswapd_work;
+static uint32_t kswapd_idle_passes = 0;
+
+/* ========================================
+ * Fonctions internes
+ * ======================================== */
+
+/* Nom "zram-<taille>" d'une classe */
+static void class_name(char* buf, uint32_t size)
+{
+    char digits[8];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + size % 10);
+        size /= 10;
+    } while (size > 0);
+
+    strcpy(buf, "zram-");
+    char* p = buf + 5;
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    *p = '\0';
+}
+
+/**
+ * Page faite d'un seul motif de 64 bits répété ?
+ */
+static bool page_same_filled(const void* page, uint64_t* fill)
+{
+    const uint64_t* p = (const uint64_t*)page;
+    for (size_t i = 1; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+        if (p[i] != p[0]) {
+            return false;
+        }
+    }
+    *fill = p[0];
+    return true;
+}
+
+/* Réserve un slot (zram_lock tenu), 0 si le pool est plein */
+static uint32_t slot_alloc(void)
+{
+    uint32_t slot = free_head;
+    if (slot != 0) {
+        free_head = slots[slot].next_free;
+    } else if (next_unused < ZRAM_MAX_SLOTS) {
+        slot = next_unused++;
+    }
+    return slot;
+}
+
+static void slot_release(uint32_t slot)
+{
+    slots[slot].refs = 0;
+    slots[slot].data = NULL;
+    slots[slot].next_free = free_head;
+    free_head = slot;
+}
+
+static inline bool slot_valid(uint32_t slot)
+{
+    return slot != 0 && slot < ZRAM_MAX_SLOTS && slots[slot].refs != 0;
+}
+
+/**
+ * Passe kswapd : un lot de vma_reclaim par exécution, puis le work se
+ * réarme tant que la mémoire libre reste sous le seuil haut. Le worker
+ * partagé est ainsi rendu entre deux lots.
+ */
+static void kswapd_work_func(void* arg)
+{
+    (void)arg;
+
+    /* Un premier tour d'horloge peut ne faire que vieillir les pages */
+    if (vma_reclaim(ZRAM_RECLAIM_BATCH, ZRAM_SCAN_BUDGET) == 0) {
+        kswapd_idle_passes++;
+    } else {
+        kswapd_idle_passes = 0;
+    }
+
+    if (pmm_get_free_blocks() < ZRAM_HIGH_WATERMARK && kswapd_idle_passes < 4) {
+        kwork_submit_delayed(&kswapd_work, kswapd_work_func, NULL, ZRAM_SCAN_PAUSE_MS);
+        return;
+    }
+    kswapd_idle_passes = 0;
+}
+
+/**
+ * Callback du PMM (mémoire libre sous ZRAM_LOW_WATERMARK, contexte
+ * quelconque) : arme kswapd s'il ne travaille pas déjà.
+ */
+static void kswapd_kick(void)
+{
+    if (!kwork_delayed_pending(&kswapd_work)) {
+        kwork_submit_delayed(&kswapd_work, kswapd_work_func, NULL, 0);
+    }
+}
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+int zram_init(void)
+{
+    for (uint32_t i = 0; i < ZRAM_CLASS_COUNT; i++) {
+        char name[KMEM_CACHE_NAME_MAX];
+        uint32_t size = (i + 1) * ZRAM_CLASS_SIZE;
+        class_name(name, size);
+        classes[i] = kmem_cache_create(name, size, 8, NULL);
+        if (classes[i] == NULL) {
+            KLOG_ERROR("ZRAM", "Failed to create size class");
+            return -1;
+        }
+    }
+
+    if (pmm_register_pressure_hook(ZRAM_LOW_WATERMARK, kswapd_kick) != 0) {
+        KLOG_ERROR("ZRAM", "Failed to register kswapd");
+        return -1;
+    }
+
+    KLOG_INFO_DEC("ZRAM", "Compressed swap ready, slots: ", ZRAM_MAX_SLOTS);
+    return 0;
+}
+
+int zram_store(const void* page, uint32_t* slot_out)
+{
+    if (page == NULL || slot_out == NULL || classes[0] == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&zram_lock);
+
+    uint64_t fill = 0;
+    bool same = page_same_filled(page, &fill);
+    size_t length = 0;
+    void* data = NULL;
+    uint32_t cls = 0;
+
+    if (!same) {
+        length = lz_compress(page, PAGE_SIZE, compress_buffer, ZRAM_MAX_COMPRESSED,
+                             compress_table);
+        if (length == 0) {
+            stats.rejected++;
+            spinlock_irqrestore(&zram_lock, irq_flags);
+            return -1;
+        }
+
+        cls = (uint32_t)((length - 1) / ZRAM_CLASS_SIZE);
+        data = kmem_cache_alloc(classes[cls]);
+        if (data == NULL) {
+            spinlock_irqrestore(&zram_lock, irq_flags);
+            return -1;
+        }
+        memcpy(data, compress_buffer, length);
+    }
+
+    uint32_t slot = slot_alloc();
+    if (slot == 0) {
+        if (data != NULL) {
+            kmem_cache_free(classes[cls], data);
+        }
+        spinlock_irqrestore(&zram_lock, irq_flags);
+        return -1;
+    }
+
+    slots[slot].data = data;
+    slots[slot].fill = fill;
+    slots[slot].length = (uint16_t)length;
+    slots[slot].cls = (uint8_t)cls;
+    slots[slot].refs = 1;
+
+    stats.stored_pages++;
+    stats.swap_outs++;
+    if (same) {
+        stats.same_pages++;
+    } else {
+        stats.compressed_bytes += length;
+        stats.pool_bytes += (uint64_t)(cls + 1) * ZRAM_CLASS_SIZE;
+    }
+
+    spinlock_irqrestore(&zram_lock, irq_flags);
+
+    *slot_out = slot;
+    return 0;
+}
+
+int zram_load(uint32_t slot, void* page)
+{
+    if (page == NULL) {
+        return -1;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&zram_lock);
+
+    if (!slot_valid(slot)) {
+        spinlock_irqrestore(&zram_lock, irq_flags);
+        return -1;
+    }
+
+    int result = 0;
+    zram_slot_t* s = &slots[slot];
+    if (s->data == NULL) {
+        uint64_t* p = (uint64_t*)page;
+        for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+            p[i] = s->fill;
+        }
+    } else if (lz_decompress(s->data, s->length, page, PAGE_SIZE) != (int)PAGE_SIZE) {
+        KLOG_ERROR("ZRAM", "Corrupted compressed page");
+        result = -1;
+    }
+
+    if (result == 0) {
+        stats.swap_ins++;
+    }
+
+    spinlock_irqrestore(&zram_lock, irq_flags);
+    return result;
+}
+
+int zram_dup(uint32_t slot)
+{
+    uint64_t irq_flags = spinlock_irqsave(&zram_lock);
+
+    int result = -1;
+    if (slot_valid(slot) && slots[slot].refs < 255) {
+        slots[slot].refs++;
+        result = 0;
+    }
+
+    spinlock_irqrestore(&zram_lock, irq_flags);
+    return result;
+}
+
+void zram_free(uint32_t slot)
+{
+    uint64_t irq_flags = spinlock_irqsave(&zram_lock);
+
+    if (!slot_valid(slot)) {
+        spinlock_irqrestore(&zram_lock, irq_flags);
+        return;
+    }
+
+    zram_slot_t* s = &slots[slot];
+    if (--s->refs == 0) {
+        stats.stored_pages--;
+        if (s->data == NULL) {
+            stats.same_pages--;
+        } else {
+            stats.compressed_bytes -= s->length;
+            stats.pool_bytes -= (uint64_t)(s->cls + 1) * ZRAM_CLASS_SIZE;
+            kmem_cache_free(classes[s->cls], s->data);
+        }
+        slot_release(slot);
+    }
+
+    spinlock_irqrestore(&zram_lock, irq_flags);
+}
+
+void zram_get_stats(zram_stats_t* out)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    uint64_t irq_flags = spinlock_irqsave(&zram_lock);
+    *out = stats;
+    spinlock_irqrestore(&zram_lock, irq_flags);
+}
@@ -0,0 +1,115 @@
+/* src/mm/zram.h - Swap compressé en mémoire */
+#ifndef ZRAM_H
+#define ZRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "vmm.h"
+
+/*
+ * Quand la mémoire physique manque, le work "kswapd" (et le
+ * page fault handler en dernier recours) compresse les pages user
+ * anonymes froides et les range ici ; la PTE devient non présente avec PAGE_SWAPPED et le
+ * numéro de slot. Le premier accès décompresse la page dans une frame
+ * neuve (vma_populate). Aucune E/S disque : la capacité effective croît du
+ * taux de compression.
+ *
+ * Les données compressées sont rangées par classes de taille
+ * (ZRAM_CLASS_SIZE octets) dans des kmem_cache : plusieurs pages
+ * compressées partagent une même frame. Une page uniforme (souvent des
+ * zéros) ne coûte que son motif. Une page qui ne descend pas sous
+ * ZRAM_MAX_COMPRESSED octets n'est pas swappée.
+ *
+ * Les pages froides sont choisies par vma_reclaim (algorithme de l'horloge
+ * sur le bit Accessed des PTE).
+ */
+
+/* ========================================
+ * Configuration
+ * ======================================== */
+
+/* Pages compressées au maximum (slot 0 réservé) */
+#define ZRAM_MAX_SLOTS          16384
+
+/* Au-delà, la page reste en mémoire (gain trop faible) */
+#define ZRAM_MAX_COMPRESSED     3072
+
+/* Granularité des classes de taille */
+#define ZRAM_CLASS_SIZE         256
+#define ZRAM_CLASS_COUNT        (ZRAM_MAX_COMPRESSED / ZRAM_CLASS_SIZE)
+
+/* kswapd est armé sous LOW_WATERMARK blocs libres et travaille par lots,
+ * espacés de SCAN_PAUSE_MS, jusqu'à HIGH_WATERMARK */
+#define ZRAM_LOW_WATERMARK      2048
+#define ZRAM_HIGH_WATERMARK     4096
+#define ZRAM_SCAN_PAUSE_MS      1
+
+/* Pages swappées par passe du scanner, et PTE examinées au plus */
+#define ZRAM_RECLAIM_BATCH      32
+#define ZRAM_SCAN_BUDGET        1024
+
+/* Entrée de PT d'une page compressée */
+#define ZRAM_PTE(slot)          (((uint64_t)(slot) << 12) | PAGE_SWAPPED)
+#define ZRAM_PTE_SLOT(pte)      ((uint32_t)(((pte) & PAGE_FRAME_MASK) >> 12))
+
+/**
+ * Statistiques (commande meminfo).
+ */
+typedef struct {
+    uint64_t stored_pages;      /* Pages actuellement compressées */
+    uint64_t same_pages;        /* Dont pages uniformes (aucun stockage) */
+    uint64_t compressed_bytes;  /* Taille compressée cumulée */
+    uint64_t pool_bytes;        /* Octets occupés dans les classes */
+    uint64_t swap_outs;         /* Pages compressées depuis le boot */
+    uint64_t swap_ins;          /* Pages décompressées depuis le boot */
+    uint64_t rejected;          /* Pages incompressibles ignorées */
+} zram_stats_t;
+
+/* ========================================
+ * Fonctions publiques
+ * ======================================== */
+
+/**
+ * Crée les classes de taille et enregistre kswapd auprès du PMM (armé
+ * quand la mémoire libre passe sous ZRAM_LOW_WATERMARK).
+ * Appelé une fois le scheduler démarré.
+ *
+ * @return 0 si succès, -1 si échec
+ */
+int zram_init(void);
+
+/**
+ * Compresse une page de 4 KiB dans un nouveau slot (une référence).
+ *
+ * @param page      Page à compresser (adresse kernel)
+ * @param slot_out  Reçoit le numéro de slot
+ * @return 0 si succès, -1 si la page est incompressible ou le pool plein
+ */
+int zram_store(const void* page, uint32_t* slot_out);
+
+/**
+ * Décompresse un slot dans une page de 4 KiB (le slot reste alloué).
+ *
+ * @return 0 si succès, -1 si le slot est invalide ou corrompu
+ */
+int zram_load(uint32_t slot, void* page);
+
+/**
+ * Ajoute une référence à un slot (PTE recopiée par vmm_clone_directory).
+ *
+ * @return 0 si succès, -1 si le slot est invalide ou le compteur saturé
+ */
+int zram_dup(uint32_t slot);
+
+/**
+ * Rend une référence ; le slot est libéré à la dernière.
+ */
+void zram_free(uint32_t slot);
+
+/**
+ * Copie les statistiques courantes.
+ */
+void zram_get_stats(zram_stats_t* stats);
+
+#endif /* ZRAM_H */
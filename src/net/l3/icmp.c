@@ -10,7 +10,7 @@
 #include "../../kernel/klog.h"
 #include "../../kernel/console.h"
 #include "../../kernel/keyboard.h"
-#include "../../kernel/timer.h"
+#include "../../kernel/ktime.h"
 
 /* ========================================
  * Variables globales pour le ping
@@ -95,8 +95,8 @@ void icmp_handle_packet(NetInterface* netif, ethernet_header_t* eth,
                 
                 if (reply_id == g_ping.identifier) {
                     /* Calculer le temps de réponse */
-                    uint64_t now = timer_get_uptime_ms();
-                    g_ping.time = (uint32_t)(now - g_ping.send_time);
+                    uint64_t now = ktime_get_ns();
+                    g_ping.time = (uint32_t)((now - g_ping.send_time) / 1000);
                     g_ping.ttl = ip_hdr->ttl;
                     g_ping.received++;
                     g_ping.waiting = false;
@@ -195,12 +195,25 @@ void icmp_send_echo_request(const uint8_t* dest_ip)
     /* Marquer comme en attente AVANT l'envoi (la réponse peut arriver très vite) */
     g_ping.sent++;
     g_ping.waiting = true;
-    g_ping.send_time = timer_get_uptime_ms();  /* Enregistrer le timestamp d'envoi */
+    g_ping.send_time = ktime_get_ns();  /* Enregistrer le timestamp d'envoi */
     
     ipv4_send_packet(netif, dest_mac, (uint8_t*)dest_ip, IP_PROTO_ICMP,
                      buffer, ICMP_HEADER_SIZE + PING_DATA_SIZE);
 }
 
+/**
+ * Affiche une durée en µs sous la forme "X.YYY" (ms)
+ */
+static void print_rtt(uint32_t us)
+{
+    uint32_t frac = us % 1000;
+    console_put_dec(us / 1000);
+    console_puts(".");
+    if (frac < 100) console_puts("0");
+    if (frac < 10) console_puts("0");
+    console_put_dec(frac);
+}
+
 /**
  * Affiche une ligne de réponse ping
  */
@@ -218,7 +231,7 @@ static void print_ping_reply(void)
     console_puts(" ttl=");
     console_put_dec(g_ping.ttl);
     console_puts(" time=");
-    console_put_dec(g_ping.time);
+    print_rtt(g_ping.time);
     console_puts(" ms\n");
 }
 
@@ -247,11 +260,11 @@ static void print_ping_stats(void)
     /* Afficher les temps si on a reçu des réponses */
     if (g_ping.received > 0) {
         console_puts("rtt min/avg/max = ");
-        console_put_dec(g_ping.min_time);
+        print_rtt(g_ping.min_time);
         console_puts("/");
-        console_put_dec(g_ping.total_time / g_ping.received);
+        print_rtt((uint32_t)(g_ping.total_time / g_ping.received));
         console_puts("/");
-        console_put_dec(g_ping.max_time);
+        print_rtt(g_ping.max_time);
         console_puts(" ms\n");
     }
 }
@@ -62,11 +62,11 @@ typedef struct {
     uint16_t sent;              /* Nombre envoyés */
     uint16_t received;          /* Nombre reçus */
     uint8_t ttl;                /* TTL de la réponse */
-    uint32_t time;              /* Temps de réponse en ms */
-    uint64_t send_time;         /* Timestamp d'envoi (pour calcul RTT) */
-    uint32_t min_time;          /* Temps min */
-    uint32_t max_time;          /* Temps max */
-    uint32_t total_time;        /* Temps total (pour moyenne) */
+    uint32_t time;              /* Temps de réponse en µs */
+    uint64_t send_time;         /* Timestamp d'envoi en ns (ktime, pour le RTT) */
+    uint32_t min_time;          /* Temps min (µs) */
+    uint32_t max_time;          /* Temps max (µs) */
+    uint64_t total_time;        /* Temps total (µs, pour moyenne) */
     bool waiting;               /* Attente d'une réponse */
     bool active;                /* Ping en cours */
 } ping_state_t;
@@ -9,13 +9,19 @@
 #include "../../kernel/timer.h"
 #include "../../kernel/klog.h"
 #include "../../mm/kheap.h"
+#include "../../mm/kmem_cache.h"
 
 /* ===========================================
- * Tableau des sockets TCP (allocation dynamique)
+ * Table des sockets TCP (allocation dynamique)
+ *
+ * La table ne contient que des pointeurs : les sockets viennent de
+ * tcp_socket_cache et ne bougent jamais, même quand la table grandit
+ * (les wait queues et les fd gardent des pointeurs vers eux).
  * =========================================== */
-static tcp_socket_t* tcp_sockets = NULL;
-static int tcp_socket_capacity = 0;  /* Nombre de slots alloués */
+static tcp_socket_t** tcp_sockets = NULL;
+static int tcp_socket_capacity = 0;  /* Nombre de slots de la table */
 static int tcp_socket_count = 0;     /* Nombre de sockets en utilisation */
+static kmem_cache_t* tcp_socket_cache = NULL;
 
 /* ===========================================
  * Fonctions utilitaires locales
@@ -161,9 +167,16 @@ static void tcp_init_socket(tcp_socket_t* sock)
     wait_queue_init(&sock->accept_waitqueue);
 }
 
+/* Constructeur de tcp_socket_cache */
+static void tcp_socket_ctor(void* obj)
+{
+    tcp_init_socket((tcp_socket_t*)obj);
+}
+
 /**
- * Agrandit le tableau de sockets si nécessaire.
- * Double la capacité jusqu'à TCP_MAX_SOCKETS.
+ * Agrandit la table de sockets si nécessaire.
+ * Double la capacité jusqu'à TCP_MAX_SOCKETS ; les nouveaux slots sont
+ * vides, les sockets étant alloués à la demande.
  * 
  * @return true si succès, false si échec ou limite atteinte
  */
@@ -183,25 +196,25 @@ static bool tcp_grow_sockets(void)
         new_capacity = TCP_INITIAL_SOCKETS;
     }
     
-    /* Allouer le nouveau tableau */
-    tcp_socket_t* new_sockets = (tcp_socket_t*)kmalloc(new_capacity * sizeof(tcp_socket_t));
+    /* Allouer la nouvelle table */
+    tcp_socket_t** new_sockets = (tcp_socket_t**)kmalloc(new_capacity * sizeof(tcp_socket_t*));
     if (new_sockets == NULL) {
-        KLOG_ERROR("TCP", "Failed to allocate socket array");
+        KLOG_ERROR("TCP", "Failed to allocate socket table");
         return false;
     }
     
-    /* Copier les sockets existants */
+    /* Copier les pointeurs existants */
     if (tcp_sockets != NULL && tcp_socket_capacity > 0) {
         for (int i = 0; i < tcp_socket_capacity; i++) {
             new_sockets[i] = tcp_sockets[i];
         }
-        /* Libérer l'ancien tableau */
+        /* Libérer l'ancienne table */
         kfree(tcp_sockets);
     }
     
-    /* Initialiser les nouveaux slots */
+    /* Les nouveaux slots sont vides */
     for (int i = tcp_socket_capacity; i < new_capacity; i++) {
-        tcp_init_socket(&new_sockets[i]);
+        new_sockets[i] = NULL;
     }
     
     tcp_sockets = new_sockets;
@@ -221,7 +234,13 @@ void tcp_init(void)
 {
     KLOG_INFO("TCP", "Initializing TCP stack...");
     
-    /* Allocation initiale des sockets */
+    tcp_socket_cache = kmem_cache_create("tcp_socket", sizeof(tcp_socket_t), 0, tcp_socket_ctor);
+    if (tcp_socket_cache == NULL) {
+        KLOG_ERROR("TCP", "Failed to create socket cache!");
+        return;
+    }
+    
+    /* Allocation initiale de la table */
     tcp_sockets = NULL;
     tcp_socket_capacity = 0;
     tcp_socket_count = 0;
@@ -231,7 +250,7 @@ void tcp_init(void)
         return;
     }
     
-    KLOG_INFO_DEC("TCP", "Initial sockets allocated: ", tcp_socket_capacity);
+    KLOG_INFO_DEC("TCP", "Initial socket slots: ", tcp_socket_capacity);
 }
 
 /* ===========================================
@@ -239,33 +258,57 @@ void tcp_init(void)
  * =========================================== */
 
 /**
- * Trouve un slot de socket libre.
- * Agrandit le tableau si nécessaire.
+ * Prend un socket libre sans agrandir la table : un socket fermé est
+ * réutilisé tel quel, sinon un slot vide reçoit un socket neuf (déjà
+ * construit) de tcp_socket_cache.
  */
-static tcp_socket_t* tcp_alloc_socket(void)
+static tcp_socket_t* tcp_take_free_socket(void)
 {
-    /* Chercher un slot libre dans le tableau existant */
+    int empty_slot = -1;
+    
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (!tcp_sockets[i].in_use) {
-            tcp_sockets[i].in_use = true;
+        tcp_socket_t* sock = tcp_sockets[i];
+        if (sock == NULL) {
+            if (empty_slot < 0) {
+                empty_slot = i;
+            }
+            continue;
+        }
+        if (!sock->in_use) {
+            sock->in_use = true;
             tcp_socket_count++;
-            return &tcp_sockets[i];
+            return sock;
         }
     }
     
-    /* Pas de slot libre - essayer d'agrandir le tableau */
-    if (tcp_grow_sockets()) {
-        /* Réessayer l'allocation après agrandissement */
-        for (int i = 0; i < tcp_socket_capacity; i++) {
-            if (!tcp_sockets[i].in_use) {
-                tcp_sockets[i].in_use = true;
-                tcp_socket_count++;
-                return &tcp_sockets[i];
-            }
-        }
+    if (empty_slot < 0) {
+        return NULL;
     }
     
-    return NULL;
+    tcp_socket_t* sock = (tcp_socket_t*)kmem_cache_alloc(tcp_socket_cache);
+    if (sock == NULL) {
+        return NULL;
+    }
+    tcp_sockets[empty_slot] = sock;
+    sock->in_use = true;
+    tcp_socket_count++;
+    return sock;
+}
+
+/**
+ * Trouve un slot de socket libre.
+ * Agrandit la table si nécessaire.
+ */
+static tcp_socket_t* tcp_alloc_socket(void)
+{
+    tcp_socket_t* sock = tcp_take_free_socket();
+    
+    /* Pas de slot libre - essayer d'agrandir la table */
+    if (sock == NULL && tcp_grow_sockets()) {
+        sock = tcp_take_free_socket();
+    }
+    
+    return sock;
 }
 
 /**
@@ -275,10 +318,10 @@ static tcp_socket_t* tcp_alloc_socket(void)
 static tcp_socket_t* tcp_find_listening_socket(uint16_t port)
 {
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (tcp_sockets[i].in_use && 
-            tcp_sockets[i].local_port == port &&
-            tcp_sockets[i].state == TCP_STATE_LISTEN) {
-            return &tcp_sockets[i];
+        if (tcp_sockets[i] != NULL && tcp_sockets[i]->in_use && 
+            tcp_sockets[i]->local_port == port &&
+            tcp_sockets[i]->state == TCP_STATE_LISTEN) {
+            return tcp_sockets[i];
         }
     }
     return NULL;
@@ -292,10 +335,10 @@ static tcp_socket_t* tcp_find_listening_socket(uint16_t port)
 tcp_socket_t* tcp_find_ready_client(uint16_t local_port)
 {
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (tcp_sockets[i].in_use && 
-            tcp_sockets[i].local_port == local_port &&
-            tcp_sockets[i].state == TCP_STATE_ESTABLISHED) {
-            return &tcp_sockets[i];
+        if (tcp_sockets[i] != NULL && tcp_sockets[i]->in_use && 
+            tcp_sockets[i]->local_port == local_port &&
+            tcp_sockets[i]->state == TCP_STATE_ESTABLISHED) {
+            return tcp_sockets[i];
         }
     }
     return NULL;
@@ -308,8 +351,8 @@ tcp_socket_t* tcp_find_ready_client(uint16_t local_port)
 static tcp_socket_t* tcp_find_socket_by_local_port(uint16_t port)
 {
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (tcp_sockets[i].in_use && tcp_sockets[i].local_port == port) {
-            return &tcp_sockets[i];
+        if (tcp_sockets[i] != NULL && tcp_sockets[i]->in_use && tcp_sockets[i]->local_port == port) {
+            return tcp_sockets[i];
         }
     }
     return NULL;
@@ -321,15 +364,15 @@ static tcp_socket_t* tcp_find_socket_by_local_port(uint16_t port)
 static tcp_socket_t* tcp_find_socket(uint16_t local_port, uint8_t* remote_ip, uint16_t remote_port)
 {
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (!tcp_sockets[i].in_use) continue;
+        if (tcp_sockets[i] == NULL || !tcp_sockets[i]->in_use) continue;
         
-        if (tcp_sockets[i].local_port == local_port &&
-            tcp_sockets[i].remote_port == remote_port &&
-            tcp_sockets[i].remote_ip[0] == remote_ip[0] &&
-            tcp_sockets[i].remote_ip[1] == remote_ip[1] &&
-            tcp_sockets[i].remote_ip[2] == remote_ip[2] &&
-            tcp_sockets[i].remote_ip[3] == remote_ip[3]) {
-            return &tcp_sockets[i];
+        if (tcp_sockets[i]->local_port == local_port &&
+            tcp_sockets[i]->remote_port == remote_port &&
+            tcp_sockets[i]->remote_ip[0] == remote_ip[0] &&
+            tcp_sockets[i]->remote_ip[1] == remote_ip[1] &&
+            tcp_sockets[i]->remote_ip[2] == remote_ip[2] &&
+            tcp_sockets[i]->remote_ip[3] == remote_ip[3]) {
+            return tcp_sockets[i];
         }
     }
     return NULL;
@@ -964,9 +1007,9 @@ int tcp_bind(tcp_socket_t* sock, uint16_t port)
     
     /* Vérifier si le port est déjà utilisé par un autre socket */
     for (int i = 0; i < tcp_socket_capacity; i++) {
-        if (tcp_sockets[i].in_use && 
-            &tcp_sockets[i] != sock &&
-            tcp_sockets[i].local_port == port) {
+        if (tcp_sockets[i] != NULL && tcp_sockets[i]->in_use && 
+            tcp_sockets[i] != sock &&
+            tcp_sockets[i]->local_port == port) {
             KLOG_ERROR_DEC("TCP", "Port already bound: ", port);
             return -1;
         }
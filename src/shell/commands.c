@@ -3,6 +3,7 @@
 #include "../arch/x86_64/usermode.h"
 #include "../config/config.h"
 #include "../drivers/pci.h"
+#include "../drivers/virtio/virtio_balloon.h"
 #include "../fs/vfs.h"
 #include "../include/string.h"
 #include "../kernel/console.h"
@@ -14,6 +15,10 @@
 #include "../kernel/thread.h"
 #include "../kernel/workqueue.h"
 #include "../mm/kheap.h"
+#include "../mm/kheap_prof.h"
+#include "../mm/kmem_cache.h"
+#include "../mm/pmm.h"
+#include "../mm/zram.h"
 #include "../net/core/netdev.h"
 #include "../net/l3/icmp.h"
 #include "../net/l4/http.h"
@@ -49,6 +54,7 @@ static int cmd_mkdir(int argc, char **argv);
 static int cmd_touch(int argc, char **argv);
 static int cmd_echo(int argc, char **argv);
 static int cmd_meminfo(int argc, char **argv);
+static int cmd_heapprof(int argc, char **argv);
 static int cmd_rm(int argc, char **argv);
 static int cmd_rmdir(int argc, char **argv);
 static int cmd_threads(int argc, char **argv);
@@ -98,6 +104,8 @@ static shell_command_t commands[] = {
     {"touch", "Create an empty file", cmd_touch},
     {"echo", "Display a message", cmd_echo},
     {"meminfo", "Display memory information", cmd_meminfo},
+    {"heapprof", "Heap allocation profiler (heapprof on|off|top|leaks|hist)",
+     cmd_heapprof},
     {"rm", "Remove a file", cmd_rm},
     {"rmdir", "Remove an empty directory", cmd_rmdir},
     {"wget", "Download a file via HTTP", cmd_wget},
@@ -1341,6 +1349,51 @@ static int cmd_meminfo(int argc, char **argv) {
   console_put_dec((int)(blocks - free_blocks));
   console_puts("\n");
 
+  /* Slab allocator (petites allocations) */
+  console_puts("\n  Slab Pages:         ");
+  console_put_dec((int)(kheap_get_slab_total_size() / 1024));
+  console_puts(" KB\n");
+  console_puts("  Class   Slabs   Used / Total\n");
+  for (size_t i = 0; i < kheap_get_slab_class_count(); i++) {
+    kheap_slab_stats_t st;
+    if (kheap_get_slab_stats(i, &st) != 0) {
+      continue;
+    }
+    console_puts("  ");
+    console_put_dec((int)st.object_size);
+    console_puts(st.object_size < 100 ? "      " : (st.object_size < 1000 ? "     " : "    "));
+    console_put_dec((int)st.slab_count);
+    console_puts("       ");
+    console_put_dec((int)st.objects_used);
+    console_puts(" / ");
+    console_put_dec((int)st.objects_total);
+    console_puts("\n");
+  }
+
+  /* Caches d'objets typés */
+  if (kmem_cache_count() > 0) {
+    console_puts("\n  Cache           Size   Slabs   Used / Total\n");
+    for (size_t i = 0; i < kmem_cache_count(); i++) {
+      kmem_cache_stats_t st;
+      if (kmem_cache_get_stats(i, &st) != 0) {
+        continue;
+      }
+      console_puts("  ");
+      console_puts(st.name);
+      for (size_t len = strlen(st.name); len < 16; len++) {
+        console_puts(" ");
+      }
+      console_put_dec((int)st.object_size);
+      console_puts(st.object_size < 10 ? "      " : (st.object_size < 100 ? "     " : (st.object_size < 1000 ? "    " : "   ")));
+      console_put_dec((int)st.slab_count);
+      console_puts(st.slab_count < 10 ? "       " : (st.slab_count < 100 ? "      " : "     "));
+      console_put_dec((int)st.objects_used);
+      console_puts(" / ");
+      console_put_dec((int)st.objects_total);
+      console_puts("\n");
+    }
+  }
+
   /* Pourcentage d'utilisation */
   console_puts("\n");
   if (total > 0) {
@@ -1350,6 +1403,62 @@ static int cmd_meminfo(int argc, char **argv) {
     console_puts("%\n");
   }
 
+  /* Mémoire physique (buddy allocator) */
+  console_puts("\n  Physical Free:      ");
+  console_put_dec((int)(pmm_get_free_memory() / 1024));
+  console_puts(" KB\n");
+  console_puts("  Zeroed Pool:        ");
+  console_put_dec((int)pmm_get_zeroed_count());
+  console_puts(" pages\n");
+
+  /* Swap compressé */
+  zram_stats_t zs;
+  zram_get_stats(&zs);
+  console_puts("  Zram Pages:         ");
+  console_put_dec((int)zs.stored_pages);
+  console_puts(" (");
+  console_put_dec((int)zs.same_pages);
+  console_puts(" same-filled)\n");
+  console_puts("  Zram Pool:          ");
+  console_put_dec((int)(zs.pool_bytes / 1024));
+  console_puts(" KB for ");
+  console_put_dec((int)((zs.stored_pages - zs.same_pages) * 4));
+  console_puts(" KB\n");
+  console_puts("  Zram Out/In:        ");
+  console_put_dec((int)zs.swap_outs);
+  console_puts("/");
+  console_put_dec((int)zs.swap_ins);
+  console_puts(" (");
+  console_put_dec((int)zs.rejected);
+  console_puts(" rejected)\n");
+
+  /* Balloon VirtIO */
+  virtio_balloon_stats_t bs;
+  virtio_balloon_get_stats(&bs);
+  if (bs.present) {
+    console_puts("  Balloon:            ");
+    console_put_dec((int)(bs.actual_pages * 4));
+    console_puts(" KB (target ");
+    console_put_dec((int)(bs.target_pages * 4));
+    console_puts(" KB)\n");
+    if (bs.reporting) {
+      console_puts("  Reported Free:      ");
+      console_put_dec((int)(bs.reported * 4));
+      console_puts(" KB\n");
+    }
+  }
+  console_puts("  Order   Pages   Free\n");
+  for (uint32_t order = 0; order < PMM_BUDDY_ORDER_COUNT; order++) {
+    int pages = 1 << order;
+    console_puts("  ");
+    console_put_dec((int)order);
+    console_puts(order < 10 ? "       " : "      ");
+    console_put_dec(pages);
+    console_puts(pages < 10 ? "       " : (pages < 100 ? "      " : (pages < 1000 ? "     " : "    ")));
+    console_put_dec((int)pmm_get_free_count_by_order(order));
+    console_puts("\n");
+  }
+
   console_set_color(VGA_COLOR_LIGHT_CYAN, VGA_COLOR_BLACK);
   console_puts("\n============================================\n");
   console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
@@ -1357,6 +1466,151 @@ static int cmd_meminfo(int argc, char **argv) {
   return 0;
 }
 
+/* ========================================
+ * Commande heapprof - Profiler du kernel heap
+ * ======================================== */
+
+/* Nombre de lignes affichées par heapprof top / leaks */
+#define HEAPPROF_MAX_LINES 10
+
+static void heapprof_print_summary(void) {
+  kheap_prof_summary_t sum;
+  kheap_prof_get_summary(&sum);
+
+  console_puts("  Profiler:           ");
+  console_puts(kheap_prof_active ? "on\n" : "off\n");
+  console_puts("  Live allocations:   ");
+  console_put_dec((uint32_t)sum.live_count);
+  console_puts(" (");
+  console_put_dec((uint32_t)(sum.live_bytes / 1024));
+  console_puts(" KB)\n");
+  console_puts("  Allocations seen:   ");
+  console_put_dec((uint32_t)sum.total_allocs);
+  console_puts("\n");
+  if (sum.dropped > 0) {
+    console_set_color(VGA_COLOR_YELLOW, VGA_COLOR_BLACK);
+    console_puts("  Not tracked (full): ");
+    console_put_dec((uint32_t)sum.dropped);
+    console_puts("\n");
+    console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+  }
+}
+
+static void heapprof_print_top(void) {
+  kheap_prof_site_t sites[HEAPPROF_MAX_LINES];
+  size_t count = kheap_prof_top_sites(sites, HEAPPROF_MAX_LINES);
+
+  console_puts("\n  Caller              Live bytes   Live   Total\n");
+  for (size_t i = 0; i < count; i++) {
+    console_puts("  ");
+    console_put_hex64(sites[i].caller);
+    console_puts("  ");
+    console_put_dec((uint32_t)sites[i].live_bytes);
+    console_puts("   ");
+    console_put_dec(sites[i].live_count);
+    console_puts("   ");
+    console_put_dec(sites[i].total_count);
+    console_puts("\n");
+  }
+  if (count == 0) {
+    console_puts("  (no live allocations tracked)\n");
+  }
+}
+
+static void heapprof_print_leaks(uint64_t min_age_ms) {
+  kheap_prof_alloc_t allocs[HEAPPROF_MAX_LINES];
+  size_t count = kheap_prof_leak_candidates(allocs, HEAPPROF_MAX_LINES, min_age_ms);
+
+  console_puts("\n  Oldest live allocations (age >= ");
+  console_put_dec((uint32_t)(min_age_ms / 1000));
+  console_puts(" s)\n");
+  console_puts("  Address             Caller              Size   Age (s)\n");
+  for (size_t i = 0; i < count; i++) {
+    console_puts("  ");
+    console_put_hex64(allocs[i].ptr);
+    console_puts("  ");
+    console_put_hex64(allocs[i].caller);
+    console_puts("  ");
+    console_put_dec((uint32_t)allocs[i].size);
+    console_puts("   ");
+    console_put_dec((uint32_t)(allocs[i].age_ms / 1000));
+    console_puts("\n");
+  }
+  if (count == 0) {
+    console_puts("  (none)\n");
+  }
+}
+
+static void heapprof_print_hist(void) {
+  uint64_t buckets[KHEAP_PROF_HIST_BUCKETS];
+  kheap_prof_get_histogram(buckets);
+
+  console_puts("\n  Size >=     Allocations\n");
+  for (uint32_t i = 0; i < KHEAP_PROF_HIST_BUCKETS; i++) {
+    uint32_t size = 1u << i;
+    console_puts("  ");
+    console_put_dec(size);
+    /* Aligner la colonne suivante (largeur 12) */
+    uint32_t digits = 1;
+    for (uint32_t v = size; v >= 10; v /= 10) {
+      digits++;
+    }
+    for (uint32_t pad = digits; pad < 12; pad++) {
+      console_puts(" ");
+    }
+    console_put_dec((uint32_t)buckets[i]);
+    console_puts("\n");
+  }
+}
+
+static int cmd_heapprof(int argc, char **argv) {
+  if (argc < 2) {
+    console_puts("Usage: heapprof <on|off|top|leaks [seconds]|hist>\n");
+    console_puts("\nCommands:\n");
+    console_puts("  heapprof on            - Reset tables and start tracking\n");
+    console_puts("  heapprof off           - Stop tracking (tables are kept)\n");
+    console_puts("  heapprof top           - Callers holding the most memory\n");
+    console_puts("  heapprof leaks [sec]   - Oldest live allocations (default 10 s)\n");
+    console_puts("  heapprof hist          - Histogram of requested sizes\n");
+    return -1;
+  }
+
+  const char *cmd = argv[1];
+
+  if (strcmp(cmd, "on") == 0) {
+    kheap_prof_enable();
+    console_puts("Heap profiler enabled\n");
+    return 0;
+  }
+  if (strcmp(cmd, "off") == 0) {
+    kheap_prof_disable();
+    console_puts("Heap profiler disabled\n");
+    return 0;
+  }
+
+  console_puts("\n");
+  heapprof_print_summary();
+
+  if (strcmp(cmd, "top") == 0) {
+    heapprof_print_top();
+  } else if (strcmp(cmd, "leaks") == 0) {
+    int seconds = (argc >= 3) ? atoi(argv[2]) : 10;
+    if (seconds < 0) {
+      seconds = 0;
+    }
+    heapprof_print_leaks((uint64_t)seconds * 1000);
+  } else if (strcmp(cmd, "hist") == 0) {
+    heapprof_print_hist();
+  } else {
+    console_set_color(VGA_COLOR_LIGHT_RED, VGA_COLOR_BLACK);
+    console_puts("heapprof: unknown command\n");
+    console_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
+    return -1;
+  }
+
+  return 0;
+}
+
 /* ========================================
  * Commande rm - Supprimer un fichier
  * ======================================== */